@@ -0,0 +1,120 @@
+/**
+ * @brief Sensor array throughput vs number of buses: MLX90393_SCHED_MAX_DEVICES simulated sensors
+ * per bus, one worker thread per bus, every sample pushed into the merged MPSC queue and drained by
+ * a consumer thread. wall_sps is the host-side rate of the whole pipeline (driver, scheduler,
+ * simulator, queue); samples that found the queue full are reported as dropped.
+ *
+ * mode cpu: the simulated buses never sleep, so this measures CPU cost and contention, not bus time.
+ * mode sleep: every bus udelay also sleeps for real, like a worker waiting on a real sensor, so the
+ * buses overlap their conversion waits and the rows show how the array scales with bus time.
+ */
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "MLX90393.h"
+#include "MLX90393_array.h"
+#include "MLX90393_sim.h"
+
+#define ROUNDS 2000
+#define SLEEP_ROUNDS 200 //Tconv = 3 ms: ~0.6 s of wall time per row
+#define DEVS (MLX90393_ARRAY_MAX_BUSES * MLX90393_SCHED_MAX_DEVICES)
+
+static mlx_i2c_t devs[DEVS];
+static mlx_sim_t sims[DEVS];
+static mlx_cfg_t settings[DEVS];
+static mlx_mpsc_cell_t cells[65536];
+static mlx_mpsc_t merged;
+static atomic_uchar producing;
+static uint64_t consumed;
+
+static double now_s(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+//Real-sleep udelay: advance the virtual clock of the simulator and take the same wall time
+static void sleep_udelay(uint32_t us){
+    struct timespec ts = { .tv_sec = us / 1000000, .tv_nsec = (long) (us % 1000000) * 1000 };
+    MLX90393_SimUdelay(us);
+    nanosleep(&ts, NULL);
+}
+
+static void *consumer(void *arg){
+    mlx_array_item_t item;
+    uint64_t n = 0;
+    while(1){
+        if(MLX90393_MpscPop(&merged, &item) == 0){
+            n++;
+        } else if(!atomic_load_explicit(&producing, memory_order_acquire)){
+            if(MLX90393_MpscPop(&merged, &item) != 0){ //Nothing was pushed after the workers stopped
+                break;
+            }
+            n++;
+        } else {
+            sched_yield();
+        }
+    }
+    consumed = n;
+    return NULL;
+}
+
+static void run(const char *mode, mlx_udelay_ptr udelay, uint32_t rounds, long cpus){
+    double base = 0;
+    for(int buses = 1; buses <= MLX90393_ARRAY_MAX_BUSES; buses++){
+        mlx_array_t array;
+        MLX90393_MpscInit(&merged, cells, sizeof(cells) / sizeof(cells[0]));
+        MLX90393_ArrayInit(&array, &merged);
+        for(int b = 0; b < buses; b++){
+            size_t bus;
+            MLX90393_ArrayAddBus(&array, MLX90393_SimClock, udelay, (int) (b % cpus), &bus);
+            for(int d = 0; d < MLX90393_SCHED_MAX_DEVICES; d++){
+                int i = b * MLX90393_SCHED_MAX_DEVICES + d;
+                memset(&devs[i], 0, sizeof(mlx_i2c_t));
+                MLX90393_SimInit(&sims[i]);
+                MLX90393_SimAttach(&devs[i], &sims[i]);
+                devs[i].udelay = udelay;
+                settings[i] = (mlx_cfg_t) {
+                    .gain = MLX90393_GAIN_1X, .resolution_x = MLX90393_RES_16, .resolution_y = MLX90393_RES_16,
+                    .resolution_z = MLX90393_RES_16, .filter = MLX90393_FILTER_2, .oversampling = MLX90393_OSR_1
+                };
+                devs[i].settings = &settings[i];
+                MLX90393_ApplySettings(&devs[i], &settings[i]);
+                MLX90393_ArrayAddDevice(&array, bus, &devs[i], 0, NULL, NULL);
+            }
+        }
+
+        pthread_t thread;
+        atomic_store(&producing, 1);
+        double t0 = now_s();
+        pthread_create(&thread, NULL, consumer, NULL);
+        MLX90393_ArrayStart(&array, rounds);
+        MLX90393_ArrayWait(&array);
+        atomic_store_explicit(&producing, 0, memory_order_release);
+        pthread_join(thread, NULL);
+        double wall = now_s() - t0;
+
+        uint64_t dropped = 0;
+        for(size_t i = 0; i < array.dev_count; i++){
+            dropped += atomic_load(&array.devs[i].dropped);
+        }
+        double sps = (double) consumed / wall;
+        if(buses == 1){
+            base = sps;
+        }
+        printf("%s,%d,%d,%llu,%llu,%.0f,%.2f\n", mode, buses, buses * MLX90393_SCHED_MAX_DEVICES,
+               (unsigned long long) consumed, (unsigned long long) dropped, sps, sps / base);
+    }
+}
+
+int main(void){
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    printf("# %ld CPUs online\n", cpus);
+    printf("mode,buses,sensors,samples,dropped,wall_sps,speedup\n");
+    run("cpu", MLX90393_SimUdelay, ROUNDS, cpus);
+    run("sleep", sleep_udelay, SLEEP_ROUNDS, cpus);
+    return 0;
+}
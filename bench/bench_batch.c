@@ -0,0 +1,63 @@
+/**
+ * @brief Per-sample MLX90393_convertXYZ vs block MLX90393_convertBatch throughput
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "MLX90393.h"
+
+#define FRAMES 4096
+#define PASSES 500
+
+static double now_s(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(void){
+    static uint8_t frames[FRAMES][6];
+    static float x[FRAMES], y[FRAMES], z[FRAMES];
+    mlx_cfg_t cfg = {
+        .gain = MLX90393_GAIN_1X,
+        .resolution_x = MLX90393_RES_16,
+        .resolution_y = MLX90393_RES_17,
+        .resolution_z = MLX90393_RES_18,
+        .filter = MLX90393_FILTER_0,
+        .oversampling = MLX90393_OSR_0
+    };
+    srand(1);
+    for(int i = 0; i < FRAMES; i++){
+        for(int b = 0; b < 6; b++){
+            frames[i][b] = rand() & 0xFF;
+        }
+    }
+
+    volatile float sink = 0;
+
+    double t0 = now_s();
+    for(int p = 0; p < PASSES; p++){
+        for(int i = 0; i < FRAMES; i++){
+            float xyz[3];
+            MLX90393_convertXYZ(&cfg, frames[i], xyz);
+            x[i] = xyz[0];
+            y[i] = xyz[1];
+            z[i] = xyz[2];
+        }
+        sink += x[p] + y[p] + z[p];
+    }
+    double t_scalar = now_s() - t0;
+
+    t0 = now_s();
+    for(int p = 0; p < PASSES; p++){
+        MLX90393_convertBatch(&cfg, 0, MLX90393_MAG_XYZ, frames[0], FRAMES, x, y, z, NULL);
+        sink += x[p] + y[p] + z[p];
+    }
+    double t_batch = now_s() - t0;
+
+    double n = (double) FRAMES * PASSES;
+    printf("path,samples_per_sec,ns_per_sample\n");
+    printf("scalar,%.0f,%.2f\n", n / t_scalar, t_scalar * 1e9 / n);
+    printf("batch,%.0f,%.2f\n", n / t_batch, t_batch * 1e9 / n);
+    return 0;
+}
@@ -0,0 +1,48 @@
+/**
+ * @brief Host filter stage throughput (MLX90393_DspRun) per stage type
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "MLX90393.h"
+#include "MLX90393_dsp.h"
+
+#define SAMPLES 4096
+#define PASSES 500
+
+static double now_s(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(void){
+    static float in[SAMPLES], out[SAMPLES];
+    static float window[16];
+    mlx_dsp_t stages[4];
+    const char *names[4] = {"movavg16", "butterworth4", "butterworth8_dec4", "cic3_dec16"};
+    MLX90393_DspMovingAverage(&stages[0], window, 16, 1);
+    MLX90393_DspButterworth(&stages[1], 4, 5.0f, 100.0f, 1);
+    MLX90393_DspButterworth(&stages[2], 8, 5.0f, 100.0f, 4);
+    MLX90393_DspCIC(&stages[3], 3, 16, 0);
+
+    srand(1);
+    for(int i = 0; i < SAMPLES; i++){
+        in[i] = 50.0f + (float) (rand() % 2000) / 100.0f;
+    }
+
+    volatile float sink = 0;
+    double n = (double) SAMPLES * PASSES;
+    printf("stage,samples_per_sec,ns_per_sample\n");
+    for(int s = 0; s < 4; s++){
+        size_t n_out;
+        double t0 = now_s();
+        for(int p = 0; p < PASSES; p++){
+            MLX90393_DspRun(&stages[s], in, out, SAMPLES, &n_out);
+            sink += out[0];
+        }
+        double t = now_s() - t0;
+        printf("%s,%.0f,%.2f\n", names[s], n / t, t * 1e9 / n);
+    }
+    return 0;
+}
@@ -0,0 +1,63 @@
+/**
+ * @brief Float (MLX90393_convertXYZ) vs fixed-point (MLX90393_convertXYZ_nT) conversion throughput
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "MLX90393.h"
+
+#define FRAMES 4096
+#define PASSES 500
+
+static double now_s(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(void){
+    static uint8_t frames[FRAMES][6];
+    mlx_cfg_t cfg = {
+        .gain = MLX90393_GAIN_1X,
+        .resolution_x = MLX90393_RES_16,
+        .resolution_y = MLX90393_RES_17,
+        .resolution_z = MLX90393_RES_18,
+        .filter = MLX90393_FILTER_0,
+        .oversampling = MLX90393_OSR_0
+    };
+    srand(1);
+    for(int i = 0; i < FRAMES; i++){
+        for(int b = 0; b < 6; b++){
+            frames[i][b] = rand() & 0xFF;
+        }
+    }
+
+    volatile float sink_f = 0;
+    volatile int32_t sink_i = 0;
+
+    double t0 = now_s();
+    for(int p = 0; p < PASSES; p++){
+        for(int i = 0; i < FRAMES; i++){
+            float xyz[3];
+            MLX90393_convertXYZ(&cfg, frames[i], xyz);
+            sink_f += xyz[0] + xyz[1] + xyz[2];
+        }
+    }
+    double t_float = now_s() - t0;
+
+    t0 = now_s();
+    for(int p = 0; p < PASSES; p++){
+        for(int i = 0; i < FRAMES; i++){
+            int32_t xyz[3];
+            MLX90393_convertXYZ_nT(&cfg, frames[i], xyz);
+            sink_i += xyz[0] + xyz[1] + xyz[2];
+        }
+    }
+    double t_fixed = now_s() - t0;
+
+    double n = (double) FRAMES * PASSES;
+    printf("path,samples_per_sec,ns_per_sample\n");
+    printf("float,%.0f,%.2f\n", n / t_float, t_float * 1e9 / n);
+    printf("fixed,%.0f,%.2f\n", n / t_fixed, t_fixed * 1e9 / n);
+    return 0;
+}
@@ -0,0 +1,86 @@
+/**
+ * @brief Aggregate samples/sec of sequential MLX90393_readXYZ vs the bus scheduler,
+ * for 1 to MLX90393_SCHED_MAX_DEVICES sensors on one simulated 400 kHz bus (virtual time)
+ */
+#include <stdio.h>
+#include <string.h>
+#include "MLX90393.h"
+#include "MLX90393_sched.h"
+
+#define BUS_BYTE_US 23 //9 bit times at 400 kHz, rounded up
+#define ROUNDS 200
+
+static uint64_t now_us;
+
+static uint64_t bench_clock(void){
+    return now_us;
+}
+
+static void bench_udelay(uint32_t us){
+    now_us += us;
+}
+
+static void bench_mdelay(uint32_t ms){
+    now_us += (uint64_t) ms * 1000;
+}
+
+static int32_t bench_write(mlx_i2c_t *dev, uint8_t *buf, size_t len){
+    now_us += (len + 1) * BUS_BYTE_US; //Address byte + payload
+    return 0;
+}
+
+static int32_t bench_read(mlx_i2c_t *dev, uint8_t *data, size_t len){
+    memset(data, 0, len);
+    now_us += (len + 1) * BUS_BYTE_US;
+    return 0;
+}
+
+int main(void){
+    mlx_cfg_t settings = {
+        .gain = MLX90393_GAIN_1X,
+        .resolution_x = MLX90393_RES_16,
+        .resolution_y = MLX90393_RES_16,
+        .resolution_z = MLX90393_RES_16,
+        .filter = MLX90393_FILTER_2,
+        .oversampling = MLX90393_OSR_1
+    };
+    mlx_i2c_t devs[MLX90393_SCHED_MAX_DEVICES];
+    for(int i = 0; i < MLX90393_SCHED_MAX_DEVICES; i++){
+        memset(&devs[i], 0, sizeof(mlx_i2c_t));
+        devs[i].settings = &settings;
+        devs[i].write_function = bench_write;
+        devs[i].read_function = bench_read;
+        devs[i].mdelay = bench_mdelay;
+        devs[i].udelay = bench_udelay;
+        devs[i].clock_us = bench_clock;
+    }
+
+    printf("sensors,readXYZ_sps,sched_sps,speedup\n");
+    for(int n = 1; n <= MLX90393_SCHED_MAX_DEVICES; n++){
+        float xyz[3];
+
+        now_us = 0;
+        for(int r = 0; r < ROUNDS; r++){
+            for(int i = 0; i < n; i++){
+                MLX90393_readXYZ(&devs[i], xyz);
+            }
+        }
+        double seq_sps = (double) ROUNDS * n * 1e6 / (double) now_us;
+
+        mlx_sched_t sched;
+        MLX90393_SchedInit(&sched, bench_clock, bench_udelay, NULL, NULL);
+        for(int i = 0; i < n; i++){
+            MLX90393_SchedAdd(&sched, &devs[i], 0);
+        }
+        now_us = 0;
+        MLX90393_SchedRun(&sched, ROUNDS);
+        uint32_t total = 0;
+        for(int i = 0; i < n; i++){
+            total += sched.slots[i].samples;
+        }
+        double sched_sps = (double) total * 1e6 / (double) now_us;
+
+        printf("%d,%.1f,%.1f,%.2f\n", n, seq_sps, sched_sps, sched_sps / seq_sps);
+    }
+    return 0;
+}
@@ -0,0 +1,180 @@
+/**
+ * @brief Per-operation cost of the driver against the simulator (400 kHz bus, virtual time),
+ * for every filter / OSR combination of MLX90393_Tconv_LookUp
+ * 
+ * Columns: host wall time (driver + simulator), virtual bus latency (transfers + conversion waits), bus transactions,
+ * bytes written / read and allocator calls, all per operation.
+ * Usage: bench_suite [--json]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "MLX90393.h"
+#include "MLX90393_cmds.h"
+#include "MLX90393_sim.h"
+
+#define BUS_BYTE_US 23 //9 bit times at 400 kHz, rounded up
+#define ITERATIONS 2000
+
+static uint32_t allocs;
+static uint32_t frees;
+
+//Strong definitions override the library's weak allocator hooks
+void *mlx_malloc(size_t s){
+    allocs++;
+    return malloc(s);
+}
+
+void mlx_free(void *memory){
+    frees++;
+    free(memory);
+}
+
+typedef struct {
+    const char *name;
+    void (*setup)(mlx_i2c_t *dev); //[Optional] Not measured
+    void (*run)(mlx_i2c_t *dev);
+    void (*cleanup)(mlx_i2c_t *dev); //[Optional] Not measured
+} bench_op_t;
+
+static mlx_cfg_t bench_cfg;
+static uint8_t status;
+static uint8_t data[8];
+
+static void op_readXYZ(mlx_i2c_t *dev){ float xyz[3]; MLX90393_readXYZ(dev, xyz); }
+static void op_GetSettings(mlx_i2c_t *dev){ MLX90393_GetSettings(dev); }
+static void op_ApplySettings(mlx_i2c_t *dev){ MLX90393_ApplySettings(dev, &bench_cfg); }
+static void op_EX(mlx_i2c_t *dev){ MLX90393_EX(dev, &status); }
+static void op_SB(mlx_i2c_t *dev){ MLX90393_SB(dev, MLX90393_MAG_XYZ, &status); }
+static void op_SWOC(mlx_i2c_t *dev){ MLX90393_SWOC(dev, MLX90393_MAG_XYZ, &status); }
+static void op_SM(mlx_i2c_t *dev){ MLX90393_SM(dev, MLX90393_MAG_XYZ, &status); }
+static void op_RM(mlx_i2c_t *dev){ MLX90393_RM(dev, MLX90393_MAG_XYZ, &status, data); }
+static void op_RR(mlx_i2c_t *dev){ MLX90393_RR(dev, &status, MLX90393_REG_CONF1, data); }
+static void op_WR(mlx_i2c_t *dev){ MLX90393_WR(dev, &status, MLX90393_REG_SENS_TC, 0x0000); }
+static void op_HR(mlx_i2c_t *dev){ MLX90393_HR(dev, &status); }
+static void op_HS(mlx_i2c_t *dev){ MLX90393_HS(dev, &status); }
+static void op_RT(mlx_i2c_t *dev){ MLX90393_RT(dev, &status); }
+static void op_NOP(mlx_i2c_t *dev){ MLX90393_NOP(dev, &status); }
+
+//GetSettings on a device without settings storage yet (allocates it)
+static void setup_cold(mlx_i2c_t *dev){
+    free(dev->settings); //Bypass the counters, setup is not measured
+    dev->settings = NULL;
+}
+
+//ApplySettings with an unknown register shadow (read-modify-write on the bus)
+static void setup_invalidate(mlx_i2c_t *dev){
+    MLX90393_InvalidateRegisters(dev);
+}
+
+static void setup_measure(mlx_i2c_t *dev){
+    MLX90393_SM(dev, MLX90393_MAG_XYZ, &status);
+    MLX90393_SimUdelay(MLX90393_GetTconv_us(dev));
+}
+
+static void setup_burst(mlx_i2c_t *dev){
+    MLX90393_SB(dev, MLX90393_MAG_XYZ, &status);
+}
+
+static void cleanup_exit(mlx_i2c_t *dev){
+    MLX90393_EX(dev, &status);
+}
+
+static const bench_op_t ops[] = {
+    {"readXYZ", NULL, op_readXYZ, NULL},
+    {"GetSettings", NULL, op_GetSettings, NULL},
+    {"GetSettings_cold", setup_cold, op_GetSettings, NULL},
+    {"ApplySettings", NULL, op_ApplySettings, NULL},
+    {"ApplySettings_cold", setup_invalidate, op_ApplySettings, NULL},
+    {"EX", setup_burst, op_EX, NULL},
+    {"SB", NULL, op_SB, cleanup_exit},
+    {"SWOC", NULL, op_SWOC, cleanup_exit},
+    {"SM", NULL, op_SM, cleanup_exit},
+    {"RM", setup_measure, op_RM, NULL},
+    {"RR", NULL, op_RR, NULL},
+    {"WR", NULL, op_WR, NULL},
+    {"HR", NULL, op_HR, NULL},
+    {"HS", NULL, op_HS, NULL},
+    {"RT", NULL, op_RT, NULL},
+    {"NOP", NULL, op_NOP, NULL},
+};
+
+static double now_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char **argv){
+    int json = argc > 1 && strcmp(argv[1], "--json") == 0;
+    int first = 1;
+    mlx_sim_t sim;
+    mlx_i2c_t dev;
+
+    if(json){
+        printf("[\n");
+    } else {
+        printf("filter,osr,op,wall_ns,bus_us,transactions,bytes_written,bytes_read,allocs,frees\n");
+    }
+    for(int filter = 0; filter < 8; filter++){
+        for(int osr = 0; osr < 4; osr++){
+            bench_cfg = (mlx_cfg_t) {
+                .gain = MLX90393_GAIN_1X,
+                .resolution_x = MLX90393_RES_16,
+                .resolution_y = MLX90393_RES_16,
+                .resolution_z = MLX90393_RES_16,
+                .filter = (mlx90393_filter_t) filter,
+                .oversampling = (mlx90393_oversampling_t) osr
+            };
+            for(size_t o = 0; o < sizeof(ops) / sizeof(ops[0]); o++){
+                const bench_op_t *op = &ops[o];
+                //Fresh device per operation, configured and stored so that HR / RT keep the settings
+                MLX90393_SimInit(&sim);
+                sim.byte_us = BUS_BYTE_US;
+                memset(&dev, 0, sizeof(dev));
+                MLX90393_SimAttach(&dev, &sim);
+                MLX90393_ApplySettings(&dev, &bench_cfg);
+                MLX90393_HS(&dev, &status);
+
+                double wall = 0;
+                uint64_t bus = 0, transactions = 0, written = 0, read = 0;
+                uint32_t op_allocs = 0, op_frees = 0;
+                for(int i = 0; i < ITERATIONS; i++){
+                    if(op->setup != NULL) op->setup(&dev);
+                    uint64_t t0_bus = MLX90393_SimClock();
+                    uint32_t tr0 = sim.transactions;
+                    uint64_t w0 = sim.bytes_written, r0 = sim.bytes_read;
+                    uint32_t a0 = allocs, f0 = frees;
+                    double t0 = now_ns();
+                    op->run(&dev);
+                    wall += now_ns() - t0;
+                    bus += MLX90393_SimClock() - t0_bus;
+                    transactions += sim.transactions - tr0;
+                    written += sim.bytes_written - w0;
+                    read += sim.bytes_read - r0;
+                    op_allocs += allocs - a0;
+                    op_frees += frees - f0;
+                    if(op->cleanup != NULL) op->cleanup(&dev);
+                }
+                free(dev.settings);
+
+                double n = ITERATIONS;
+                if(json){
+                    printf("%s  {\"filter\": %d, \"osr\": %d, \"op\": \"%s\", \"wall_ns\": %.1f, \"bus_us\": %.1f, "
+                           "\"transactions\": %.2f, \"bytes_written\": %.2f, \"bytes_read\": %.2f, \"allocs\": %.2f, \"frees\": %.2f}",
+                           first ? "" : ",\n", filter, osr, op->name, wall / n, bus / n,
+                           transactions / n, written / n, read / n, op_allocs / n, op_frees / n);
+                } else {
+                    printf("%d,%d,%s,%.1f,%.1f,%.2f,%.2f,%.2f,%.2f,%.2f\n", filter, osr, op->name, wall / n, bus / n,
+                           transactions / n, written / n, read / n, op_allocs / n, op_frees / n);
+                }
+                first = 0;
+            }
+        }
+    }
+    if(json){
+        printf("\n]\n");
+    }
+    return 0;
+}
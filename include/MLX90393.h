@@ -4,18 +4,96 @@
 #include <stdint.h>
 #include <stddef.h>
 
+//Build with MLX90393_STATIC_ALLOC for a library without allocator calls: the settings are embedded
+//in mlx_i2c_t and MLX90393_Alloc hands out devices from a static pool
+#ifndef MLX90393_STATIC_POOL_SIZE
+#define MLX90393_STATIC_POOL_SIZE 4
+#endif
+
 #define MLX90393_I2C_ADDR 0x0C
 #define MLX90393_MAG_XYZ 0x0E
+#define MLX90393_MAG_XYZT 0x0F
+#define MLX90393_MAG_Z 0x08
+#define MLX90393_TEMP 0x01
 
 #define MLX90393_REG_CONF1 0x00
+#define MLX90393_REG_CONF2 0x01
 #define MLX90393_REG_CONF3 0x02
+#define MLX90393_REG_SENS_TC 0x03
+#define MLX90393_REG_OFFSET_X 0x04
+#define MLX90393_REG_OFFSET_Y 0x05
+#define MLX90393_REG_OFFSET_Z 0x06
+#define MLX90393_REG_WOXY_THRESHOLD 0x07
+#define MLX90393_REG_WOZ_THRESHOLD 0x08
+#define MLX90393_REG_WOT_THRESHOLD 0x09
+#define MLX90393_NUM_REGS 10 //Volatile register map 0x00 - 0x09
+
+//Status byte
+#define MLX90393_STATUS_BURST 0x80
+#define MLX90393_STATUS_WOC 0x40
+#define MLX90393_STATUS_SM 0x20
+#define MLX90393_STATUS_ERROR 0x10
+#define MLX90393_STATUS_SED 0x08
+#define MLX90393_STATUS_RS 0x04
+#define MLX90393_STATUS_D 0x03
+
+#define MLX90393_READY_POLL_US 100 //Re-poll interval when the data is not ready yet
+
+//Temperature transfer function (typical): T = TREF_DEGC + (raw - TREF_LSB) / TSENS_LSB
+#define MLX90393_TREF_DEGC 35.0f
+#define MLX90393_TREF_LSB 46244.0f
+#define MLX90393_TSENS_LSB 45.2f
+
+//Recovery policy flags (mlx_i2c_t.recovery)
+#define MLX90393_RECOVER_RESET 0x01 //Unexpected RS: EX, re-write the register shadow, restart burst / WOC, retry the command
+#define MLX90393_RECOVER_SED 0x02 //SED reported: retry the command once
+
+#define MLX90393_AGAIN 3 //No data yet / resource full, try again later
+#define MLX90393_MISMATCH 4 //The device rejected a write or a read back does not match
+#define MLX90393_TIMEOUT 5 //The device did not deliver a measurement in time
 
 typedef struct mlx_i2c_t mlx_i2c_t;
 typedef struct mlx_cfg_t mlx_cfg_t;
+typedef struct mlx_cfg_ext_t mlx_cfg_ext_t;
+typedef struct mlx_sample_t mlx_sample_t;
+typedef struct mlx_status_t mlx_status_t;
+typedef struct mlx_jitter_t mlx_jitter_t;
 
 typedef int32_t (*mlx_wr_ptr)(mlx_i2c_t *dev, uint8_t *buf, size_t len);
 typedef int32_t (*mlx_rd_ptr)(mlx_i2c_t *dev, uint8_t *data, size_t len); // read the bus
+typedef int32_t (*mlx_xfer_ptr)(mlx_i2c_t *dev, uint8_t *wbuf, size_t wlen, uint8_t *rbuf, size_t rlen); // write + repeated start + read
 typedef void (*mlx_mdelay_ptr)(uint32_t ms);
+typedef void (*mlx_udelay_ptr)(uint32_t us);
+typedef uint64_t (*mlx_clock_ptr)(void); //monotonic clock [us]
+
+#ifdef MLX90393_STATS
+typedef struct mlx_stats_t mlx_stats_t;
+//Called after every command with its bytes, the response (status byte first) and the transport result
+typedef void (*mlx_trace_ptr)(void *ctx, mlx_i2c_t *dev, const uint8_t *cmd, size_t cmd_len,
+                              const uint8_t *resp, size_t resp_len, int32_t ret);
+
+/**
+ * @brief Per-device hot path counters (build with MLX90393_STATS)
+ * 
+ */
+struct mlx_stats_t{
+    uint32_t commands[16]; //Per opcode, indexed by its upper nibble (3 = SM, 4 = RM, 5 = RR...)
+    uint64_t bytes_out;
+    uint64_t bytes_in;
+    uint32_t bus_errors; //Failed transport calls
+    uint32_t status_error; //Status bytes with the ERROR bit set
+    uint32_t status_sed;
+    uint32_t status_rs;
+    uint64_t wait_us; //Conversion waits requested from mdelay / udelay by MLX90393_WaitAndRead
+    uint32_t samples; //Measurements timed from SM to their RM (needs the clock_us hook)
+    uint32_t latency_min_us;
+    uint32_t latency_max_us;
+    uint64_t latency_sum_us; //Average = latency_sum_us / samples
+    uint32_t recoveries; //Commands repeated by the recovery policy
+    uint64_t sm_us; //Time of the SM in flight (internal)
+    uint8_t sm_timed; //(internal)
+};
+#endif
 
 typedef enum mlx90393_gain {
   MLX90393_GAIN_5X = (0x00),
@@ -54,6 +132,19 @@ typedef enum mlx90393_oversampling {
 } mlx90393_oversampling_t;
 
 
+/**
+ * @brief MLX settings (CONF1 & CONF3 registers) structure
+ * 
+ */
+struct mlx_cfg_t{
+    mlx90393_gain_t gain;
+    mlx90393_resolution_t resolution_x;
+    mlx90393_resolution_t resolution_y;
+    mlx90393_resolution_t resolution_z;
+    mlx90393_filter_t filter;
+    mlx90393_oversampling_t oversampling;
+};
+
 /**
  * @brief MLX90393 IIC device structure
  * 
@@ -63,29 +154,129 @@ struct mlx_i2c_t{
     mlx_cfg_t *settings;
     mlx_wr_ptr write_function;
     mlx_rd_ptr read_function;
+    mlx_xfer_ptr transfer; //[Optional] Combined write-read transaction, used instead of write + read when set
     mlx_mdelay_ptr mdelay;
-    
+    mlx_udelay_ptr udelay; //[Optional] Enables the adaptive (exact Tconv + status polling) wait
+    uint8_t ready_retries; //Extra RM attempts when the status byte reports the data is not ready
+    mlx_clock_ptr clock_us; //[Optional] Needed by the asynchronous (Start/Complete) API
+    uint64_t deadline_us; //End of the conversion in flight
+    uint8_t pending; //A measurement has been started and not collected yet
+    uint16_t regs[MLX90393_NUM_REGS]; //Shadow copy of the volatile register map
+    uint16_t regs_valid; //Bit n set when regs[n] matches the device
+    uint8_t recovery; //MLX90393_RECOVER_* flags (0 = report the status only)
+    uint8_t burst_cmd; //SB / SWOC command in effect, restarted after a reset (0 when idle)
+    uint8_t recovering;
+    uint32_t cfg_gen; //Bumped whenever CONF1-CONF3 may have changed (WR, HR, RT)
+    uint32_t seq; //Sequence number of the next sample
+    mlx_jitter_t *jitter; //[Optional] Timing statistics updated with every sample (needs clock_us)
+#ifdef MLX90393_STATIC_ALLOC
+    mlx_cfg_t settings_storage; //settings points here
+#endif
+#ifdef MLX90393_STATS
+    mlx_stats_t stats;
+    mlx_trace_ptr trace; //[Optional]
+    void *trace_ctx;
+#endif
 };
 
 /**
- * @brief MLX settings (CONF1 & CONF3 registers) structure
+ * @brief MLX full volatile register map configuration (CONF1 - CONF3, SENS_TC, offsets, WOC thresholds)
  * 
  */
-struct mlx_cfg_t{
-    mlx90393_gain_t gain;
-    mlx90393_resolution_t resolution_x;
-    mlx90393_resolution_t resolution_y;
-    mlx90393_resolution_t resolution_z;
-    mlx90393_filter_t filter;
-    mlx90393_oversampling_t oversampling;
+struct mlx_cfg_ext_t{
+    mlx_cfg_t base;
+    uint8_t hallconf; //CONF1[3:0] (0x0C default)
+    uint8_t burst_data_rate; //CONF2[5:0], period = 20 ms * value (0 = back to back)
+    uint8_t burst_sel; //CONF2[9:6], zyxt measured in burst and WOC modes
+    uint8_t tcmp_en; //CONF2[10], on-chip temperature compensation
+    uint8_t ext_trig; //CONF2[11]
+    uint8_t woc_diff; //CONF2[12], WOC compares against the previous sample instead of the first one
+    uint8_t comm_mode; //CONF2[14:13]
+    uint8_t trig_int_sel; //CONF2[15], INT/TRIG pin works as trigger input
+    uint8_t osr2; //CONF3[12:11], temperature oversampling
+    uint16_t sens_tc; //SENS_TC_HT[15:8] | SENS_TC_LT[7:0]
+    uint16_t offset[3]; //OFFSET_X/Y/Z
+    uint16_t woxy_threshold;
+    uint16_t woz_threshold;
+    uint16_t wot_threshold;
+};
+
+/**
+ * @brief Decoded MLX90393 measurement
+ * 
+ */
+struct mlx_sample_t{
+    float xyz[3]; //[uT]
+    float t; //[degC]
+    char zyxt; //Channels present in the sample
+    uint8_t status;
+    uint32_t cfg_gen; //mlx_i2c_t.cfg_gen the sample was taken under
+    uint32_t seq; //Per-device sample counter, gaps mean lost samples
+    uint64_t t_issue_us; //Command that produced the sample sent: SM, or RM in burst / WOC mode (0 without clock_us)
+    uint64_t t_expected_us; //Expected end of the conversion from the Tconv table (t_issue_us for burst / WOC reads)
+    uint64_t t_done_us; //Response read back
+};
+
+/**
+ * @brief Rolling sample timing statistics of one device (exponential averages, gain 1/16)
+ * 
+ */
+struct mlx_jitter_t{
+    uint32_t samples;
+    uint64_t last_done_us;
+    float period_us; //Interval between samples
+    float jitter_us; //Deviation of the interval from period_us (RFC 3550 style)
+    float latency_us; //t_done_us - t_expected_us: bus time plus any wait past the end of the conversion
+    uint32_t latency_min_us;
+    uint32_t latency_max_us;
+};
+
+/**
+ * @brief Decoded status byte
+ * 
+ */
+struct mlx_status_t{
+    uint8_t mode; //MLX90393_STATUS_BURST / WOC / SM bits (0 when idle)
+    uint8_t error; //Command rejected or data not ready
+    uint8_t sed; //Single error detected (and corrected) in the memory
+    uint8_t rs; //The device has been reset
+    uint8_t data_bytes; //RM payload announced by D1:D0 (2 * D + 2)
 };
 
 // USER FUNCTIONS
 int32_t MLX90393_Init(mlx_i2c_t *dev, mlx_cfg_t *settings);
+int32_t MLX90393_DecodeStatus(uint8_t status, mlx_status_t *decoded);
 int32_t MLX90393_GetSettings(mlx_i2c_t *dev);
 int32_t MLX90393_ApplySettings(mlx_i2c_t *dev, mlx_cfg_t *new_settings);
+int32_t MLX90393_ApplyConfig(mlx_i2c_t *dev, const mlx_cfg_ext_t *cfg);
+int32_t MLX90393_GetConfig(mlx_i2c_t *dev, mlx_cfg_ext_t *cfg);
+int32_t MLX90393_SyncRegisters(mlx_i2c_t *dev);
+void MLX90393_InvalidateRegisters(mlx_i2c_t *dev);
 int32_t MLX90393_readXYZ(mlx_i2c_t *dev, float *xyz);
+int32_t MLX90393_convertXYZ(const mlx_cfg_t *cfg, const uint8_t *data, float *xyz);
+uint8_t MLX90393_TcmpEnabled(mlx_i2c_t *dev);
+int32_t MLX90393_readMeasurement(mlx_i2c_t *dev, char zyxt, mlx_sample_t *sample);
+void MLX90393_StampSample(mlx_i2c_t *dev, mlx_sample_t *sample, uint64_t t_issue_us, uint64_t t_expected_us);
+int32_t MLX90393_JitterUpdate(mlx_jitter_t *jitter, const mlx_sample_t *sample);
+int32_t MLX90393_convert(const mlx_cfg_t *cfg, uint8_t tcmp_en, char zyxt, const uint8_t *data, mlx_sample_t *sample);
+uint16_t MLX90393_ZeroOffset(mlx90393_resolution_t res, uint8_t tcmp_en);
+int32_t MLX90393_convertBatch(const mlx_cfg_t *cfg, uint8_t tcmp_en, char zyxt, const uint8_t *frames, size_t n,
+                              float *restrict x, float *restrict y, float *restrict z, float *restrict t);
+int32_t MLX90393_readXYZ_nT(mlx_i2c_t *dev, int32_t *xyz_nT);
+int32_t MLX90393_convertXYZ_nT(const mlx_cfg_t *cfg, const uint8_t *data, int32_t *xyz_nT);
+float MLX90393_GetSensitivity(const mlx_cfg_t *cfg, int axis);
+float MLX90393_GetTconv(mlx_i2c_t *dev);
+uint32_t MLX90393_GetTconv_us(mlx_i2c_t *dev);
+uint32_t MLX90393_GetTconvZyxt_us(mlx_i2c_t *dev, char zyxt);
+int32_t MLX90393_StartXYZ(mlx_i2c_t *dev, uint64_t *deadline_us);
+int32_t MLX90393_CompleteXYZ(mlx_i2c_t *dev, float *xyz);
+void MLX90393_CancelXYZ(mlx_i2c_t *dev);
+mlx_i2c_t *MLX90393_Alloc(void);
 void MLX90393_Free(mlx_i2c_t *dev);
+#ifdef MLX90393_STATS
+void MLX90393_ResetStats(mlx_i2c_t *dev);
+void MLX90393_SetTrace(mlx_i2c_t *dev, mlx_trace_ptr trace, void *ctx);
+#endif
 uint8_t count_set_bits(uint8_t zyxt);
 
 
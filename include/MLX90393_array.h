@@ -0,0 +1,103 @@
+#ifndef MLX90393_ARRAY_H
+#define MLX90393_ARRAY_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include "MLX90393.h"
+#include "MLX90393_sched.h"
+#include "MLX90393_stream.h"
+
+#ifndef MLX90393_ARRAY_MAX_BUSES
+#define MLX90393_ARRAY_MAX_BUSES 8
+#endif
+#define MLX90393_ARRAY_MAX_DEVICES (MLX90393_ARRAY_MAX_BUSES * MLX90393_SCHED_MAX_DEVICES)
+#define MLX90393_ARRAY_ANY_CPU (-1)
+#ifndef MLX90393_ARRAY_STOP_POLL_US
+#define MLX90393_ARRAY_STOP_POLL_US 1000 //Longest sleep of an idle worker between checks of the stop flag
+#endif
+
+typedef struct mlx_array_item_t mlx_array_item_t;
+typedef struct mlx_mpsc_cell_t mlx_mpsc_cell_t;
+typedef struct mlx_mpsc_t mlx_mpsc_t;
+typedef struct mlx_array_dev_t mlx_array_dev_t;
+typedef struct mlx_array_bus_t mlx_array_bus_t;
+typedef struct mlx_array_t mlx_array_t;
+
+/**
+ * @brief Sample of the merged queue, tagged with the array device id
+ *
+ */
+struct mlx_array_item_t{
+    uint32_t device;
+    mlx_sample_t sample;
+};
+
+struct mlx_mpsc_cell_t{
+    atomic_size_t seq; //Turn of the cell: pos when free, pos + 1 when filled
+    mlx_array_item_t item;
+};
+
+/**
+ * @brief Bounded multi-producer/single-consumer lock-free queue (per-cell sequence numbers)
+ *
+ */
+struct mlx_mpsc_t{
+    mlx_mpsc_cell_t *cells;
+    size_t mask;
+    atomic_size_t head; //Claimed by the producers
+    size_t tail; //Only used by the consumer
+};
+
+/**
+ * @brief One device of the array
+ *
+ */
+struct mlx_array_dev_t{
+    mlx_i2c_t *dev;
+    mlx_ring_t *ring; //[Optional] Per-device SPSC queue
+    size_t bus;
+    atomic_uint dropped; //Samples lost to full queues
+};
+
+/**
+ * @brief One bus: a scheduler run by its own worker thread
+ *
+ */
+struct mlx_array_bus_t{
+    mlx_array_t *array;
+    mlx_sched_t sched;
+    uint32_t ids[MLX90393_SCHED_MAX_DEVICES]; //Array device id of each scheduler slot
+    int cpu; //CPU the worker is pinned to (MLX90393_ARRAY_ANY_CPU = no affinity)
+    pthread_t thread;
+    uint8_t started;
+    uint32_t rounds; //Rounds to run (0 = until MLX90393_ArrayStop)
+    atomic_uint errors; //Failed scheduling rounds
+};
+
+/**
+ * @brief Sensor array spread over several buses, one worker thread per bus
+ *
+ */
+struct mlx_array_t{
+    mlx_array_bus_t buses[MLX90393_ARRAY_MAX_BUSES];
+    size_t bus_count;
+    mlx_array_dev_t devs[MLX90393_ARRAY_MAX_DEVICES];
+    size_t dev_count;
+    mlx_mpsc_t *merged; //[Optional] Every sample of the array
+    atomic_uchar running;
+};
+
+// MERGED QUEUE
+int32_t MLX90393_MpscInit(mlx_mpsc_t *queue, mlx_mpsc_cell_t *cells, size_t capacity);
+int32_t MLX90393_MpscPush(mlx_mpsc_t *queue, const mlx_array_item_t *item);
+int32_t MLX90393_MpscPop(mlx_mpsc_t *queue, mlx_array_item_t *item);
+
+// ARRAY
+int32_t MLX90393_ArrayInit(mlx_array_t *array, mlx_mpsc_t *merged);
+int32_t MLX90393_ArrayAddBus(mlx_array_t *array, mlx_clock_ptr clock_us, mlx_udelay_ptr udelay, int cpu, size_t *bus);
+int32_t MLX90393_ArrayAddDevice(mlx_array_t *array, size_t bus, mlx_i2c_t *dev, uint32_t period_us, mlx_ring_t *ring, size_t *id);
+int32_t MLX90393_ArrayStart(mlx_array_t *array, uint32_t rounds);
+int32_t MLX90393_ArrayWait(mlx_array_t *array);
+int32_t MLX90393_ArrayStop(mlx_array_t *array);
+
+#endif
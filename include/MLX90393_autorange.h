@@ -0,0 +1,35 @@
+#ifndef MLX90393_AUTORANGE_H
+#define MLX90393_AUTORANGE_H
+
+#include "MLX90393.h"
+
+#define MLX90393_AUTORANGE_HIGH_PCT 90 //Default: widen the range above 90 % of full scale
+#define MLX90393_AUTORANGE_LOW_PCT 30 //Default: narrow it when every axis stays below 30 %...
+#define MLX90393_AUTORANGE_HOLD 4 //...for this many samples in a row
+
+typedef struct mlx_autorange_t mlx_autorange_t;
+
+/**
+ * @brief Automatic gain (and optionally resolution) control of one MLX90393 device
+ * 
+ * The range ladder goes from max_gain at the configured resolutions (most sensitive) down to
+ * MLX90393_GAIN_5X, then, with use_resolution, up to RES_19 on every axis (widest range).
+ * One step per sample; a step never multiplies the sensitivity by more than 2, so low_pct
+ * below high_pct / 2 leaves a dead band and the control cannot oscillate.
+ */
+struct mlx_autorange_t{
+    mlx_i2c_t *dev;
+    uint8_t high_pct; //Step to a wider range when an axis exceeds this share of its full scale
+    uint8_t low_pct; //Step to a narrower range when all axes stay below this share...
+    uint8_t hold; //...for hold consecutive samples
+    uint8_t use_resolution; //Extend the ladder with RES_17 - RES_19 once the gain is at its minimum
+    mlx90393_gain_t max_gain; //Most sensitive gain the control may select
+    mlx90393_resolution_t base_res[3]; //Resolutions at the sensitive end of the ladder
+    uint8_t below; //Consecutive samples under low_pct
+    uint32_t switches;
+};
+
+int32_t MLX90393_AutorangeInit(mlx_autorange_t *ar, mlx_i2c_t *dev);
+int32_t MLX90393_AutorangeRead(mlx_autorange_t *ar, mlx_sample_t *sample, mlx_cfg_t *cfg);
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef MLX90393_CALIB_H
+#define MLX90393_CALIB_H
+
+#include "MLX90393.h"
+
+#define MLX90393_CALIB_MIN_SAMPLES 32 //Fewer samples cannot pin down the 9 ellipsoid parameters reliably
+
+typedef struct mlx_calib_t mlx_calib_t;
+
+/**
+ * @brief Hard/soft-iron calibration of one MLX90393 device
+ *
+ * Samples are fitted to the ellipsoid a x^2 + b y^2 + c z^2 + 2d xy + 2e xz + 2f yz + 2g x + 2h y + 2i z = 1
+ * by least squares. Only the normal equations are accumulated, so memory does not grow with the number
+ * of samples. The correction is xyz_cal = matrix * (xyz - offset), which maps the ellipsoid to a sphere
+ * of radius field_uT.
+ */
+struct mlx_calib_t{
+    double ata[9][9]; //Normal equations D^T D (upper triangle)
+    double atb[9]; //D^T 1
+    double scale; //Inputs are divided by the magnitude of the first sample to keep the sums well conditioned
+    uint32_t samples;
+    float offset[3]; //Hard iron [uT], 0 for axes whose offset is applied on chip
+    float matrix[3][3]; //Soft iron, symmetric
+    float field_uT; //Radius of the fitted sphere
+    uint8_t valid; //A fit has been solved (identity correction otherwise)
+};
+
+// FITTING
+int32_t MLX90393_CalibInit(mlx_calib_t *cal);
+int32_t MLX90393_CalibAdd(mlx_calib_t *cal, const float *xyz);
+int32_t MLX90393_CalibAddBatch(mlx_calib_t *cal, const float *x, const float *y, const float *z, size_t n);
+int32_t MLX90393_CalibSolve(mlx_calib_t *cal);
+
+// CORRECTION
+int32_t MLX90393_CalibApply(const mlx_calib_t *cal, float *xyz);
+int32_t MLX90393_CalibConvertBatch(const mlx_calib_t *cal, const mlx_cfg_t *cfg, uint8_t tcmp_en, char zyxt,
+                                   const uint8_t *frames, size_t n, float *restrict x, float *restrict y, float *restrict z);
+
+// PERSISTENCE
+int32_t MLX90393_CalibStore(mlx_calib_t *cal, mlx_i2c_t *dev);
+
+#endif
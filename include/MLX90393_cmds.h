@@ -14,5 +14,7 @@ int32_t MLX90393_HR(mlx_i2c_t *dev, uint8_t *statusBuffer);
 int32_t MLX90393_HS(mlx_i2c_t *dev, uint8_t *statusBuffer);
 int32_t MLX90393_RT(mlx_i2c_t *dev, uint8_t *statusBuffer);
 int32_t MLX90393_NOP(mlx_i2c_t *dev, uint8_t *statusBuffer);
+int32_t MLX90393_WaitAndRead(mlx_i2c_t *dev, char zyxt, uint8_t *statusBuffer, uint8_t *dataBuffer);
+int32_t MLX90393_MeasureXYZ(mlx_i2c_t *dev, uint8_t *data);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,80 @@
+#ifndef MLX90393_DSP_H
+#define MLX90393_DSP_H
+
+#include "MLX90393.h"
+
+/**
+ * @brief Host-side filtering and decimation of decoded sample blocks
+ *
+ * Sampling at a low on-chip MLX90393_FILTER_x / OSR keeps Tconv short; these stages recover the
+ * noise performance on the host. Each mlx_dsp_t filters one axis and works on the float arrays
+ * written by MLX90393_convertBatch. All state lives in the struct or in caller-provided buffers:
+ * nothing is allocated, and splitting a stream into blocks does not change the output.
+ */
+
+#define MLX90393_DSP_MAX_SECTIONS 4 //Up to an 8th order Butterworth
+#define MLX90393_DSP_CIC_MAX_ORDER 5
+#define MLX90393_DSP_CIC_LSB 0.001f //Default CIC input quantisation [uT] (1 nT)
+
+typedef struct mlx_biquad_t mlx_biquad_t;
+typedef struct mlx_dsp_t mlx_dsp_t;
+
+typedef enum{
+    MLX90393_DSP_NONE = (0x00),
+    MLX90393_DSP_MOVAVG, //Boxcar over a caller-provided window
+    MLX90393_DSP_IIR, //Cascade of biquad sections (Butterworth low-pass)
+    MLX90393_DSP_CIC //Cascaded integrator-comb decimator
+} mlx90393_dsp_type_t;
+
+/**
+ * @brief Second-order IIR section, transposed direct form II (a0 normalised to 1)
+ *
+ */
+struct mlx_biquad_t{
+    float b0, b1, b2;
+    float a1, a2;
+    float z1, z2;
+};
+
+/**
+ * @brief Filter stage of one axis
+ *
+ * Every stage keeps one output out of decim filtered samples (decim 1: no decimation).
+ */
+struct mlx_dsp_t{
+    mlx90393_dsp_type_t type;
+    uint16_t decim;
+    uint16_t phase; //Input samples since the last output
+    union{
+        struct{
+            float *window; //len most recent inputs
+            size_t len;
+            size_t pos;
+            size_t count; //Inputs in the window until it has filled up once
+            double sum; //Running sum, double so it does not drift
+        } movavg;
+        struct{
+            mlx_biquad_t sections[MLX90393_DSP_MAX_SECTIONS];
+            size_t n;
+        } iir;
+        struct{
+            uint8_t order;
+            float lsb; //Input quantisation [uT]
+            float scale; //lsb / decim^order
+            uint64_t integ[MLX90393_DSP_CIC_MAX_ORDER]; //Wrap-around arithmetic is exact for a CIC
+            uint64_t comb[MLX90393_DSP_CIC_MAX_ORDER];
+        } cic;
+    };
+};
+
+// SETUP
+int32_t MLX90393_DspMovingAverage(mlx_dsp_t *dsp, float *window, size_t len, uint16_t decim);
+int32_t MLX90393_DspButterworth(mlx_dsp_t *dsp, size_t order, float fc_hz, float fs_hz, uint16_t decim);
+int32_t MLX90393_DspCIC(mlx_dsp_t *dsp, uint8_t order, uint16_t decim, float lsb);
+int32_t MLX90393_DspReset(mlx_dsp_t *dsp);
+
+// PROCESSING
+int32_t MLX90393_DspRun(mlx_dsp_t *dsp, const float *in, float *out, size_t n, size_t *n_out);
+int32_t MLX90393_DspRunXYZ(mlx_dsp_t *dsp, float *x, float *y, float *z, size_t n, size_t *n_out);
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef MLX90393_LINUX_H
+#define MLX90393_LINUX_H
+
+#include "MLX90393.h"
+
+//I2C_RDWR accepts at most 42 messages per call: one write + one read per device
+#define MLX90393_LINUX_MAX_MSGS 42
+#define MLX90393_LINUX_MAX_BATCH (MLX90393_LINUX_MAX_MSGS / 2)
+
+typedef struct mlx_linux_t mlx_linux_t;
+typedef struct mlx_linux_xfer_t mlx_linux_xfer_t;
+
+/**
+ * @brief Linux i2c-dev link of one MLX90393 device (pointed to by mlx_i2c_t.handle)
+ * 
+ */
+struct mlx_linux_t{
+    int fd; //Open /dev/i2c-N descriptor, may be shared by every device on the bus
+    uint16_t addr; //7-bit I2C address of the device
+};
+
+/**
+ * @brief One combined write-read transaction of a batch
+ * 
+ */
+struct mlx_linux_xfer_t{
+    uint16_t addr;
+    uint8_t *wbuf;
+    size_t wlen;
+    uint8_t *rbuf; //[Optional] NULL / rlen = 0 for a write-only transaction
+    size_t rlen;
+};
+
+//Syscall shim (weak, overridden by the tests)
+int mlx_sys_open(const char *path, int flags);
+int mlx_sys_ioctl(int fd, unsigned long request, void *arg);
+int mlx_sys_close(int fd);
+
+// BUS
+int32_t MLX90393_LinuxOpen(int adapter, int *fd);
+int32_t MLX90393_LinuxClose(int fd);
+int32_t MLX90393_LinuxAttach(mlx_i2c_t *dev, mlx_linux_t *link, int fd, uint16_t addr);
+
+// TRANSPORT HOOKS
+int32_t MLX90393_LinuxWrite(mlx_i2c_t *dev, uint8_t *buf, size_t len);
+int32_t MLX90393_LinuxRead(mlx_i2c_t *dev, uint8_t *data, size_t len);
+int32_t MLX90393_LinuxTransfer(mlx_i2c_t *dev, uint8_t *wbuf, size_t wlen, uint8_t *rbuf, size_t rlen);
+
+// BATCHING
+int32_t MLX90393_LinuxBatch(int fd, mlx_linux_xfer_t *xfers, size_t n);
+int32_t MLX90393_LinuxReadMeasurements(mlx_i2c_t **devs, size_t n, char zyxt, uint8_t *status, uint8_t *data);
+
+#endif
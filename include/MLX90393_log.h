@@ -0,0 +1,98 @@
+#ifndef MLX90393_LOG_H
+#define MLX90393_LOG_H
+
+#include <stdio.h>
+#include "MLX90393.h"
+
+/**
+ * @brief Compact binary log of raw RM frames
+ *
+ * File: 8 byte header "MLX93LG" + version, then records (little-endian fields):
+ *   CONFIG  0x01 | cfg_gen u32 | gain | res_x | res_y | res_z | filter | osr | tcmp_en | zyxt
+ *   FRAMES  0x02 | count u16 | t_first_us u64 | t_last_us u64 | count raw payloads as read from the sensor
+ * A FRAMES record holds up to MLX90393_LOG_BLOCK payloads of 2 bytes per channel of the last CONFIG
+ * (6 bytes per XYZ sample), all decoded with those settings. Sample times in between t_first_us and
+ * t_last_us are interpolated. The file is append-only; a record cut short by a crash is ignored.
+ */
+
+#define MLX90393_LOG_VERSION 1
+#define MLX90393_LOG_BLOCK 256 //Frames per FRAMES record
+#define MLX90393_LOG_IO_BUFFER 65536 //stdio buffer of the writer
+#define MLX90393_LOG_CONFIG 0x01
+#define MLX90393_LOG_FRAMES 0x02
+
+typedef struct mlx_log_writer_t mlx_log_writer_t;
+typedef struct mlx_log_reader_t mlx_log_reader_t;
+typedef struct mlx_log_replay_t mlx_log_replay_t;
+
+/**
+ * @brief Log writer, collects a block of frames before handing it to buffered stdio
+ *
+ */
+struct mlx_log_writer_t{
+    FILE *fp;
+    uint8_t stride; //Payload bytes per frame (0 until the first CONFIG)
+    uint16_t count; //Frames in block
+    uint64_t t_first_us;
+    uint64_t t_last_us;
+    uint64_t frames; //Frames written since LogOpen
+    uint8_t block[MLX90393_LOG_BLOCK * 8];
+};
+
+/**
+ * @brief Log reader over a memory-mapped file
+ *
+ * cfg, tcmp_en, zyxt and cfg_gen describe the frames currently being read.
+ */
+struct mlx_log_reader_t{
+    const uint8_t *map;
+    size_t size;
+    size_t pos; //Next record
+    mlx_cfg_t cfg;
+    uint8_t tcmp_en;
+    char zyxt;
+    uint8_t stride; //0 until the first CONFIG
+    uint32_t cfg_gen;
+    uint32_t configs; //CONFIG records read so far
+    const uint8_t *block; //Payloads of the current FRAMES record
+    uint16_t count;
+    uint16_t index; //Next frame in block
+    uint64_t t_first_us;
+    uint64_t t_last_us;
+    uint32_t seq; //Frames read so far
+};
+
+/**
+ * @brief Transport that answers the driver from a log (pointed to by mlx_i2c_t.handle)
+ *
+ * Each RM returns the next logged frame; SM, EX, WR... are accepted and RR reports the logged
+ * configuration. Crossing a CONFIG record updates dev->settings, dev->cfg_gen and the register
+ * shadow, as a live reconfiguration would have. At the end of the log RM reports ERROR.
+ */
+struct mlx_log_replay_t{
+    mlx_log_reader_t *reader;
+    uint8_t response[9];
+    size_t response_len;
+    uint16_t conf[3]; //CONF1 - CONF3 of the logged configuration
+    uint32_t configs; //reader->configs already applied to the device
+};
+
+// WRITER
+int32_t MLX90393_LogOpen(mlx_log_writer_t *w, const char *path);
+int32_t MLX90393_LogConfig(mlx_log_writer_t *w, const mlx_cfg_t *cfg, uint8_t tcmp_en, char zyxt, uint32_t cfg_gen);
+int32_t MLX90393_LogFrame(mlx_log_writer_t *w, const uint8_t *data, uint64_t t_us);
+int32_t MLX90393_LogFlush(mlx_log_writer_t *w);
+int32_t MLX90393_LogClose(mlx_log_writer_t *w);
+
+// READER
+int32_t MLX90393_LogMap(mlx_log_reader_t *r, const char *path);
+int32_t MLX90393_LogUnmap(mlx_log_reader_t *r);
+int32_t MLX90393_LogNextBlock(mlx_log_reader_t *r, const uint8_t **frames, size_t *n);
+int32_t MLX90393_LogNext(mlx_log_reader_t *r, mlx_sample_t *sample);
+
+// REPLAY
+int32_t MLX90393_LogReplayAttach(mlx_i2c_t *dev, mlx_log_replay_t *replay, mlx_log_reader_t *reader);
+int32_t MLX90393_LogReplayWrite(mlx_i2c_t *dev, uint8_t *buf, size_t len);
+int32_t MLX90393_LogReplayRead(mlx_i2c_t *dev, uint8_t *data, size_t len);
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef MLX90393_LUT_H
+#define MLX90393_LUT_H
+
+#include <stdint.h>
+
+//LOOKUPS
+//The tables are defined once in MLX90393.c; the initialisers are macros so that the constant-index
+//accessors below (see MLX90393_profile.h) can keep a local copy that folds into immediates
+//Magnetic sensitivity [Gain (0 - 7)][Res (16 - 19)][SensXY/SensZ]
+#define MLX90393_SENSITIVITY_TABLE \
+{                                                                      \
+    /* Gain = 0 (5X) */                                                \
+    {{0.805, 1.468}, {1.610, 2.936}, {3.220, 5.872}, {6.440, 11.744}}, \
+    /* Gain = 1 (4X) */                                                \
+    {{0.644, 1.174}, {1.288, 2.349}, {2.576, 4.698}, {5.152, 9.395}},  \
+    /* Gain = 2 (3X) */                                                \
+    {{0.483, 0.881}, {0.966, 1.762}, {1.932, 3.523}, {3.864, 7.046}},  \
+    /* Gain = 3 (2.5X) */                                              \
+    {{0.403, 0.734}, {0.805, 1.468}, {1.610, 2.936}, {3.220, 5.872}},  \
+    /* Gain = 4 (2X) */                                                \
+    {{0.322, 0.587}, {0.644, 1.174}, {1.288, 2.349}, {2.576, 4.698}},  \
+    /* Gain = 5 (1.67X) */                                             \
+    {{0.268, 0.489}, {0.537, 0.979}, {1.073, 1.957}, {2.147, 3.915}},  \
+    /* Gain = 6 (1.33X) */                                             \
+    {{0.215, 0.391}, {0.429, 0.783}, {0.859, 1.566}, {1.717, 3.132}},  \
+    /* Gain = 7 (1X) */                                                \
+    {{0.161, 0.294}, {0.322, 0.587}, {0.644, 1.174}, {1.288, 2.349}}   \
+}
+
+//Same sensitivities as integers [nT/LSB], for the fixed-point conversion path
+#define MLX90393_SENSITIVITY_NT_TABLE \
+{                                                             \
+    /* Gain = 0 (5X) */                                       \
+    {{805, 1468}, {1610, 2936}, {3220, 5872}, {6440, 11744}}, \
+    /* Gain = 1 (4X) */                                       \
+    {{644, 1174}, {1288, 2349}, {2576, 4698}, {5152, 9395}},  \
+    /* Gain = 2 (3X) */                                       \
+    {{483, 881}, {966, 1762}, {1932, 3523}, {3864, 7046}},    \
+    /* Gain = 3 (2.5X) */                                     \
+    {{403, 734}, {805, 1468}, {1610, 2936}, {3220, 5872}},    \
+    /* Gain = 4 (2X) */                                       \
+    {{322, 587}, {644, 1174}, {1288, 2349}, {2576, 4698}},    \
+    /* Gain = 5 (1.67X) */                                    \
+    {{268, 489}, {537, 979}, {1073, 1957}, {2147, 3915}},     \
+    /* Gain = 6 (1.33X) */                                    \
+    {{215, 391}, {429, 783}, {859, 1566}, {1717, 3132}},      \
+    /* Gain = 7 (1X) */                                       \
+    {{161, 294}, {322, 587}, {644, 1174}, {1288, 2349}}       \
+}
+
+//Tconv for a single measurement [Filter (0 - 8)][Oversampling rate (0 - 3)]
+#define MLX90393_TCONV_TABLE \
+{                                  \
+    /* Dig_filt 0 */               \
+    {1.27, 1.84, 3.00, 5.30},      \
+    /* Dig_filt 1 */               \
+    {1.46, 2.23, 3.76, 6.84},      \
+    /* Dig_filt 2 */               \
+    {1.84, 3.00, 5.30, 9.91},      \
+    /* Dig_filt 3 */               \
+    {2.61, 4.53, 8.37, 16.05},     \
+    /* Dig_filt 4 */               \
+    {4.15, 7.60, 14.52, 28.34},    \
+    /* Dig_filt 5 */               \
+    {7.22, 13.75, 26.80, 52.92},   \
+    /* Dig_filt 6 */               \
+    {13.36, 26.04, 51.38, 102.07}, \
+    /* Dig_filt 7 */               \
+    {25.65, 50.61, 100.53, 200.37} \
+}
+
+extern const float MLX90393_Sensitivity_LookUp[8][4][2];
+extern const uint16_t MLX90393_Sensitivity_nT_LookUp[8][4][2];
+extern const float MLX90393_Tconv_LookUp[8][4];
+
+/**
+ * @brief Sensitivity for compile-time constant arguments (folds into an immediate)
+ * 
+ * @param gain Gain (0 - 7)
+ * @param res Resolution (0 - 3)
+ * @param z 0 for X / Y, 1 for Z
+ * @return float Sensitivity [uT/LSB]
+ */
+static inline float MLX90393_SensitivityConst(int gain, int res, int z){
+    static const float lut[8][4][2] = MLX90393_SENSITIVITY_TABLE;
+    return lut[gain][res][z];
+}
+
+/**
+ * @brief Tconv for compile-time constant arguments (folds into an immediate)
+ * 
+ * @param filter Digital filter (0 - 7)
+ * @param osr Oversampling rate (0 - 3)
+ * @return float Conversion time [ms]
+ */
+static inline float MLX90393_TconvConst(int filter, int osr){
+    static const float lut[8][4] = MLX90393_TCONV_TABLE;
+    return lut[filter][osr];
+}
+
+/**
+ * @brief Conversion time of the channels requested by zyxt
+ * 
+ * The table is the XYZ time. Each magnetic axis takes TCONVM = 67 + 64 * 2^OSR * (2 + 2^DIG_FILT) us and
+ * the temperature TCONVT = 67 + 192 * 2^OSR2 us; what is left of the table value is the fixed start-up time.
+ * 
+ * @param filter Digital filter (0 - 7)
+ * @param osr Oversampling rate (0 - 3)
+ * @param osr2 Temperature oversampling rate (0 - 3)
+ * @param zyxt Magnetic axes-temperature measurement setting
+ * @return uint32_t Conversion time, rounded up [us]
+ */
+static inline uint32_t MLX90393_TconvChannels_us(int filter, int osr, int osr2, uint8_t zyxt){
+    float table = MLX90393_Tconv_LookUp[filter][osr] * 1000.0f;
+    uint32_t xyz = (uint32_t) table;
+    if ((float) xyz < table) xyz++; //Round up, never read early
+    uint32_t tconvm = 67 + (64u << osr) * (2 + (1u << filter));
+    uint32_t us = xyz - 3 * tconvm;
+    for (int axis = 1; axis < 4; axis++){
+        if (zyxt & (1 << axis)) us += tconvm;
+    }
+    if (zyxt & 0x01) us += 67 + (192u << osr2);
+    return us;
+}
+
+#endif
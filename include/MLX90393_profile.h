@@ -0,0 +1,63 @@
+#ifndef MLX90393_PROFILE_H
+#define MLX90393_PROFILE_H
+
+/**
+ * @brief Compile-time configuration profiles
+ * 
+ * MLX90393_PROFILE(name, gain, res_x, res_y, res_z, filter, osr) bakes one fixed configuration into
+ * static inline functions. Scale factors, zero-field offsets and Tconv become constants, so the
+ * conversion is branch-free. The runtime API (mlx_cfg_t, MLX90393_readXYZ, ...) is unaffected:
+ * apply name##_cfg once with MLX90393_ApplySettings, then use the name##_ functions in the hot path.
+ * name##_readXYZ measures through MLX90393_MeasureXYZ (status checks, Tconv wait, ready_retries),
+ * so only the conversion is specialised; with TCMP_EN set in the shadow it decodes at run time.
+ * 
+ *   MLX90393_PROFILE(fast, MLX90393_GAIN_1X, MLX90393_RES_16, MLX90393_RES_16, MLX90393_RES_16,
+ *                    MLX90393_FILTER_1, MLX90393_OSR_0)
+ *   fast_readXYZ(dev, xyz);
+ */
+
+#include "MLX90393.h"
+#include "MLX90393_cmds.h"
+#include "MLX90393_lut.h"
+
+#define MLX90393_PROFILE_OFFSET(res) ((res) == MLX90393_RES_18 ? 0x8000 : ((res) == MLX90393_RES_19 ? 0x4000 : 0))
+
+#define MLX90393_PROFILE(name, g, res_x, res_y, res_z, filt, osr)                                             \
+static const mlx_cfg_t __attribute__((unused)) name##_cfg = {                                                 \
+    .gain = (g),       .resolution_x = (res_x), .resolution_y = (res_y), .resolution_z = (res_z),             \
+    .filter = (filt), .oversampling = (osr)                                                                   \
+};                                                                                                            \
+                                                                                                              \
+static inline uint32_t name##_tconv_us(void){                                                                 \
+    const float tconv = MLX90393_TconvConst((filt), (osr)) * 1000.0f;                                         \
+    return (uint32_t) tconv + ((float) (uint32_t) tconv < tconv);                                             \
+}                                                                                                             \
+                                                                                                              \
+static inline void name##_convertXYZ(const uint8_t *data, float *xyz){                                        \
+    xyz[0] = (float) (int16_t) (uint16_t) (((data[0] << 8) | data[1]) - MLX90393_PROFILE_OFFSET(res_x))       \
+             * MLX90393_SensitivityConst((g), (res_x), 0);                                                    \
+    xyz[1] = (float) (int16_t) (uint16_t) (((data[2] << 8) | data[3]) - MLX90393_PROFILE_OFFSET(res_y))       \
+             * MLX90393_SensitivityConst((g), (res_y), 0);                                                    \
+    xyz[2] = (float) (int16_t) (uint16_t) (((data[4] << 8) | data[5]) - MLX90393_PROFILE_OFFSET(res_z))       \
+             * MLX90393_SensitivityConst((g), (res_z), 1);                                                    \
+}                                                                                                             \
+                                                                                                              \
+static inline int32_t name##_readXYZ(mlx_i2c_t *dev, float *xyz){                                             \
+    uint8_t data[6];                                                                                          \
+    int32_t ret = MLX90393_MeasureXYZ(dev, data);                                                             \
+    if (ret != 0){                                                                                            \
+        return ret;                                                                                           \
+    }                                                                                                         \
+    if (MLX90393_TcmpEnabled(dev)){ /* TCMP_EN moves the RES_16/RES_17 zero, decode at run time */            \
+        mlx_sample_t sample;                                                                                  \
+        MLX90393_convert(&name##_cfg, 1, MLX90393_MAG_XYZ, data, &sample);                                    \
+        xyz[0] = sample.xyz[0];                                                                               \
+        xyz[1] = sample.xyz[1];                                                                               \
+        xyz[2] = sample.xyz[2];                                                                               \
+        return 0;                                                                                             \
+    }                                                                                                         \
+    name##_convertXYZ(data, xyz);                                                                             \
+    return 0;                                                                                                 \
+}
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef MLX90393_SCHED_H
+#define MLX90393_SCHED_H
+
+#include "MLX90393.h"
+
+#ifndef MLX90393_SCHED_MAX_DEVICES
+#define MLX90393_SCHED_MAX_DEVICES 8
+#endif
+#ifndef MLX90393_SCHED_MAX_RETRIES
+#define MLX90393_SCHED_MAX_RETRIES 4 //Reads of a device still not ready after its deadline before it is dropped
+#endif
+
+typedef struct mlx_sched_slot_t mlx_sched_slot_t;
+typedef struct mlx_sched_t mlx_sched_t;
+typedef struct mlx_snapshot_t mlx_snapshot_t;
+
+typedef void (*mlx_sched_cb)(void *ctx, size_t idx, const float *xyz); //Sample delivery for device idx
+
+/**
+ * @brief Per-device scheduling state
+ * 
+ */
+struct mlx_sched_slot_t{
+    mlx_i2c_t *dev;
+    uint32_t period_us; //Rate target (0 = as fast as possible)
+    uint64_t next_due_us;
+    uint32_t samples;
+    uint32_t errors;
+};
+
+/**
+ * @brief Bus scheduler interleaving conversions of several devices sharing one bus
+ * 
+ */
+struct mlx_sched_t{
+    mlx_sched_slot_t slots[MLX90393_SCHED_MAX_DEVICES];
+    size_t count;
+    size_t first; //Device started first in the next round (rotates for fairness)
+    mlx_clock_ptr clock_us;
+    mlx_udelay_ptr udelay;
+    mlx_sched_cb on_sample;
+    void *ctx;
+};
+
+/**
+ * @brief Time-aligned XYZ frame of every device of a scheduler (MLX90393_SchedSnapshot)
+ * 
+ */
+struct mlx_snapshot_t{
+    mlx_sample_t samples[MLX90393_SCHED_MAX_DEVICES]; //Indexed like the scheduler slots
+    uint32_t valid; //Bit i set if samples[i] holds a measurement
+    uint64_t t_trigger_us; //First SM acknowledged
+    uint32_t skew_us; //Between the first and the last SM acknowledged
+};
+
+int32_t MLX90393_SchedInit(mlx_sched_t *sched, mlx_clock_ptr clock_us, mlx_udelay_ptr udelay, mlx_sched_cb on_sample, void *ctx);
+int32_t MLX90393_SchedAdd(mlx_sched_t *sched, mlx_i2c_t *dev, uint32_t period_us);
+int32_t MLX90393_SchedRound(mlx_sched_t *sched, uint32_t *collected);
+int32_t MLX90393_SchedRun(mlx_sched_t *sched, uint32_t rounds);
+uint64_t MLX90393_SchedNextDue(const mlx_sched_t *sched);
+int32_t MLX90393_SchedSnapshot(mlx_sched_t *sched, mlx_snapshot_t *snap);
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef MLX90393_SIM_H
+#define MLX90393_SIM_H
+
+#include "MLX90393.h"
+
+//Volatile RAM words addressable with RR/WR (customer area)
+#define MLX90393_SIM_NUM_REGS 0x20
+
+typedef struct mlx_sim_t mlx_sim_t;
+
+/**
+ * @brief Extra field of a simulated sensor on top of the static field and the sine waveform
+ * 
+ * @param ctx User context
+ * @param axis 0 = X, 1 = Y, 2 = Z
+ * @param t_us Virtual time of the conversion [us]
+ * @return float Field [uT]
+ */
+typedef float (*mlx_sim_field_ptr)(void *ctx, int axis, uint64_t t_us);
+
+/**
+ * @brief Behavioural model of one MLX90393 (pointed to by mlx_i2c_t.handle)
+ * 
+ * Field seen by the sensor on each axis: field + sine_amp * sin(2 pi sine_hz t) + waveform() + N(0, noise_uT)
+ */
+struct mlx_sim_t{
+    uint16_t regs[MLX90393_SIM_NUM_REGS]; //Volatile RAM
+    uint16_t nvram[MLX90393_SIM_NUM_REGS]; //Non-volatile memory (HS / HR, loaded on reset)
+    //Stimulus
+    float field[3]; //Static field [uT]
+    float sine_amp[3]; //Sine amplitude [uT]
+    float sine_hz;
+    float noise_uT; //Gaussian noise standard deviation [uT]
+    float temp_degc;
+    mlx_sim_field_ptr waveform; //[Optional]
+    void *ctx;
+    uint32_t seed; //Noise generator state, must not be 0
+    //Bus
+    uint32_t byte_us; //Virtual bus time per byte, address byte included (0 = instantaneous)
+    uint32_t nack_next; //Fault injection: the next n transactions fail
+    uint32_t sed_next; //Fault injection: the next n status bytes report SED
+    uint32_t transactions;
+    uint64_t bytes_written;
+    uint64_t bytes_read;
+    //Device state
+    uint8_t mode; //MLX90393_STATUS_BURST / WOC / SM or 0 when idle
+    char zyxt; //Channels of the active measurement
+    uint8_t reset; //RS still to be reported
+    uint8_t data_ready;
+    uint64_t ready_us; //Completion time of the conversion in progress
+    uint32_t period_us; //Burst / WOC conversion period
+    uint16_t result[4]; //Latched T, X, Y, Z
+    uint16_t woc_ref[4]; //WOC reference measurement
+    uint8_t response[9];
+    size_t response_len;
+};
+
+// SETUP
+int32_t MLX90393_SimInit(mlx_sim_t *sim);
+int32_t MLX90393_SimAttach(mlx_i2c_t *dev, mlx_sim_t *sim);
+void MLX90393_SimGlitch(mlx_sim_t *sim);
+
+// VIRTUAL TIME (one timeline per thread, shared by every simulated device of that thread)
+uint64_t MLX90393_SimClock(void);
+void MLX90393_SimSetClock(uint64_t t_us);
+void MLX90393_SimUdelay(uint32_t us);
+void MLX90393_SimMdelay(uint32_t ms);
+
+// TRANSPORT HOOKS
+int32_t MLX90393_SimWrite(mlx_i2c_t *dev, uint8_t *buf, size_t len);
+int32_t MLX90393_SimRead(mlx_i2c_t *dev, uint8_t *data, size_t len);
+int32_t MLX90393_SimTransfer(mlx_i2c_t *dev, uint8_t *wbuf, size_t wlen, uint8_t *rbuf, size_t rlen);
+int32_t MLX90393_SimDataReady(mlx_i2c_t *dev);
+
+#endif
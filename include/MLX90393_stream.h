@@ -0,0 +1,51 @@
+#ifndef MLX90393_STREAM_H
+#define MLX90393_STREAM_H
+
+#include <stdatomic.h>
+#include "MLX90393.h"
+
+#ifndef MLX90393_STREAM_MAX_MISSES
+#define MLX90393_STREAM_MAX_MISSES 8 //Consecutive periods without new data before MLX90393_StreamRun gives up
+#endif
+
+typedef struct mlx_ring_t mlx_ring_t;
+typedef struct mlx_stream_t mlx_stream_t;
+
+/**
+ * @brief Single-producer/single-consumer lock-free sample ring buffer
+ * 
+ */
+struct mlx_ring_t{
+    mlx_sample_t *buffer;
+    size_t mask;
+    atomic_size_t head; //Only written by the producer
+    atomic_size_t tail; //Only written by the consumer
+};
+
+/**
+ * @brief Burst-mode streaming state of one MLX90393 device
+ * 
+ */
+struct mlx_stream_t{
+    mlx_i2c_t *dev;
+    mlx_ring_t *ring;
+    char zyxt; //Channels streamed (MLX90393_MAG_XYZ by default)
+    atomic_uchar running; //Cleared by MLX90393_StreamStop (any thread); EX is only sent by the producer
+    uint32_t dropped;
+};
+
+// RING BUFFER
+int32_t MLX90393_RingInit(mlx_ring_t *ring, mlx_sample_t *buffer, size_t capacity);
+int32_t MLX90393_RingPush(mlx_ring_t *ring, const mlx_sample_t *sample);
+int32_t MLX90393_RingPop(mlx_ring_t *ring, mlx_sample_t *sample);
+size_t MLX90393_RingCount(mlx_ring_t *ring);
+
+// STREAMING
+int32_t MLX90393_StreamInit(mlx_stream_t *stream, mlx_i2c_t *dev, mlx_ring_t *ring);
+int32_t MLX90393_StreamStart(mlx_stream_t *stream);
+int32_t MLX90393_StreamPoll(mlx_stream_t *stream);
+int32_t MLX90393_StreamRun(mlx_stream_t *stream, uint32_t samples);
+int32_t MLX90393_StreamStop(mlx_stream_t *stream);
+int32_t MLX90393_StreamFinish(mlx_stream_t *stream);
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef MLX90393_WOC_H
+#define MLX90393_WOC_H
+
+#include <stdatomic.h>
+#include "MLX90393.h"
+
+typedef struct mlx_woc_t mlx_woc_t;
+
+typedef int32_t (*mlx_drdy_ptr)(mlx_i2c_t *dev); //Level of the INT (data ready) pin, non-zero when asserted
+typedef void (*mlx_woc_cb)(void *ctx, const mlx_sample_t *sample); //Field change event
+
+/**
+ * @brief Wake-On-Change state of one MLX90393 device
+ * 
+ */
+struct mlx_woc_t{
+    mlx_i2c_t *dev;
+    mlx_drdy_ptr drdy;
+    mlx_woc_cb on_change;
+    void *ctx;
+    atomic_uint_fast8_t irq; //Set from interrupt context by MLX90393_WOCNotify
+    uint8_t armed;
+    uint32_t events;
+};
+
+int32_t MLX90393_WOCInit(mlx_woc_t *woc, mlx_i2c_t *dev, mlx_drdy_ptr drdy, mlx_woc_cb on_change, void *ctx);
+int32_t MLX90393_WOCArm(mlx_woc_t *woc, float xy_threshold, float z_threshold, uint16_t t_threshold, uint8_t diff_mode);
+void MLX90393_WOCNotify(mlx_woc_t *woc);
+int32_t MLX90393_WOCService(mlx_woc_t *woc);
+int32_t MLX90393_WOCDisarm(mlx_woc_t *woc);
+
+#endif
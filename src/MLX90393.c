@@ -1,5 +1,7 @@
 #include "MLX90393.h"
 #include "MLX90393_cmds.h"
+#include "MLX90393_lut.h"
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -12,6 +14,7 @@ int32_t __attribute__((weak)) ApplySettings(mlx_i2c_t *dev, mlx_cfg_t *settings)
     return MLX90393_ApplySettings(dev, settings);
 }
 
+#ifndef MLX90393_STATIC_ALLOC
 void * __attribute__((weak)) mlx_malloc(size_t s){
     return malloc(s);
 }
@@ -19,49 +22,36 @@ void * __attribute__((weak)) mlx_malloc(size_t s){
 void __attribute__((weak)) mlx_free(void * memory){
     return free(memory);
 }
+#endif
+
+#ifdef MLX90393_STATIC_ALLOC
+static mlx_i2c_t mlx_pool[MLX90393_STATIC_POOL_SIZE];
+static uint8_t mlx_pool_used[MLX90393_STATIC_POOL_SIZE];
+#endif
 
-//LOOKUPS
-//Magnetic sensitivity [Gain (0 - 7)][Res (16 - 19)][SensXY/SensZ]
-const float MLX90393_Sensitivity_LookUp[8][4][2] = {
-    //Gain = 0 (5X)
-    {{0.805, 1.468}, {1.610, 2.936}, {3.220, 5.872}, {6.440, 11.744}},
-    //Gain = 1 (4X)
-    {{0.644, 1.174}, {1.288, 2.349}, {2.576, 4.698}, {5.152, 9.395}},
-    //Gain = 2 (3X)
-    {{0.483, 0.881}, {0.966, 1.762}, {1.932, 3.523}, {3.864, 7.046}},
-    //Gain = 3 (2.5X)
-    {{0.403, 0.734}, {0.805, 1.468}, {1.610, 2.936}, {3.220, 5.872}},
-    //Gain = 4 (2X)
-    {{0.322, 0.587}, {0.644, 1.174}, {1.288, 2.349}, {2.576, 4.698}},
-    //Gain = 5 (1.67X)
-    {{0.268, 0.489}, {0.537, 0.979}, {1.073, 1.957}, {2.147, 3.915}},
-    //Gain = 6 (1.33X)
-    {{0.215, 0.391}, {0.429, 0.783}, {0.859, 1.566}, {1.717, 3.132}},
-    //Gain = 7 (1X)
-    {{0.161, 0.294}, {0.322, 0.587}, {0.644, 1.174}, {1.288, 2.349}}
-};
-
-//Tconv for a single measurement [Filter (0 - 8)][Oversampling rate (0 - 3)]
-const float MLX90393_Tconv_LookUp[8][4] = {
-    //Dig_filt 0
-    {1.27, 1.84, 3.00, 5.30},
-    //Dig_filt 1
-    {1.46, 2.23, 3.76, 6.84},
-    //Dig_filt 2
-    {1.84, 3.00, 5.30, 9.91},
-    //Dig_filt 3
-    {2.61, 4.53, 8.37, 16.05},
-    //Dig_filt 4
-    {4.15, 7.60, 14.52, 28.34},
-    //Dig_filt 5
-    {7.22, 13.75, 26.80, 52.92},
-    //Dig_filt 6
-    {13.36, 26.04, 51.38, 102.07},
-    //Dig_filt 7
-    {25.65, 50.61, 100.53, 200.37}
-};
 //GCOV_EXCL_STOP
+//LOOKUPS (see MLX90393_lut.h)
+const float MLX90393_Sensitivity_LookUp[8][4][2] = MLX90393_SENSITIVITY_TABLE;
+const uint16_t MLX90393_Sensitivity_nT_LookUp[8][4][2] = MLX90393_SENSITIVITY_NT_TABLE;
+const float MLX90393_Tconv_LookUp[8][4] = MLX90393_TCONV_TABLE;
+
 /** Helper functions**/
+/**
+ * @brief Storage for the settings of a device: heap in the default build, the
+ * structure embedded in the device with MLX90393_STATIC_ALLOC
+ * 
+ * @param dev Handle to MLX90393 device
+ * @return mlx_cfg_t* Settings storage (NULL if the allocation fails)
+ */
+static mlx_cfg_t *MLX90393_SettingsStorage(mlx_i2c_t *dev){
+#ifdef MLX90393_STATIC_ALLOC
+    return &dev->settings_storage;
+#else
+    (void) dev;
+    return (mlx_cfg_t *) mlx_malloc(sizeof(mlx_cfg_t));
+#endif
+}
+
 uint8_t count_set_bits(uint8_t zyxt){
     uint8_t result = 0;
     while(zyxt){ //Mientras haya al menos un 1
@@ -74,6 +64,159 @@ uint8_t count_set_bits(uint8_t zyxt){
     return result;
 }
 
+#ifdef MLX90393_STATS
+/**
+ * @brief Account a command in the device statistics and pass it to the trace hook
+ * 
+ * SM and RM are also paired up to time the sample latency when the clock_us hook is set.
+ * 
+ * @param dev Handle to MLX90393 device
+ * @param writeBuffer Command bytes
+ * @param writeLen Number of command bytes
+ * @param readBuffer Response (status byte first)
+ * @param readLen Number of response bytes
+ * @param ret Transport result
+ */
+static void MLX90393_StatCommand(mlx_i2c_t *dev, const uint8_t *writeBuffer, size_t writeLen,
+                                 const uint8_t *readBuffer, size_t readLen, int32_t ret){
+    mlx_stats_t *stats = &dev->stats;
+    uint8_t opcode = writeBuffer[0] >> 4;
+    stats->commands[opcode]++;
+    if (ret != 0){
+        stats->bus_errors++;
+    } else {
+        uint8_t status = readBuffer[0];
+        stats->bytes_out += writeLen;
+        stats->bytes_in += readLen;
+        stats->status_error += (status & MLX90393_STATUS_ERROR) != 0;
+        stats->status_sed += (status & MLX90393_STATUS_SED) != 0;
+        stats->status_rs += (status & MLX90393_STATUS_RS) != 0;
+        if (dev->clock_us != NULL && !(status & MLX90393_STATUS_ERROR)){
+            if (opcode == 0x3){
+                stats->sm_us = dev->clock_us();
+                stats->sm_timed = 1;
+            } else if (opcode == 0x4 && stats->sm_timed){
+                uint32_t latency = (uint32_t) (dev->clock_us() - stats->sm_us);
+                if (stats->samples == 0 || latency < stats->latency_min_us) stats->latency_min_us = latency;
+                if (latency > stats->latency_max_us) stats->latency_max_us = latency;
+                stats->latency_sum_us += latency;
+                stats->samples++;
+                stats->sm_timed = 0;
+            }
+        }
+    }
+    if (dev->trace != NULL){
+        dev->trace(dev->trace_ctx, dev, writeBuffer, writeLen, readBuffer, ret == 0 ? readLen : 0, ret);
+    }
+}
+
+#define MLX90393_StatWait(dev, us) ((dev)->stats.wait_us += (us))
+#define MLX90393_StatRecovery(dev) ((dev)->stats.recoveries++)
+#else
+//Compiled out: the hot path pays nothing
+#define MLX90393_StatCommand(dev, writeBuffer, writeLen, readBuffer, readLen, ret) ((void) 0)
+#define MLX90393_StatWait(dev, us) ((void) 0)
+#define MLX90393_StatRecovery(dev) ((void) 0)
+#endif
+
+/**
+ * @brief Send a command and read its response, in one combined transaction when the transfer hook is available
+ * 
+ * @param dev Handle to MLX90393 device
+ * @param writeBuffer Command bytes
+ * @param writeLen Number of command bytes
+ * @param readBuffer Buffer for the response (status byte first)
+ * @param readLen Number of response bytes
+ * @return int32_t Error code
+ */
+static int32_t MLX90393_Exchange(mlx_i2c_t *dev, uint8_t *writeBuffer, size_t writeLen, uint8_t *readBuffer, size_t readLen){
+    int32_t ret;
+    if (dev->transfer != NULL){
+        ret = dev->transfer(dev, writeBuffer, writeLen, readBuffer, readLen);
+    } else {
+        ret = dev->write_function(dev, writeBuffer, writeLen);
+        if (ret == 0){
+            ret = dev->read_function(dev, readBuffer, readLen);
+        }
+    }
+    MLX90393_StatCommand(dev, writeBuffer, writeLen, readBuffer, readLen, ret);
+    return ret;
+}
+
+/**
+ * @brief Bring a device that reset behind the driver's back to the state the driver expects
+ * 
+ * The volatile registers are back to their non-volatile values: every register known to the
+ * shadow copy is written again, then the burst / WOC mode in effect is restarted.
+ * 
+ * @param dev Handle to MLX90393 device
+ * @param opcode Command that reported the reset (upper nibble)
+ * @return int32_t Error code
+ */
+static int32_t MLX90393_Recover(mlx_i2c_t *dev, uint8_t opcode){
+    int32_t ret;
+    uint8_t status;
+    uint8_t burst_cmd = dev->burst_cmd;
+    uint16_t valid = dev->regs_valid;
+
+    ret = MLX90393_EX(dev, &status);
+    if (ret != 0){
+        return ret;
+    }
+    if (status & MLX90393_STATUS_ERROR){
+        return MLX90393_MISMATCH;
+    }
+    dev->regs_valid = 0;
+    for (int reg = 0; reg < MLX90393_NUM_REGS; reg++){
+        if (valid & (1 << reg)){
+            ret = MLX90393_WR(dev, &status, reg, dev->regs[reg]);
+            if (ret != 0){
+                return ret;
+            }
+            if (status & MLX90393_STATUS_ERROR){
+                return MLX90393_MISMATCH;
+            }
+        }
+    }
+    if (burst_cmd != 0 && opcode != 0x10 && opcode != 0x20 && opcode != 0x80){
+        ret = MLX90393_Exchange(dev, &burst_cmd, 1, &status, 1);
+        if (ret == 0 && !(status & MLX90393_STATUS_ERROR)){
+            dev->burst_cmd = burst_cmd;
+        }
+    }
+    return ret;
+}
+
+/**
+ * @brief Exchange a command and apply the recovery policy to its status byte
+ * 
+ * @param dev Handle to MLX90393 device
+ * @param writeBuffer Command bytes
+ * @param writeLen Number of command bytes
+ * @param readBuffer Buffer for the response (status byte first)
+ * @param readLen Number of response bytes
+ * @return int32_t Error code
+ */
+static int32_t MLX90393_Command(mlx_i2c_t *dev, uint8_t *writeBuffer, size_t writeLen, uint8_t *readBuffer, size_t readLen){
+    int32_t ret = MLX90393_Exchange(dev, writeBuffer, writeLen, readBuffer, readLen);
+    if (ret != 0 || dev->recovery == 0 || dev->recovering){
+        return ret;
+    }
+    uint8_t opcode = writeBuffer[0] & 0xF0;
+    if ((dev->recovery & MLX90393_RECOVER_RESET) && (readBuffer[0] & MLX90393_STATUS_RS) && opcode != 0xF0){
+        dev->recovering = 1;
+        ret = MLX90393_Recover(dev, opcode);
+        dev->recovering = 0;
+        if (ret != 0){
+            return ret;
+        }
+    } else if (!((dev->recovery & MLX90393_RECOVER_SED) && (readBuffer[0] & MLX90393_STATUS_SED))){
+        return ret;
+    }
+    MLX90393_StatRecovery(dev);
+    return MLX90393_Exchange(dev, writeBuffer, writeLen, readBuffer, readLen);
+}
+
 //COMMANDS
 /**
  * @brief Exit function
@@ -86,11 +229,10 @@ uint8_t count_set_bits(uint8_t zyxt){
 int32_t MLX90393_EX(mlx_i2c_t *dev, uint8_t *statusBuffer){
     int32_t ret = 0;
     uint8_t writeBuffer = 0x80;
-    ret = dev->write_function(dev, &writeBuffer, 1);
-    if (ret != 0){
-        return ret;
+    ret = MLX90393_Command(dev, &writeBuffer, 1, statusBuffer, 1);
+    if (ret == 0){
+        dev->burst_cmd = 0;
     }
-    ret = dev->read_function(dev, statusBuffer, 1);
     return ret;
 }
 
@@ -105,11 +247,10 @@ int32_t MLX90393_EX(mlx_i2c_t *dev, uint8_t *statusBuffer){
 int32_t MLX90393_SB(mlx_i2c_t *dev, char zyxt, uint8_t *statusBuffer){
     int32_t ret = 0;
     uint8_t writeBuffer = (0x10)|(zyxt); // 0001 zxyt
-    ret = dev->write_function(dev, &writeBuffer, 1);
-    if (ret != 0){
-        return ret;
+    ret = MLX90393_Command(dev, &writeBuffer, 1, statusBuffer, 1);
+    if (ret == 0 && !(*statusBuffer & MLX90393_STATUS_ERROR)){
+        dev->burst_cmd = writeBuffer; //Remembered for the recovery policy
     }
-    ret = dev->read_function(dev, statusBuffer, 1);
     return ret;
 }
 
@@ -125,11 +266,10 @@ int32_t MLX90393_SWOC(mlx_i2c_t *dev, char zyxt, uint8_t *statusBuffer){
     int32_t ret = 0;
     uint8_t writeBuffer = (0x20)|(zyxt);
      // 0010 zxyt
-    ret = dev->write_function(dev, &writeBuffer, 1);
-    if (ret != 0){
-        return ret;
+    ret = MLX90393_Command(dev, &writeBuffer, 1, statusBuffer, 1);
+    if (ret == 0 && !(*statusBuffer & MLX90393_STATUS_ERROR)){
+        dev->burst_cmd = writeBuffer; //Remembered for the recovery policy
     }
-    ret = dev->read_function(dev, statusBuffer, 1);
     return ret;
 }
 
@@ -144,11 +284,7 @@ int32_t MLX90393_SWOC(mlx_i2c_t *dev, char zyxt, uint8_t *statusBuffer){
 int32_t MLX90393_SM(mlx_i2c_t *dev, char zyxt, uint8_t *statusBuffer){
     int32_t ret = 0;
     uint8_t writeBuffer = (0x30) | (zyxt);
-    ret = dev->write_function(dev, &writeBuffer, 1);
-    if (ret != 0){
-        return ret;
-    }
-    ret = dev->read_function(dev, statusBuffer, 1);
+    ret = MLX90393_Command(dev, &writeBuffer, 1, statusBuffer, 1);
     return ret;
 }
 
@@ -170,12 +306,10 @@ int32_t MLX90393_RM(mlx_i2c_t *dev, char zyxt, uint8_t *statusBuffer, uint8_t *d
     uint8_t receiveBuffer[1 + 2*databytes];
 
     writeBuffer[0] = (0x40) | (zyxt);
-    ret = dev->write_function(dev, writeBuffer, 1); 
-    //Check if I shall need to write 1 + 2*databytes in order to receive all the measurements in the w-r fashion
+    ret = MLX90393_Command(dev, writeBuffer, 1, receiveBuffer, 1 + 2 * databytes);
     if (ret != 0){
         return ret;
     }
-    ret = dev->read_function(dev, receiveBuffer, 1 + 2 * databytes);
     *statusBuffer = receiveBuffer[0];
     for (int i = 1; i < sizeof(receiveBuffer); i++) {
         dataBuffer[i - 1] = receiveBuffer[i];
@@ -197,14 +331,17 @@ int32_t MLX90393_RR(mlx_i2c_t *dev, uint8_t *statusBuffer, int reg_addr, uint8_t
     uint8_t receiveBuffer[3];
     writeBuffer[0] = 0x50;
     writeBuffer[1] = reg_addr << 2;
-    ret = dev->write_function(dev, writeBuffer, 2);
+    ret = MLX90393_Command(dev, writeBuffer, 2, receiveBuffer, 3);
     if (ret != 0){
         return ret;
     }
-    ret = dev->read_function(dev, receiveBuffer, 3);
     *statusBuffer = receiveBuffer[0];
     dataBuffer[0] = receiveBuffer[1];
     dataBuffer[1] = receiveBuffer[2];
+    if (reg_addr >= 0 && reg_addr < MLX90393_NUM_REGS && !(receiveBuffer[0] & MLX90393_STATUS_ERROR)){ //Keep the shadow copy up to date
+        dev->regs[reg_addr] = receiveBuffer[1] << 8 | receiveBuffer[2];
+        dev->regs_valid |= 1 << reg_addr;
+    }
     return ret;
 }
 
@@ -226,11 +363,18 @@ int32_t MLX90393_WR(mlx_i2c_t *dev, uint8_t *statusBuffer, int reg_addr, int dat
     writeBuffer[2] = data & 0x00FF; //I take the least significant bits
     writeBuffer[3] = reg_addr << 2;
 
-    ret = dev->write_function(dev, writeBuffer, 4);
-    if (ret != 0){
-        return ret;
+    ret = MLX90393_Command(dev, writeBuffer, 4, statusBuffer, 1);
+    if (reg_addr >= 0 && reg_addr < MLX90393_NUM_REGS){
+        if (ret == 0 && !(*statusBuffer & MLX90393_STATUS_ERROR)){
+            dev->regs[reg_addr] = data & 0xFFFF;
+            dev->regs_valid |= 1 << reg_addr;
+            if (reg_addr <= MLX90393_REG_CONF3){
+                dev->cfg_gen++;
+            }
+        } else {
+            dev->regs_valid &= ~(1 << reg_addr); //Unknown register contents after a failed write
+        }
     }
-    ret = dev->read_function(dev, statusBuffer, 1);
     return ret;
 
 }
@@ -245,11 +389,9 @@ int32_t MLX90393_WR(mlx_i2c_t *dev, uint8_t *statusBuffer, int reg_addr, int dat
 int32_t MLX90393_HR(mlx_i2c_t *dev, uint8_t *statusBuffer){
     int32_t ret = 0;
     uint8_t writeBuffer = 0xD0;
-    ret = dev->write_function(dev, &writeBuffer, 1);
-    if (ret != 0){
-        return ret;
-    }
-    ret = dev->read_function(dev, statusBuffer, 1);
+    dev->regs_valid = 0; //The volatile registers are overwritten
+    dev->cfg_gen++;
+    ret = MLX90393_Command(dev, &writeBuffer, 1, statusBuffer, 1);
     return ret;
 }
 
@@ -264,11 +406,7 @@ int32_t MLX90393_HR(mlx_i2c_t *dev, uint8_t *statusBuffer){
 int32_t MLX90393_HS(mlx_i2c_t *dev, uint8_t *statusBuffer){
     int32_t ret = 0;
     uint8_t writeBuffer = 0xE0;
-    ret = dev->write_function(dev, &writeBuffer, 1);
-    if (ret != 0){
-        return ret;
-    }
-    ret = dev->read_function(dev, statusBuffer, 1);
+    ret = MLX90393_Command(dev, &writeBuffer, 1, statusBuffer, 1);
     return ret;
 }
 
@@ -283,11 +421,10 @@ int32_t MLX90393_RT(mlx_i2c_t *dev, uint8_t *statusBuffer){
     int32_t ret = 0;
     uint8_t writeBuffer = 0xF0;
 
-    ret = dev->write_function(dev, &writeBuffer, 1);
-    if (ret != 0){
-        return ret;
-    }
-    ret = dev->read_function(dev, statusBuffer, 1);
+    dev->regs_valid = 0; //The volatile registers are overwritten
+    dev->cfg_gen++;
+    dev->burst_cmd = 0;
+    ret = MLX90393_Command(dev, &writeBuffer, 1, statusBuffer, 1);
     return ret;
 }
 
@@ -302,17 +439,129 @@ int32_t MLX90393_NOP(mlx_i2c_t *dev, uint8_t *statusBuffer){
     int32_t ret = 0;
     uint8_t writeBuffer = 0x00;
 
-    ret = dev->write_function(dev, &writeBuffer, 1);
+    ret = MLX90393_Command(dev, &writeBuffer, 1, statusBuffer, 1);
+    return ret;
+}
+
+//USER FUNCTIONS
+/**
+ * @brief Read a register through the shadow copy (bus access only if not cached)
+ * 
+ * @param dev Handle to MLX90393 device
+ * @param reg_addr Address of the register
+ * @param value Where to store the register contents
+ * @return int32_t Error code (MLX90393_MISMATCH if the device rejected the read)
+ */
+static int32_t MLX90393_ReadShadow(mlx_i2c_t *dev, int reg_addr, uint16_t *value){
+    if (dev->regs_valid & (1 << reg_addr)){
+        *value = dev->regs[reg_addr];
+        return 0;
+    }
+    uint8_t status;
+    uint8_t databuffer[2];
+    int32_t ret = MLX90393_RR(dev, &status, reg_addr, databuffer);
     if (ret != 0){
         return ret;
     }
-    ret = dev->read_function(dev, statusBuffer, 1);
+    if (status & MLX90393_STATUS_ERROR){
+        return MLX90393_MISMATCH;
+    }
+    *value = dev->regs[reg_addr];
+    return 0;
+}
+
+/**
+ * @brief Write a register only if its contents change
+ * 
+ * @param dev Handle to MLX90393 device
+ * @param reg_addr Address of the register
+ * @param value New register contents
+ * @return int32_t Error code (MLX90393_MISMATCH if the device rejected the write)
+ */
+static int32_t MLX90393_WriteShadow(mlx_i2c_t *dev, int reg_addr, uint16_t value){
+    if ((dev->regs_valid & (1 << reg_addr)) && dev->regs[reg_addr] == value){
+        return 0;
+    }
+    uint8_t status;
+    int32_t ret = MLX90393_WR(dev, &status, reg_addr, value);
+    if (ret == 0 && (status & MLX90393_STATUS_ERROR)){
+        return MLX90393_MISMATCH;
+    }
     return ret;
 }
 
-//USER FUNCTIONS
 /**
- * @brief Get current settings of sensor by reading 0x00 and 0x02 registers
+ * @brief Insert the mlx_cfg_t fields of CONF1 (GAIN_SEL) into a register value
+ * 
+ * @param conf Current CONF1 contents
+ * @param cfg Settings to insert
+ * @return uint16_t New CONF1 contents
+ */
+static uint16_t MLX90393_PackConf1(uint16_t conf, const mlx_cfg_t *cfg){
+    conf &= ~0x0070; //AND with an all - 1 word but the bits I want to reset
+    conf |= (int) cfg->gain << 4; //Recast the enum as an int and shift to the correct positions
+    return conf;
+}
+
+/**
+ * @brief Insert the mlx_cfg_t fields of CONF3 (OSR, DIG_FILT, RES_XYZ) into a register value
+ * 
+ * @param conf Current CONF3 contents
+ * @param cfg Settings to insert
+ * @return uint16_t New CONF3 contents
+ */
+static uint16_t MLX90393_PackConf3(uint16_t conf, const mlx_cfg_t *cfg){
+    conf &= ~0x07FF;
+    conf |= (int) cfg->oversampling;
+    conf |= (int) cfg->filter << 2;
+    conf |= (int) cfg->resolution_x << 5;
+    conf |= (int) cfg->resolution_y << 7;
+    conf |= (int) cfg->resolution_z << 9;
+    return conf;
+}
+
+/**
+ * @brief Read the whole volatile register map into the shadow copy
+ * 
+ * @param dev Handle to MLX90393 device
+ * @return int32_t Error code (MLX90393_MISMATCH if the device rejected a read)
+ */
+int32_t MLX90393_SyncRegisters(mlx_i2c_t *dev){
+    if (dev == NULL){
+        return 1;
+    }
+    int32_t ret;
+    uint8_t status;
+    uint8_t databuffer[2];
+    dev->regs_valid = 0;
+    for (int reg = 0; reg < MLX90393_NUM_REGS; reg++){
+        ret = MLX90393_RR(dev, &status, reg, databuffer);
+        if (ret != 0){
+            return ret; //First failure wins, the rest of the map is not read
+        }
+        if (status & MLX90393_STATUS_ERROR){
+            return MLX90393_MISMATCH;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Forget the shadow copy, e.g. after the registers were changed behind the driver's back
+ * 
+ * @param dev Handle to MLX90393 device
+ */
+void MLX90393_InvalidateRegisters(mlx_i2c_t *dev){
+    if (dev != NULL){
+        dev->regs_valid = 0;
+    }
+}
+
+/**
+ * @brief Get current settings of sensor from CONF1 and CONF3
+ * 
+ * Only registers missing from the shadow are read (at most 2 RR); call MLX90393_SyncRegisters
+ * first to force a fresh read of the whole map.
  * 
  * @param dev Handle to MLX90393 device
  * @return int32_t Error code
@@ -323,27 +572,32 @@ int32_t MLX90393_GetSettings(mlx_i2c_t *dev){
     }
 
     int32_t ret;
-    uint8_t status;
-    uint8_t databuffer[2];
 
     if(dev->settings == NULL){
-        dev->settings = (mlx_cfg_t *) mlx_malloc(sizeof(mlx_cfg_t));
+        dev->settings = MLX90393_SettingsStorage(dev);
 
         if (dev->settings == NULL) return -1;
     }
 
     //Get current settings
-    //Read Conf1
-    ret = MLX90393_RR(dev, &status, MLX90393_REG_CONF1, databuffer);
-    dev->settings->gain = (mlx90393_gain_t) (databuffer[1] >> 4) & 0x07;
-    //Read Conf3
-    ret = MLX90393_RR(dev, &status, MLX90393_REG_CONF3, databuffer);
-    dev->settings->oversampling = (mlx90393_oversampling_t) databuffer[1] & 0x03;
-    dev->settings->filter = (mlx90393_filter_t) (databuffer[1] >> 2) & 0x07;
+    //Conf1
+    uint16_t conf;
+    ret = MLX90393_ReadShadow(dev, MLX90393_REG_CONF1, &conf);
+    if (ret != 0){
+        return ret;
+    }
+    dev->settings->gain = (mlx90393_gain_t) (conf >> 4) & 0x07;
+    //Conf3
+    ret = MLX90393_ReadShadow(dev, MLX90393_REG_CONF3, &conf);
+    if (ret != 0){
+        return ret;
+    }
+    dev->settings->oversampling = (mlx90393_oversampling_t) conf & 0x03;
+    dev->settings->filter = (mlx90393_filter_t) (conf >> 2) & 0x07;
     
-    dev->settings->resolution_x = (mlx90393_resolution_t) (databuffer[1] >> 5) & 0x03;
-    dev->settings->resolution_y = (mlx90393_resolution_t) ((databuffer[0] << 1) & 0x02) | databuffer[1] >> 7;
-    dev->settings->resolution_z = (mlx90393_resolution_t) (databuffer[0] >> 1) & 0x03;
+    dev->settings->resolution_x = (mlx90393_resolution_t) (conf >> 5) & 0x03;
+    dev->settings->resolution_y = (mlx90393_resolution_t) (conf >> 7) & 0x03;
+    dev->settings->resolution_z = (mlx90393_resolution_t) (conf >> 9) & 0x03;
     
     //*(dev->settings) = *settings;
     //free(settings);
@@ -364,46 +618,474 @@ int32_t MLX90393_ApplySettings(mlx_i2c_t *dev, mlx_cfg_t *new_settings){
     }
 
     int32_t ret;
-    uint8_t status;
-    uint8_t databuffer[2];
+    uint16_t conf;
 
     if(dev->settings == NULL){
-        dev->settings = (mlx_cfg_t *) mlx_malloc(sizeof(mlx_cfg_t));
+        dev->settings = MLX90393_SettingsStorage(dev);
 
         if(dev->settings == NULL) return -1; //Check the heap allocation doesn't fail
     }
     
+    //Read-modify-write against the shadow copy: only changed registers reach the bus
     //Apply CONF1 register
-    ret = MLX90393_RR(dev, &status, MLX90393_REG_CONF1, databuffer);
-    int newbuf = databuffer[0] << 8 | databuffer[1];
-    newbuf &= ~0x0070; //AND with an all - 1 word but the bits I want to reset
-    newbuf |= (int) new_settings->gain << 4; //Recast the enum as an int and shift to the correct positions
-    ret = MLX90393_WR(dev, &status, MLX90393_REG_CONF1, newbuf);
+    ret = MLX90393_ReadShadow(dev, MLX90393_REG_CONF1, &conf);
+    if (ret != 0){
+        return ret;
+    }
+    ret = MLX90393_WriteShadow(dev, MLX90393_REG_CONF1, MLX90393_PackConf1(conf, new_settings));
+    if (ret != 0){
+        return ret;
+    }
 
     //CONF3 register
-    ret = MLX90393_RR(dev, &status, MLX90393_REG_CONF3, databuffer);
-    newbuf = databuffer[0] << 8 | databuffer[1];
-    newbuf &= ~0x07FF;
-    newbuf |= (int) new_settings->oversampling;
-    newbuf |= (int) new_settings->filter << 2;
-    newbuf |= (int) new_settings->resolution_x << 5;
-    newbuf |= (int) new_settings->resolution_y << 7;
-    newbuf |= (int) new_settings->resolution_z << 9;
-    ret  = MLX90393_WR(dev, &status, MLX90393_REG_CONF3, newbuf);
+    ret = MLX90393_ReadShadow(dev, MLX90393_REG_CONF3, &conf);
+    if (ret != 0){
+        return ret;
+    }
+    ret  = MLX90393_WriteShadow(dev, MLX90393_REG_CONF3, MLX90393_PackConf3(conf, new_settings));
     //Overwrite dev settings structure with 
     *(dev->settings) = *new_settings;
     return ret;
 }
 
-int32_t MLX90393_readXYZ(mlx_i2c_t *dev, float *xyz){
+/**
+ * @brief Apply a full register configuration in one pass
+ * 
+ * Every register value is computed first; only the registers that differ from the shadow copy
+ * are written, back to back, and the batch is verified with a single read of the last written register.
+ * Reserved bits of CONF1 and CONF3 are preserved (read once if not cached yet).
+ * 
+ * @param dev Handle to MLX90393 device
+ * @param cfg Pointer to the extended configuration to apply
+ * @return int32_t Error code (MLX90393_MISMATCH if the device rejected a write or the read back differs)
+ */
+int32_t MLX90393_ApplyConfig(mlx_i2c_t *dev, const mlx_cfg_ext_t *cfg){
+    if (dev == NULL || cfg == NULL){
+        return 1;
+    }
+
+    int32_t ret;
+    uint8_t status;
+    uint16_t target[MLX90393_NUM_REGS];
+
+    if(dev->settings == NULL){
+        dev->settings = MLX90393_SettingsStorage(dev);
+
+        if(dev->settings == NULL) return -1;
+    }
+
+    ret = MLX90393_ReadShadow(dev, MLX90393_REG_CONF1, &target[MLX90393_REG_CONF1]);
+    if (ret != 0){
+        return ret;
+    }
+    ret = MLX90393_ReadShadow(dev, MLX90393_REG_CONF3, &target[MLX90393_REG_CONF3]);
+    if (ret != 0){
+        return ret;
+    }
+
+    target[MLX90393_REG_CONF1] = MLX90393_PackConf1(target[MLX90393_REG_CONF1], &cfg->base);
+    target[MLX90393_REG_CONF1] = (target[MLX90393_REG_CONF1] & ~0x000F) | (cfg->hallconf & 0x0F);
+
+    target[MLX90393_REG_CONF2] = (cfg->burst_data_rate & 0x3F)
+                               | (cfg->burst_sel & 0x0F) << 6
+                               | (cfg->tcmp_en ? 1 : 0) << 10
+                               | (cfg->ext_trig ? 1 : 0) << 11
+                               | (cfg->woc_diff ? 1 : 0) << 12
+                               | (cfg->comm_mode & 0x03) << 13
+                               | (cfg->trig_int_sel ? 1 : 0) << 15;
+
+    target[MLX90393_REG_CONF3] = MLX90393_PackConf3(target[MLX90393_REG_CONF3], &cfg->base);
+    target[MLX90393_REG_CONF3] = (target[MLX90393_REG_CONF3] & ~0x1800) | (cfg->osr2 & 0x03) << 11;
+
+    target[MLX90393_REG_SENS_TC] = cfg->sens_tc;
+    target[MLX90393_REG_OFFSET_X] = cfg->offset[0];
+    target[MLX90393_REG_OFFSET_Y] = cfg->offset[1];
+    target[MLX90393_REG_OFFSET_Z] = cfg->offset[2];
+    target[MLX90393_REG_WOXY_THRESHOLD] = cfg->woxy_threshold;
+    target[MLX90393_REG_WOZ_THRESHOLD] = cfg->woz_threshold;
+    target[MLX90393_REG_WOT_THRESHOLD] = cfg->wot_threshold;
+
+    //Write phase: changed registers only, no read back in between
+    int last = -1;
+    for (int reg = 0; reg < MLX90393_NUM_REGS; reg++){
+        if ((dev->regs_valid & (1 << reg)) && dev->regs[reg] == target[reg]){
+            continue;
+        }
+        ret = MLX90393_WR(dev, &status, reg, target[reg]);
+        if (ret != 0){
+            return ret;
+        }
+        if (status & MLX90393_STATUS_ERROR){
+            return MLX90393_MISMATCH;
+        }
+        last = reg;
+    }
+
+    //Verification phase
+    if (last >= 0){
+        uint8_t databuffer[2];
+        ret = MLX90393_RR(dev, &status, last, databuffer);
+        if (ret != 0){
+            return ret;
+        }
+        //Compare with the word on the bus: a rejected RR leaves the shadow, already at target, untouched
+        if ((status & MLX90393_STATUS_ERROR) || (uint16_t) (databuffer[0] << 8 | databuffer[1]) != target[last]){
+            return MLX90393_MISMATCH;
+        }
+    }
+
+    *(dev->settings) = cfg->base;
+    return 0;
+}
+
+/**
+ * @brief Decode the extended configuration from the register shadow (see MLX90393_SyncRegisters)
+ * 
+ * @param dev Handle to MLX90393 device
+ * @param cfg Where to store the configuration
+ * @return int32_t Error code (MLX90393_AGAIN if the shadow copy is incomplete)
+ */
+int32_t MLX90393_GetConfig(mlx_i2c_t *dev, mlx_cfg_ext_t *cfg){
+    if (dev == NULL || cfg == NULL){
+        return 1;
+    }
+    if (dev->regs_valid != (1 << MLX90393_NUM_REGS) - 1){
+        return MLX90393_AGAIN;
+    }
+
+    uint16_t conf1 = dev->regs[MLX90393_REG_CONF1];
+    uint16_t conf2 = dev->regs[MLX90393_REG_CONF2];
+    uint16_t conf3 = dev->regs[MLX90393_REG_CONF3];
+
+    cfg->base.gain = (mlx90393_gain_t) (conf1 >> 4) & 0x07;
+    cfg->base.oversampling = (mlx90393_oversampling_t) conf3 & 0x03;
+    cfg->base.filter = (mlx90393_filter_t) (conf3 >> 2) & 0x07;
+    cfg->base.resolution_x = (mlx90393_resolution_t) (conf3 >> 5) & 0x03;
+    cfg->base.resolution_y = (mlx90393_resolution_t) (conf3 >> 7) & 0x03;
+    cfg->base.resolution_z = (mlx90393_resolution_t) (conf3 >> 9) & 0x03;
+
+    cfg->hallconf = conf1 & 0x0F;
+    cfg->burst_data_rate = conf2 & 0x3F;
+    cfg->burst_sel = (conf2 >> 6) & 0x0F;
+    cfg->tcmp_en = (conf2 >> 10) & 0x01;
+    cfg->ext_trig = (conf2 >> 11) & 0x01;
+    cfg->woc_diff = (conf2 >> 12) & 0x01;
+    cfg->comm_mode = (conf2 >> 13) & 0x03;
+    cfg->trig_int_sel = (conf2 >> 15) & 0x01;
+    cfg->osr2 = (conf3 >> 11) & 0x03;
+
+    cfg->sens_tc = dev->regs[MLX90393_REG_SENS_TC];
+    cfg->offset[0] = dev->regs[MLX90393_REG_OFFSET_X];
+    cfg->offset[1] = dev->regs[MLX90393_REG_OFFSET_Y];
+    cfg->offset[2] = dev->regs[MLX90393_REG_OFFSET_Z];
+    cfg->woxy_threshold = dev->regs[MLX90393_REG_WOXY_THRESHOLD];
+    cfg->woz_threshold = dev->regs[MLX90393_REG_WOZ_THRESHOLD];
+    cfg->wot_threshold = dev->regs[MLX90393_REG_WOT_THRESHOLD];
+    return 0;
+}
+
+/**
+ * @brief Assemble the signed X, Y, Z counts of a raw payload, removing the RES_18/RES_19 offsets
+ * 
+ * @param cfg Settings the measurement was taken with
+ * @param data 6 data bytes from the sensor (X, Y, Z; MSB first)
+ * @param xyz_tmp Signed counts
+ */
+static void MLX90393_RawXYZ(const mlx_cfg_t *cfg, const uint8_t *data, int16_t *xyz_tmp){
+    xyz_tmp[0] = (data[0] << 8) | data[1];
+    xyz_tmp[1] = (data[2] << 8) | data[3];
+    xyz_tmp[2] = (data[4] << 8) | data[5]; 
+
+    if (cfg->resolution_x == MLX90393_RES_18) xyz_tmp[0] -= 0x8000;
+    if (cfg->resolution_x == MLX90393_RES_19) xyz_tmp[0] -= 0x4000;
+    if (cfg->resolution_y == MLX90393_RES_18) xyz_tmp[1] -= 0x8000;
+    if (cfg->resolution_y == MLX90393_RES_19) xyz_tmp[1] -= 0x4000;
+    if (cfg->resolution_z == MLX90393_RES_18) xyz_tmp[2] -= 0x8000;
+    if (cfg->resolution_z == MLX90393_RES_19) xyz_tmp[2] -= 0x4000;
+}
+
+/**
+ * @brief Convert a raw XYZ payload (as returned by MLX90393_RM) to microtesla
+ * 
+ * @param cfg Settings the measurement was taken with
+ * @param data 6 data bytes from the sensor (X, Y, Z; MSB first)
+ * @param xyz Array to store the converted X, Y, Z values [uT]
+ * @return int32_t Error code
+ */
+int32_t MLX90393_convertXYZ(const mlx_cfg_t *cfg, const uint8_t *data, float *xyz){
+    if(cfg == NULL || data == NULL || xyz == NULL){
+        return 1;
+    }
+
+    int16_t xyz_tmp[3];
+    MLX90393_RawXYZ(cfg, data, xyz_tmp);
+
+    xyz[0] = (float) xyz_tmp[0] * MLX90393_Sensitivity_LookUp[cfg->gain][cfg->resolution_x][0];
+    xyz[1] = (float) xyz_tmp[1] * MLX90393_Sensitivity_LookUp[cfg->gain][cfg->resolution_y][0];
+    xyz[2] = (float) xyz_tmp[2] * MLX90393_Sensitivity_LookUp[cfg->gain][cfg->resolution_z][1];
     
-    if(dev == NULL || xyz == NULL){
+    return 0;
+}
+
+/**
+ * @brief Fixed-point version of MLX90393_convertXYZ: convert a raw XYZ payload to nanotesla
+ * 
+ * Exact integer product of the counts and the nT/LSB sensitivity: the float path gives the same
+ * value / 1000 up to its two single precision roundings, the table entry and the product
+ * (within 2 ulp, relative error <= 2^-23 ~ 1.2e-7).
+ * 
+ * @param cfg Settings the measurement was taken with
+ * @param data 6 data bytes from the sensor (X, Y, Z; MSB first)
+ * @param xyz_nT Array to store the converted X, Y, Z values [nT]
+ * @return int32_t Error code
+ */
+int32_t MLX90393_convertXYZ_nT(const mlx_cfg_t *cfg, const uint8_t *data, int32_t *xyz_nT){
+    if(cfg == NULL || data == NULL || xyz_nT == NULL){
         return 1;
     }
 
-    //Copy the pointer to the settings for easier access later
-    mlx_cfg_t *curr_cfg = dev->settings;
+    int16_t xyz_tmp[3];
+    MLX90393_RawXYZ(cfg, data, xyz_tmp);
+
+    xyz_nT[0] = (int32_t) xyz_tmp[0] * MLX90393_Sensitivity_nT_LookUp[cfg->gain][cfg->resolution_x][0];
+    xyz_nT[1] = (int32_t) xyz_tmp[1] * MLX90393_Sensitivity_nT_LookUp[cfg->gain][cfg->resolution_y][0];
+    xyz_nT[2] = (int32_t) xyz_tmp[2] * MLX90393_Sensitivity_nT_LookUp[cfg->gain][cfg->resolution_z][1];
+
+    return 0;
+}
+
+/**
+ * @brief Raw value that corresponds to a zero field
+ * 
+ * @param res Axis resolution
+ * @param tcmp_en On-chip temperature compensation enabled (CONF2 TCMP_EN)
+ * @return uint16_t Offset to subtract from the raw unsigned word
+ */
+uint16_t MLX90393_ZeroOffset(mlx90393_resolution_t res, uint8_t tcmp_en){
+    if (res == MLX90393_RES_19){
+        return 0x4000;
+    }
+    if (res == MLX90393_RES_18 || tcmp_en){ //With TCMP_EN every resolution is unsigned
+        return 0x8000;
+    }
+    return 0;
+}
+
+/**
+ * @brief Convert a raw RM payload of any zyxt combination
+ * 
+ * @param cfg Settings the measurement was taken with
+ * @param tcmp_en On-chip temperature compensation was enabled (changes the zero field offset of RES_16/RES_17)
+ * @param zyxt Magnetic axes-temperature measurement setting of the payload
+ * @param data 2 data bytes per channel, in sensor order T, X, Y, Z
+ * @param sample Decoded measurement; channels not in zyxt are left untouched
+ * @return int32_t Error code
+ */
+int32_t MLX90393_convert(const mlx_cfg_t *cfg, uint8_t tcmp_en, char zyxt, const uint8_t *data, mlx_sample_t *sample){
+    if(cfg == NULL || data == NULL || sample == NULL || count_set_bits((uint8_t) zyxt) == 0){
+        return 1;
+    }
+
+    mlx90393_resolution_t res[3] = {cfg->resolution_x, cfg->resolution_y, cfg->resolution_z};
+    size_t pos = 0;
+
+    if(zyxt & 0x01){
+        uint16_t raw = (uint16_t) (data[0] << 8) | data[1];
+        sample->t = MLX90393_TREF_DEGC + ((float) raw - MLX90393_TREF_LSB) / MLX90393_TSENS_LSB;
+        pos += 2;
+    }
+    for(int axis = 0; axis < 3; axis++){
+        if(!(zyxt & (0x02 << axis))){
+            continue;
+        }
+        uint16_t raw = (uint16_t) (data[pos] << 8) | data[pos + 1];
+        int16_t counts = (int16_t) (uint16_t) (raw - MLX90393_ZeroOffset(res[axis], tcmp_en));
+        sample->xyz[axis] = (float) counts * MLX90393_Sensitivity_LookUp[cfg->gain][res[axis]][axis == 2];
+        pos += 2;
+    }
+    sample->zyxt = zyxt;
+    return 0;
+}
+
+/**
+ * @brief Convert a block of raw RM payloads into structure-of-arrays outputs in one pass
+ * 
+ * Frames are contiguous RM data payloads (without status byte) of 2 bytes per bit set in zyxt,
+ * in sensor order T, X, Y, Z. Scale factors and zero field offsets are resolved once per block,
+ * leaving branch-free per-axis loops that the compiler can auto-vectorize.
+ * 
+ * @param cfg Settings the measurements were taken with
+ * @param tcmp_en On-chip temperature compensation was enabled (changes the zero field offset of RES_16/RES_17)
+ * @param zyxt Magnetic axes-temperature measurement setting of the frames
+ * @param frames Raw payloads
+ * @param n Number of frames
+ * @param x [Optional] X values [uT] (n floats)
+ * @param y [Optional] Y values [uT] (n floats)
+ * @param z [Optional] Z values [uT] (n floats)
+ * @param t [Optional] Temperature values [degC] (n floats)
+ * @return int32_t Error code
+ */
+int32_t MLX90393_convertBatch(const mlx_cfg_t *cfg, uint8_t tcmp_en, char zyxt, const uint8_t *frames, size_t n,
+                              float *restrict x, float *restrict y, float *restrict z, float *restrict t){
+    uint8_t channels = count_set_bits((uint8_t) zyxt);
+    if(cfg == NULL || frames == NULL || channels == 0){
+        return 1;
+    }
+
+    const size_t stride = 2 * channels;
+    size_t pos = 0;
+
+    if(zyxt & 0x01){
+        if(t != NULL){
+            const uint8_t *restrict src = frames + pos;
+            for(size_t i = 0; i < n; i++){
+                const uint8_t *p = src + i * stride;
+                uint16_t raw = (uint16_t) (p[0] << 8) | p[1];
+                t[i] = MLX90393_TREF_DEGC + ((float) raw - MLX90393_TREF_LSB) / MLX90393_TSENS_LSB;
+            }
+        }
+        pos += 2;
+    }
+
+    mlx90393_resolution_t res[3] = {cfg->resolution_x, cfg->resolution_y, cfg->resolution_z};
+    float *out[3] = {x, y, z};
+    for(int axis = 0; axis < 3; axis++){
+        if(!(zyxt & (0x02 << axis))){
+            continue;
+        }
+        if(out[axis] != NULL){
+            const uint8_t *restrict src = frames + pos;
+            float *restrict dst = out[axis];
+            const float scale = MLX90393_Sensitivity_LookUp[cfg->gain][res[axis]][axis == 2];
+            const uint16_t offset = MLX90393_ZeroOffset(res[axis], tcmp_en);
+            for(size_t i = 0; i < n; i++){
+                const uint8_t *p = src + i * stride;
+                uint16_t raw = (uint16_t) (p[0] << 8) | p[1];
+                dst[i] = (float) (int16_t) (uint16_t) (raw - offset) * scale;
+            }
+        }
+        pos += 2;
+    }
+    return 0;
+}
+
+/**
+ * @brief Get the magnetic sensitivity of one axis with the given settings
+ * 
+ * @param cfg Settings
+ * @param axis 0 = X, 1 = Y, 2 = Z
+ * @return float Sensitivity [uT/LSB]
+ */
+float MLX90393_GetSensitivity(const mlx_cfg_t *cfg, int axis){
+    if(cfg == NULL || axis < 0 || axis > 2){
+        return 0;
+    }
+    mlx90393_resolution_t res[3] = {cfg->resolution_x, cfg->resolution_y, cfg->resolution_z};
+    return MLX90393_Sensitivity_LookUp[cfg->gain][res[axis]][axis == 2];
+}
+
+/**
+ * @brief Get the conversion time of a single measurement with the current settings
+ * 
+ * @param dev Handle to MLX90393 device
+ * @return float Conversion time [ms]
+ */
+float MLX90393_GetTconv(mlx_i2c_t *dev){
+    if(dev == NULL || dev->settings == NULL){
+        return 0;
+    }
+    return MLX90393_Tconv_LookUp[dev->settings->filter][dev->settings->oversampling];
+}
+
+/**
+ * @brief Get the conversion time of a single measurement, rounded up to the next microsecond
+ * 
+ * @param dev Handle to MLX90393 device
+ * @return uint32_t Conversion time [us]
+ */
+uint32_t MLX90393_GetTconv_us(mlx_i2c_t *dev){
+    float tconv = MLX90393_GetTconv(dev) * 1000.0f;
+    uint32_t wait_us = (uint32_t) tconv;
+    if((float) wait_us < tconv) wait_us++; //Round up, never read early
+    return wait_us;
+}
+
+/**
+ * @brief Get the conversion time of a measurement of the requested channels, rounded up to the next microsecond
+ * 
+ * The temperature oversampling is taken from the CONF3 shadow (OSR2 = 0 until it has been read).
+ * 
+ * @param dev Handle to MLX90393 device
+ * @param zyxt Magnetic axes-temperature measurement setting
+ * @return uint32_t Conversion time [us]
+ */
+uint32_t MLX90393_GetTconvZyxt_us(mlx_i2c_t *dev, char zyxt){
+    if(dev == NULL || dev->settings == NULL){
+        return 0;
+    }
+    int osr2 = 0;
+    if(dev->regs_valid & (1 << MLX90393_REG_CONF3)){
+        osr2 = (dev->regs[MLX90393_REG_CONF3] >> 11) & 0x03;
+    }
+    return MLX90393_TconvChannels_us(dev->settings->filter, dev->settings->oversampling, osr2, (uint8_t) zyxt);
+}
+
+/**
+ * @brief Wait for the conversion started by SM to finish and read it with RM
+ * 
+ * The wait covers only the channels in zyxt (MLX90393_GetTconvZyxt_us).
+ * Without an udelay hook it is the legacy whole-millisecond Tconv + 1 ms.
+ * With it, the exact Tconv is waited at microsecond resolution and readiness is confirmed
+ * by the RM status byte: while the sensor rejects the read (ERROR bit), it is polled again
+ * every MLX90393_READY_POLL_US up to dev->ready_retries times.
+ * 
+ * @param dev Handle to MLX90393 device
+ * @param zyxt Magnetic axes-temperature measurement setting
+ * @param statusBuffer Buffer to store status byte from the sensor
+ * @param dataBuffer Buffer to store data bytes from the sensor measurements
+ * @return int32_t Error code
+ */
+int32_t MLX90393_WaitAndRead(mlx_i2c_t *dev, char zyxt, uint8_t *statusBuffer, uint8_t *dataBuffer){
+    if(dev == NULL || dev->settings == NULL){
+        return 1;
+    }
+
+    uint32_t tconv_us = MLX90393_GetTconvZyxt_us(dev, zyxt);
+    if(dev->udelay == NULL){
+        dev->mdelay((int) (tconv_us / 1000) + 1);
+        MLX90393_StatWait(dev, (tconv_us / 1000 + 1) * 1000);
+        return MLX90393_RM(dev, zyxt, statusBuffer, dataBuffer);
+    }
+
+    dev->udelay(tconv_us);
+    MLX90393_StatWait(dev, tconv_us);
 
+    int32_t ret;
+    uint8_t attempt = 0;
+    while(1){
+        ret = MLX90393_RM(dev, zyxt, statusBuffer, dataBuffer);
+        if(ret != 0 || !(*statusBuffer & MLX90393_STATUS_ERROR) || attempt >= dev->ready_retries){
+            return ret;
+        }
+        attempt++;
+        dev->udelay(MLX90393_READY_POLL_US);
+        MLX90393_StatWait(dev, MLX90393_READY_POLL_US);
+    }
+}
+
+/**
+ * @brief Take a single XYZ measurement (SM, wait, RM) and return the raw payload
+ * 
+ * Shared by MLX90393_readXYZ, MLX90393_readXYZ_nT and the MLX90393_PROFILE readers.
+ * 
+ * @param dev Handle to MLX90393 device
+ * @param data 6 data bytes buffer
+ * @return int32_t Error code (MLX90393_MISMATCH if SM is rejected, MLX90393_AGAIN if the data is still not ready)
+ */
+int32_t MLX90393_MeasureXYZ(mlx_i2c_t *dev, uint8_t *data){
+    if(dev == NULL || data == NULL || dev->settings == NULL){
+        return 1;
+    }
     int32_t ret;
     uint8_t status;
     /*Start measurement*/
@@ -411,38 +1093,295 @@ int32_t MLX90393_readXYZ(mlx_i2c_t *dev, float *xyz){
     if (ret != 0){
         return ret;
     }
+    if (status & MLX90393_STATUS_ERROR){
+        return MLX90393_MISMATCH;
+    }
 
-    /*Wait tconv*/
-    dev->mdelay((int) MLX90393_Tconv_LookUp[curr_cfg->filter][curr_cfg->oversampling] + 1); 
+    /*Wait tconv and read measurement*/
+    ret = MLX90393_WaitAndRead(dev, MLX90393_MAG_XYZ, &status, data);
+    if (ret == 0 && (status & MLX90393_STATUS_ERROR)){
+        return MLX90393_AGAIN; //Stale data
+    }
+    return ret;
+}
 
-    /*Read measurement*/
+int32_t MLX90393_readXYZ(mlx_i2c_t *dev, float *xyz){
+    
+    if(dev == NULL || xyz == NULL){
+        return 1;
+    }
+
+    int32_t ret;
     uint8_t data[6];
-    ret = MLX90393_RM(dev, MLX90393_MAG_XYZ, &status, data);
+    ret = MLX90393_MeasureXYZ(dev, data);
     if (ret != 0){
         return ret;
     }
     
     /*Convert to magnetic units */
-    int16_t xyz_tmp[3];
-    xyz_tmp[0] = (data[0] << 8) | data[1];
-    xyz_tmp[1] = (data[2] << 8) | data[3];
-    xyz_tmp[2] = (data[4] << 8) | data[5]; 
+    MLX90393_convertXYZ(dev->settings, data, xyz);
+    
+    return ret;
+}
 
-    if (curr_cfg->resolution_x == MLX90393_RES_18) xyz_tmp[0] -= 0x8000;
-    if (curr_cfg->resolution_x == MLX90393_RES_19) xyz_tmp[0] -= 0x4000;
-    if (curr_cfg->resolution_y == MLX90393_RES_18) xyz_tmp[1] -= 0x8000;
-    if (curr_cfg->resolution_y == MLX90393_RES_19) xyz_tmp[1] -= 0x4000;
-    if (curr_cfg->resolution_z == MLX90393_RES_18) xyz_tmp[2] -= 0x8000;
-    if (curr_cfg->resolution_z == MLX90393_RES_19) xyz_tmp[2] -= 0x4000;
+/**
+ * @brief Whether on-chip temperature compensation is enabled, according to the register shadow
+ * 
+ * @param dev Handle to MLX90393 device
+ * @return uint8_t 1 if CONF2 TCMP_EN is known to be set
+ */
+uint8_t MLX90393_TcmpEnabled(mlx_i2c_t *dev){
+    if(dev == NULL || !(dev->regs_valid & (1 << MLX90393_REG_CONF2))){
+        return 0;
+    }
+    return (dev->regs[MLX90393_REG_CONF2] >> 10) & 0x01;
+}
 
+/**
+ * @brief Tag a sample read from dev: configuration generation, sequence number and timestamps.
+ * Also feeds dev->jitter.
+ * 
+ * @param dev Handle to MLX90393 device
+ * @param sample Sample to tag
+ * @param t_issue_us Time the command that produced the sample was sent
+ * @param t_expected_us Expected end of the conversion
+ */
+void MLX90393_StampSample(mlx_i2c_t *dev, mlx_sample_t *sample, uint64_t t_issue_us, uint64_t t_expected_us){
+    sample->cfg_gen = dev->cfg_gen;
+    sample->seq = dev->seq++;
+    if (dev->clock_us == NULL){
+        sample->t_issue_us = 0;
+        sample->t_expected_us = 0;
+        sample->t_done_us = 0;
+        return;
+    }
+    sample->t_issue_us = t_issue_us;
+    sample->t_expected_us = t_expected_us;
+    sample->t_done_us = dev->clock_us();
+    if (dev->jitter != NULL){
+        MLX90393_JitterUpdate(dev->jitter, sample);
+    }
+}
 
-    xyz[0] = (float) xyz_tmp[0] * MLX90393_Sensitivity_LookUp[curr_cfg->gain][curr_cfg->resolution_x][0];
-    xyz[1] = (float) xyz_tmp[1] * MLX90393_Sensitivity_LookUp[curr_cfg->gain][curr_cfg->resolution_y][0];
-    xyz[2] = (float) xyz_tmp[2] * MLX90393_Sensitivity_LookUp[curr_cfg->gain][curr_cfg->resolution_z][1];
-    
+/**
+ * @brief Add a timestamped sample to rolling timing statistics (zero the struct to reset them)
+ * 
+ * @param jitter Timing statistics
+ * @param sample Sample with t_done_us set
+ * @return int32_t Error code
+ */
+int32_t MLX90393_JitterUpdate(mlx_jitter_t *jitter, const mlx_sample_t *sample){
+    if (jitter == NULL || sample == NULL){
+        return 1;
+    }
+    uint32_t latency = sample->t_done_us > sample->t_expected_us ? (uint32_t) (sample->t_done_us - sample->t_expected_us) : 0;
+    if (jitter->samples == 0){
+        jitter->latency_us = (float) latency;
+        jitter->latency_min_us = latency;
+        jitter->latency_max_us = latency;
+    } else {
+        float interval = (float) (sample->t_done_us - jitter->last_done_us);
+        if (jitter->samples == 1){
+            jitter->period_us = interval;
+        }
+        jitter->jitter_us += (fabsf(interval - jitter->period_us) - jitter->jitter_us) / 16.0f;
+        jitter->period_us += (interval - jitter->period_us) / 16.0f;
+        jitter->latency_us += ((float) latency - jitter->latency_us) / 16.0f;
+        if (latency < jitter->latency_min_us) jitter->latency_min_us = latency;
+        if (latency > jitter->latency_max_us) jitter->latency_max_us = latency;
+    }
+    jitter->last_done_us = sample->t_done_us;
+    jitter->samples++;
+    return 0;
+}
+
+/**
+ * @brief Measure any combination of channels (e.g. XYZT, Z only, T only). Only the requested channels
+ * are transferred, and the decoding follows TCMP_EN from the register shadow.
+ * 
+ * @param dev Handle to MLX90393 device
+ * @param zyxt Magnetic axes-temperature measurement setting
+ * @param sample Decoded measurement
+ * @return int32_t Error code (MLX90393_MISMATCH if SM is rejected, MLX90393_AGAIN if the data is still not ready)
+ */
+int32_t MLX90393_readMeasurement(mlx_i2c_t *dev, char zyxt, mlx_sample_t *sample){
+    if(dev == NULL || sample == NULL || dev->settings == NULL || count_set_bits((uint8_t) zyxt) == 0){
+        return 1;
+    }
+
+    int32_t ret;
+    uint8_t data[8];
+    uint64_t t_issue = dev->clock_us != NULL ? dev->clock_us() : 0;
+    ret = MLX90393_SM(dev, zyxt, &sample->status);
+    if (ret != 0){
+        return ret;
+    }
+    if (sample->status & MLX90393_STATUS_ERROR){
+        return MLX90393_MISMATCH;
+    }
+    ret = MLX90393_WaitAndRead(dev, zyxt, &sample->status, data);
+    if (ret != 0){
+        return ret;
+    }
+    if (sample->status & MLX90393_STATUS_ERROR){
+        return MLX90393_AGAIN;
+    }
+    MLX90393_StampSample(dev, sample, t_issue, t_issue + MLX90393_GetTconvZyxt_us(dev, zyxt));
+
+    return MLX90393_convert(dev->settings, MLX90393_TcmpEnabled(dev), zyxt, data, sample);
+}
+
+/**
+ * @brief Fixed-point version of MLX90393_readXYZ (no float math)
+ * 
+ * @param dev Handle to MLX90393 device
+ * @param xyz_nT Array to store the X, Y, Z values [nT]
+ * @return int32_t Error code
+ */
+int32_t MLX90393_readXYZ_nT(mlx_i2c_t *dev, int32_t *xyz_nT){
+    if(dev == NULL || xyz_nT == NULL){
+        return 1;
+    }
+
+    int32_t ret;
+    uint8_t data[6];
+    ret = MLX90393_MeasureXYZ(dev, data);
+    if (ret != 0){
+        return ret;
+    }
+
+    MLX90393_convertXYZ_nT(dev->settings, data, xyz_nT);
+    return ret;
+}
+
+/**
+ * @brief Start an XYZ measurement without waiting for it (asynchronous API)
+ * 
+ * @param dev Handle to MLX90393 device (needs the clock_us hook)
+ * @param deadline_us [Optional] Where to store the time [us] from which the result can be collected
+ * @return int32_t Error code (MLX90393_AGAIN if a measurement is already in flight)
+ */
+int32_t MLX90393_StartXYZ(mlx_i2c_t *dev, uint64_t *deadline_us){
+    if(dev == NULL || dev->settings == NULL || dev->clock_us == NULL){
+        return 1;
+    }
+    if(dev->pending){
+        return MLX90393_AGAIN;
+    }
+
+    int32_t ret;
+    uint8_t status;
+    ret = MLX90393_SM(dev, MLX90393_MAG_XYZ, &status);
+    if (ret != 0){
+        return ret;
+    }
+    if (status & MLX90393_STATUS_ERROR){
+        return MLX90393_MISMATCH; //Rejected, e.g. while in burst or WOC mode: nothing in flight
+    }
+
+    dev->deadline_us = dev->clock_us() + MLX90393_GetTconv_us(dev);
+    dev->pending = 1;
+    if(deadline_us != NULL){
+        *deadline_us = dev->deadline_us;
+    }
+    return 0;
+}
+
+/**
+ * @brief Collect the measurement started by MLX90393_StartXYZ if its conversion is over
+ * 
+ * A measurement still not ready one Tconv past its deadline is abandoned (MLX90393_TIMEOUT).
+ * 
+ * @param dev Handle to MLX90393 device
+ * @param xyz Array to store the X, Y, Z values [uT]
+ * @return int32_t Error code (MLX90393_AGAIN if the deadline has not been reached or the data is not ready yet)
+ */
+int32_t MLX90393_CompleteXYZ(mlx_i2c_t *dev, float *xyz){
+    if(dev == NULL || xyz == NULL || dev->settings == NULL || dev->clock_us == NULL || !dev->pending){
+        return 1;
+    }
+    uint64_t now = dev->clock_us();
+    if(now < dev->deadline_us){
+        return MLX90393_AGAIN;
+    }
+
+    int32_t ret;
+    uint8_t status;
+    uint8_t data[6];
+    ret = MLX90393_RM(dev, MLX90393_MAG_XYZ, &status, data);
+    if (ret != 0){
+        return ret; //Keep it pending, the caller may retry the read
+    }
+    if (status & MLX90393_STATUS_ERROR){
+        if (now >= dev->deadline_us + MLX90393_GetTconv_us(dev)){
+            dev->pending = 0;
+            return MLX90393_TIMEOUT;
+        }
+        return MLX90393_AGAIN; //Not converted yet
+    }
+    dev->pending = 0;
+
+    MLX90393_convertXYZ(dev->settings, data, xyz);
     return ret;
 }
 
+/**
+ * @brief Forget the measurement started by MLX90393_StartXYZ, so a new one can be started
+ * 
+ * @param dev Handle to MLX90393 device
+ */
+void MLX90393_CancelXYZ(mlx_i2c_t *dev){
+    if(dev != NULL){
+        dev->pending = 0;
+    }
+}
+
+#ifdef MLX90393_STATS
+/**
+ * @brief Clear the statistics of a device
+ * 
+ * @param dev Handle to MLX90393 device
+ */
+void MLX90393_ResetStats(mlx_i2c_t *dev){
+    if (dev != NULL){
+        memset(&dev->stats, 0, sizeof(mlx_stats_t));
+    }
+}
+
+/**
+ * @brief Install (or remove, with NULL) the per-command trace hook
+ * 
+ * @param dev Handle to MLX90393 device
+ * @param trace [Optional] Trace hook
+ * @param ctx User context passed to the hook
+ */
+void MLX90393_SetTrace(mlx_i2c_t *dev, mlx_trace_ptr trace, void *ctx){
+    if (dev != NULL){
+        dev->trace = trace;
+        dev->trace_ctx = ctx;
+    }
+}
+#endif
+
+/**
+ * @brief Split a status byte into its fields
+ * 
+ * @param status Status byte returned by any command
+ * @param decoded Decoded fields
+ * @return int32_t Error code
+ */
+int32_t MLX90393_DecodeStatus(uint8_t status, mlx_status_t *decoded){
+    if (decoded == NULL){
+        return 1;
+    }
+    decoded->mode = status & (MLX90393_STATUS_BURST | MLX90393_STATUS_WOC | MLX90393_STATUS_SM);
+    decoded->error = (status & MLX90393_STATUS_ERROR) != 0;
+    decoded->sed = (status & MLX90393_STATUS_SED) != 0;
+    decoded->rs = (status & MLX90393_STATUS_RS) != 0;
+    decoded->data_bytes = 2 * (status & MLX90393_STATUS_D) + 2;
+    return 0;
+}
+
 /**
  * @brief MLX90393 device initialisation function
  * 
@@ -454,25 +1393,61 @@ int32_t MLX90393_Init(mlx_i2c_t *dev, mlx_cfg_t *settings){
     if(dev == NULL){
         return 1;
     } 
-    if(dev->read_function == NULL || dev->write_function == NULL || dev->mdelay == NULL){
+    if((dev->transfer == NULL && (dev->read_function == NULL || dev->write_function == NULL)) || dev->mdelay == NULL){
         return 2;
     }
+    int32_t ret = MLX90393_SyncRegisters(dev); //Read the whole register map once (CONF2, offsets, thresholds too)
+    if (ret != 0){
+        return ret;
+    }
     if (settings == NULL){ //If the user doesn't provide its own "new" settings, we test the device by reading the current settings and storing them to the dev structure
         return GetSettings(dev);
     }
-    return ApplySettings(dev, settings); //Otherwise, we write the user settings to the device registers
+    return ApplySettings(dev, settings); //Otherwise, we write the user settings to the device registers (only what differs from the shadow)
+}
+
+/**
+ * @brief Allocate a zeroed MLX90393 device structure (from the heap, or from the static pool with MLX90393_STATIC_ALLOC)
+ * 
+ * @return mlx_i2c_t* Device handle, NULL if no memory / no free pool slot is left
+ */
+mlx_i2c_t *MLX90393_Alloc(void){
+#ifdef MLX90393_STATIC_ALLOC
+    for (int i = 0; i < MLX90393_STATIC_POOL_SIZE; i++){
+        if (!mlx_pool_used[i]){
+            mlx_pool_used[i] = 1;
+            memset(&mlx_pool[i], 0, sizeof(mlx_i2c_t));
+            return &mlx_pool[i];
+        }
+    }
+    return NULL;
+#else
+    mlx_i2c_t *dev = (mlx_i2c_t *) mlx_malloc(sizeof(mlx_i2c_t));
+    if (dev != NULL){
+        memset(dev, 0, sizeof(mlx_i2c_t));
+    }
+    return dev;
+#endif
 }
 
 /**
  * @brief Memory to de-init MLX90393 device (free structures of a given device)
  * 
+ * With MLX90393_STATIC_ALLOC nothing is freed: pool devices return their slot, caller-owned ones are left alone.
+ * 
  * @param dev Handle to MLX90393 device
  */
 void MLX90393_Free(mlx_i2c_t *dev){
+#ifdef MLX90393_STATIC_ALLOC
+    if (dev >= &mlx_pool[0] && dev < &mlx_pool[MLX90393_STATIC_POOL_SIZE]){
+        mlx_pool_used[dev - mlx_pool] = 0;
+    }
+#else
     if (dev != NULL) {
         if (dev->settings != NULL){
             mlx_free(dev->settings);
         }
         mlx_free(dev); 
     }
+#endif
 }
\ No newline at end of file
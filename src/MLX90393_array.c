@@ -0,0 +1,306 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE //pthread_attr_setaffinity_np
+#endif
+#include <sched.h>
+#include <string.h>
+#include "MLX90393.h"
+#include "MLX90393_array.h"
+
+/** Helper functions**/
+/**
+ * @brief Scheduler callback: tag the sample and hand it to the queues of its device
+ *
+ * @param ctx Bus the sample was collected on
+ * @param idx Scheduler slot of the device
+ * @param xyz Measurement [uT]
+ */
+static void MLX90393_ArrayDeliver(void *ctx, size_t idx, const float *xyz){
+    mlx_array_bus_t *bus = ctx;
+    mlx_array_t *array = bus->array;
+    mlx_array_item_t item;
+    item.device = bus->ids[idx];
+    mlx_array_dev_t *slot = &array->devs[item.device];
+
+    memcpy(item.sample.xyz, xyz, sizeof(item.sample.xyz));
+    item.sample.t = 0;
+    item.sample.zyxt = MLX90393_MAG_XYZ;
+    item.sample.status = 0;
+    //deadline_us still holds the end of the conversion just collected
+    MLX90393_StampSample(slot->dev, &item.sample, slot->dev->deadline_us - MLX90393_GetTconv_us(slot->dev),
+                         slot->dev->deadline_us);
+
+    if (slot->ring != NULL && MLX90393_RingPush(slot->ring, &item.sample) != 0){
+        atomic_fetch_add_explicit(&slot->dropped, 1, memory_order_relaxed);
+    }
+    if (array->merged != NULL && MLX90393_MpscPush(array->merged, &item) != 0){
+        atomic_fetch_add_explicit(&slot->dropped, 1, memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Worker thread of one bus: scheduling rounds until done or stopped
+ *
+ * Rounds are bounded (see MLX90393_SCHED_MAX_RETRIES) and the wait for the next due device is
+ * cut in slices of MLX90393_ARRAY_STOP_POLL_US, so MLX90393_ArrayStop is served promptly.
+ *
+ * @param arg Bus
+ * @return void* NULL
+ */
+static void *MLX90393_ArrayWorker(void *arg){
+    mlx_array_bus_t *bus = arg;
+    mlx_sched_t *sched = &bus->sched;
+    for (uint32_t r = 0; bus->rounds == 0 || r < bus->rounds; r++){
+        if (!atomic_load_explicit(&bus->array->running, memory_order_acquire)){
+            break;
+        }
+        int32_t ret = MLX90393_SchedRound(sched, NULL);
+        if (ret != 0 && ret != MLX90393_AGAIN){
+            atomic_fetch_add_explicit(&bus->errors, 1, memory_order_relaxed);
+        }
+
+        uint64_t next_due = MLX90393_SchedNextDue(sched);
+        uint64_t now = sched->clock_us();
+        while (now < next_due && atomic_load_explicit(&bus->array->running, memory_order_acquire)){
+            uint64_t wait = next_due - now;
+            sched->udelay((uint32_t) (wait < MLX90393_ARRAY_STOP_POLL_US ? wait : MLX90393_ARRAY_STOP_POLL_US));
+            now = sched->clock_us();
+        }
+    }
+    return NULL;
+}
+
+//MERGED QUEUE
+/**
+ * @brief Initialise a MPSC queue over caller-provided storage
+ *
+ * @param queue Queue to initialise
+ * @param cells Storage for the samples
+ * @param capacity Number of cells (must be a power of 2)
+ * @return int32_t Error code
+ */
+int32_t MLX90393_MpscInit(mlx_mpsc_t *queue, mlx_mpsc_cell_t *cells, size_t capacity){
+    if (queue == NULL || cells == NULL || capacity == 0 || (capacity & (capacity - 1)) != 0){
+        return 1;
+    }
+    queue->cells = cells;
+    queue->mask = capacity - 1;
+    for (size_t i = 0; i < capacity; i++){
+        atomic_init(&cells[i].seq, i);
+    }
+    atomic_init(&queue->head, 0);
+    queue->tail = 0;
+    return 0;
+}
+
+/**
+ * @brief Push a sample into the queue (any number of producer threads)
+ *
+ * @param queue Queue
+ * @param item Sample to copy into the queue
+ * @return int32_t Error code (MLX90393_AGAIN if the queue is full)
+ */
+int32_t MLX90393_MpscPush(mlx_mpsc_t *queue, const mlx_array_item_t *item){
+    if (queue == NULL || item == NULL){
+        return 1;
+    }
+    size_t pos = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    while (1){
+        mlx_mpsc_cell_t *cell = &queue->cells[pos & queue->mask];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t) seq - (intptr_t) pos;
+        if (diff == 0){
+            //Free cell of this lap: claim it (pos is refreshed if another producer was faster)
+            if (atomic_compare_exchange_weak_explicit(&queue->head, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)){
+                cell->item = *item;
+                atomic_store_explicit(&cell->seq, pos + 1, memory_order_release); //Publish to the consumer
+                return 0;
+            }
+        } else if (diff < 0){
+            return MLX90393_AGAIN; //Not consumed yet from the previous lap
+        } else {
+            pos = atomic_load_explicit(&queue->head, memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * @brief Pop the oldest sample from the queue (single consumer thread only)
+ *
+ * @param queue Queue
+ * @param item Where to copy the sample
+ * @return int32_t Error code (MLX90393_AGAIN if the queue is empty)
+ */
+int32_t MLX90393_MpscPop(mlx_mpsc_t *queue, mlx_array_item_t *item){
+    if (queue == NULL || item == NULL){
+        return 1;
+    }
+    mlx_mpsc_cell_t *cell = &queue->cells[queue->tail & queue->mask];
+    size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+    if (seq != queue->tail + 1){
+        return MLX90393_AGAIN;
+    }
+    *item = cell->item;
+    atomic_store_explicit(&cell->seq, queue->tail + queue->mask + 1, memory_order_release); //Free for the next lap
+    queue->tail++;
+    return 0;
+}
+
+//ARRAY
+/**
+ * @brief Initialise an empty sensor array
+ *
+ * @param array Array structure
+ * @param merged [Optional] Queue receiving the samples of every device
+ * @return int32_t Error code
+ */
+int32_t MLX90393_ArrayInit(mlx_array_t *array, mlx_mpsc_t *merged){
+    if (array == NULL){
+        return 1;
+    }
+    memset(array, 0, sizeof(mlx_array_t));
+    array->merged = merged;
+    atomic_init(&array->running, 0);
+    return 0;
+}
+
+/**
+ * @brief Add a bus; its devices are served by a worker thread of their own
+ *
+ * The clock and delay hooks are called from the worker thread only. Thread-local clocks
+ * (such as the simulator's) give every bus its own timeline.
+ *
+ * @param array Array structure
+ * @param clock_us Monotonic clock [us] of the bus
+ * @param udelay Microsecond delay of the bus
+ * @param cpu CPU to pin the worker to (MLX90393_ARRAY_ANY_CPU for none)
+ * @param bus [Optional] Index of the new bus
+ * @return int32_t Error code (MLX90393_AGAIN if the array is full)
+ */
+int32_t MLX90393_ArrayAddBus(mlx_array_t *array, mlx_clock_ptr clock_us, mlx_udelay_ptr udelay, int cpu, size_t *bus){
+    if (array == NULL || atomic_load(&array->running)){
+        return 1;
+    }
+    if (array->bus_count >= MLX90393_ARRAY_MAX_BUSES){
+        return MLX90393_AGAIN;
+    }
+    mlx_array_bus_t *b = &array->buses[array->bus_count];
+    int32_t ret = MLX90393_SchedInit(&b->sched, clock_us, udelay, MLX90393_ArrayDeliver, b);
+    if (ret != 0){
+        return ret;
+    }
+    b->array = array;
+    b->cpu = cpu;
+    b->started = 0;
+    atomic_init(&b->errors, 0);
+    if (bus != NULL){
+        *bus = array->bus_count;
+    }
+    array->bus_count++;
+    return 0;
+}
+
+/**
+ * @brief Add an initialised device to a bus of the array
+ *
+ * @param array Array structure
+ * @param bus Index of the bus the device is on
+ * @param dev Handle to MLX90393 device
+ * @param period_us Target sampling period [us] (0 = as fast as possible)
+ * @param ring [Optional] Per-device queue, read by a single consumer
+ * @param id [Optional] Array device id, reported with the samples of the merged queue
+ * @return int32_t Error code (MLX90393_AGAIN if the bus is full)
+ */
+int32_t MLX90393_ArrayAddDevice(mlx_array_t *array, size_t bus, mlx_i2c_t *dev, uint32_t period_us, mlx_ring_t *ring, size_t *id){
+    if (array == NULL || bus >= array->bus_count || atomic_load(&array->running)){
+        return 1;
+    }
+    mlx_array_bus_t *b = &array->buses[bus];
+    size_t slot = b->sched.count;
+    int32_t ret = MLX90393_SchedAdd(&b->sched, dev, period_us);
+    if (ret != 0){
+        return ret;
+    }
+    mlx_array_dev_t *d = &array->devs[array->dev_count];
+    d->dev = dev;
+    d->ring = ring;
+    d->bus = bus;
+    atomic_init(&d->dropped, 0);
+    b->ids[slot] = (uint32_t) array->dev_count;
+    if (id != NULL){
+        *id = array->dev_count;
+    }
+    array->dev_count++;
+    return 0;
+}
+
+/**
+ * @brief Start one worker thread per bus
+ *
+ * @param array Array structure
+ * @param rounds Scheduling rounds per bus (0 = until MLX90393_ArrayStop)
+ * @return int32_t Error code (-errno if a thread could not be created)
+ */
+int32_t MLX90393_ArrayStart(mlx_array_t *array, uint32_t rounds){
+    if (array == NULL || array->bus_count == 0 || atomic_load(&array->running)){
+        return 1;
+    }
+    atomic_store_explicit(&array->running, 1, memory_order_release);
+
+    for (size_t i = 0; i < array->bus_count; i++){
+        mlx_array_bus_t *b = &array->buses[i];
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+#if defined(__linux__)
+        if (b->cpu != MLX90393_ARRAY_ANY_CPU){
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(b->cpu, &cpus);
+            pthread_attr_setaffinity_np(&attr, sizeof(cpus), &cpus);
+        }
+#endif
+        b->rounds = rounds;
+        int err = pthread_create(&b->thread, &attr, MLX90393_ArrayWorker, b);
+        pthread_attr_destroy(&attr);
+        if (err != 0){
+            MLX90393_ArrayStop(array);
+            return -err;
+        }
+        b->started = 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Wait for the workers to finish the rounds given to MLX90393_ArrayStart
+ *
+ * @param array Array structure
+ * @return int32_t Error code
+ */
+int32_t MLX90393_ArrayWait(mlx_array_t *array){
+    if (array == NULL){
+        return 1;
+    }
+    for (size_t i = 0; i < array->bus_count; i++){
+        mlx_array_bus_t *b = &array->buses[i];
+        if (b->started){
+            pthread_join(b->thread, NULL);
+            b->started = 0;
+        }
+    }
+    atomic_store_explicit(&array->running, 0, memory_order_release);
+    return 0;
+}
+
+/**
+ * @brief Stop the workers after their current round and wait for them
+ *
+ * @param array Array structure
+ * @return int32_t Error code
+ */
+int32_t MLX90393_ArrayStop(mlx_array_t *array){
+    if (array == NULL){
+        return 1;
+    }
+    atomic_store_explicit(&array->running, 0, memory_order_release);
+    return MLX90393_ArrayWait(array);
+}
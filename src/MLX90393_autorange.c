@@ -0,0 +1,136 @@
+#include <math.h>
+#include <string.h>
+#include "MLX90393.h"
+#include "MLX90393_autorange.h"
+
+/** Helper functions**/
+/**
+ * @brief Step to a wider range: lower gain first, then higher resolution
+ * 
+ * @param ar Auto-range state
+ * @param cfg Settings to modify
+ * @return uint8_t 1 if cfg changed
+ */
+static uint8_t MLX90393_AutorangeWiden(const mlx_autorange_t *ar, mlx_cfg_t *cfg){
+    if (cfg->gain > MLX90393_GAIN_5X){
+        cfg->gain--;
+        return 1;
+    }
+    if (!ar->use_resolution){
+        return 0;
+    }
+    mlx90393_resolution_t *res[3] = {&cfg->resolution_x, &cfg->resolution_y, &cfg->resolution_z};
+    uint8_t changed = 0;
+    for (int axis = 0; axis < 3; axis++){
+        if (*res[axis] < MLX90393_RES_19){
+            (*res[axis])++;
+            changed = 1;
+        }
+    }
+    return changed;
+}
+
+/**
+ * @brief Step to a narrower range: back to the base resolutions first, then higher gain
+ * 
+ * @param ar Auto-range state
+ * @param cfg Settings to modify
+ * @return uint8_t 1 if cfg changed
+ */
+static uint8_t MLX90393_AutorangeNarrow(const mlx_autorange_t *ar, mlx_cfg_t *cfg){
+    mlx90393_resolution_t *res[3] = {&cfg->resolution_x, &cfg->resolution_y, &cfg->resolution_z};
+    uint8_t changed = 0;
+    for (int axis = 0; axis < 3; axis++){
+        if (*res[axis] > ar->base_res[axis]){
+            (*res[axis])--;
+            changed = 1;
+        }
+    }
+    if (changed){
+        return 1;
+    }
+    if (cfg->gain < ar->max_gain){
+        cfg->gain++;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Set up auto-ranging with the default thresholds; the current settings are the sensitive end of the ladder
+ * 
+ * @param ar Auto-range state
+ * @param dev Handle to MLX90393 device (settings must be known)
+ * @return int32_t Error code
+ */
+int32_t MLX90393_AutorangeInit(mlx_autorange_t *ar, mlx_i2c_t *dev){
+    if (ar == NULL || dev == NULL || dev->settings == NULL){
+        return 1;
+    }
+    memset(ar, 0, sizeof(mlx_autorange_t));
+    ar->dev = dev;
+    ar->high_pct = MLX90393_AUTORANGE_HIGH_PCT;
+    ar->low_pct = MLX90393_AUTORANGE_LOW_PCT;
+    ar->hold = MLX90393_AUTORANGE_HOLD;
+    ar->max_gain = dev->settings->gain;
+    ar->base_res[0] = dev->settings->resolution_x;
+    ar->base_res[1] = dev->settings->resolution_y;
+    ar->base_res[2] = dev->settings->resolution_z;
+    return 0;
+}
+
+/**
+ * @brief Take an XYZ measurement and move one step along the range ladder if it calls for it
+ * 
+ * The sample is converted with the settings it was measured with, which are also returned, so a
+ * range switch never corrupts it. Saturated samples are returned as read (clipped).
+ * 
+ * @param ar Auto-range state
+ * @param sample Decoded measurement (cfg_gen identifies the configuration)
+ * @param cfg [Optional] Settings the sample was taken under
+ * @return int32_t Error code (of the measurement, or of ApplySettings if a switch failed)
+ */
+int32_t MLX90393_AutorangeRead(mlx_autorange_t *ar, mlx_sample_t *sample, mlx_cfg_t *cfg){
+    if (ar == NULL || ar->dev == NULL || ar->dev->settings == NULL || sample == NULL){
+        return 1;
+    }
+    mlx_cfg_t used = *ar->dev->settings;
+    int32_t ret = MLX90393_readMeasurement(ar->dev, MLX90393_MAG_XYZ, sample);
+    if (ret != 0){
+        return ret;
+    }
+    if (cfg != NULL){
+        *cfg = used;
+    }
+
+    //Peak share of full scale over the three axes
+    mlx90393_resolution_t res[3] = {used.resolution_x, used.resolution_y, used.resolution_z};
+    float peak = 0;
+    for (int axis = 0; axis < 3; axis++){
+        float full_scale = res[axis] == MLX90393_RES_19 ? 16383.0f : 32767.0f;
+        float share = fabsf(sample->xyz[axis] / MLX90393_GetSensitivity(&used, axis)) * 100.0f / full_scale;
+        if (share > peak) peak = share;
+    }
+
+    mlx_cfg_t next = used;
+    uint8_t changed = 0;
+    if (peak > ar->high_pct){
+        ar->below = 0;
+        changed = MLX90393_AutorangeWiden(ar, &next);
+    } else if (peak < ar->low_pct){
+        if (++ar->below >= ar->hold){
+            ar->below = 0;
+            changed = MLX90393_AutorangeNarrow(ar, &next);
+        }
+    } else {
+        ar->below = 0;
+    }
+    if (!changed){
+        return 0;
+    }
+    ret = MLX90393_ApplySettings(ar->dev, &next); //Only CONF1 / CONF3 words that differ go on the bus
+    if (ret == 0){
+        ar->switches++;
+    }
+    return ret;
+}
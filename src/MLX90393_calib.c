@@ -0,0 +1,393 @@
+#include <math.h>
+#include <string.h>
+#include "MLX90393.h"
+#include "MLX90393_cmds.h"
+#include "MLX90393_lut.h"
+#include "MLX90393_calib.h"
+
+/** Helper functions**/
+/**
+ * @brief Solve the 9x9 normal equations by Gaussian elimination with partial pivoting
+ *
+ * @param ata Normal matrix (upper triangle used)
+ * @param atb Right-hand side
+ * @param v Solution
+ * @return int32_t Error code (MLX90393_AGAIN if the system is singular: not enough orientations seen)
+ */
+static int32_t MLX90393_CalibSolveNormal(const double ata[9][9], const double atb[9], double v[9]){
+    double m[9][10];
+    double max_diag = 0;
+    for (int r = 0; r < 9; r++){
+        for (int c = 0; c < 9; c++){
+            m[r][c] = r <= c ? ata[r][c] : ata[c][r];
+        }
+        m[r][9] = atb[r];
+        if (m[r][r] > max_diag) max_diag = m[r][r];
+    }
+    for (int col = 0; col < 9; col++){
+        int pivot = col;
+        for (int r = col + 1; r < 9; r++){
+            if (fabs(m[r][col]) > fabs(m[pivot][col])) pivot = r;
+        }
+        if (fabs(m[pivot][col]) <= 1e-12 * max_diag){
+            return MLX90393_AGAIN;
+        }
+        if (pivot != col){
+            for (int c = col; c < 10; c++){
+                double tmp = m[col][c];
+                m[col][c] = m[pivot][c];
+                m[pivot][c] = tmp;
+            }
+        }
+        for (int r = col + 1; r < 9; r++){
+            double f = m[r][col] / m[col][col];
+            for (int c = col; c < 10; c++){
+                m[r][c] -= f * m[col][c];
+            }
+        }
+    }
+    for (int r = 8; r >= 0; r--){
+        double acc = m[r][9];
+        for (int c = r + 1; c < 9; c++){
+            acc -= m[r][c] * v[c];
+        }
+        v[r] = acc / m[r][r];
+    }
+    return 0;
+}
+
+/**
+ * @brief Eigen decomposition of a symmetric 3x3 matrix (cyclic Jacobi rotations)
+ *
+ * @param a Matrix, destroyed (its diagonal holds the eigenvalues on return)
+ * @param vec Eigenvectors as columns
+ */
+static void MLX90393_CalibEigen3(double a[3][3], double vec[3][3]){
+    for (int r = 0; r < 3; r++){
+        for (int c = 0; c < 3; c++){
+            vec[r][c] = r == c;
+        }
+    }
+    for (int sweep = 0; sweep < 50; sweep++){
+        double off = fabs(a[0][1]) + fabs(a[0][2]) + fabs(a[1][2]);
+        if (off < 1e-15 * (fabs(a[0][0]) + fabs(a[1][1]) + fabs(a[2][2]))){
+            return;
+        }
+        for (int p = 0; p < 2; p++){
+            for (int q = p + 1; q < 3; q++){
+                if (a[p][q] == 0.0){
+                    continue;
+                }
+                double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+                double t = (theta >= 0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1.0));
+                double c = 1.0 / sqrt(t * t + 1.0);
+                double s = t * c;
+                for (int k = 0; k < 3; k++){ //A = A J
+                    double akp = a[k][p], akq = a[k][q];
+                    a[k][p] = c * akp - s * akq;
+                    a[k][q] = s * akp + c * akq;
+                }
+                for (int k = 0; k < 3; k++){ //A = J^T A
+                    double apk = a[p][k], aqk = a[q][k];
+                    a[p][k] = c * apk - s * aqk;
+                    a[q][k] = s * apk + c * aqk;
+                }
+                for (int k = 0; k < 3; k++){
+                    double vkp = vec[k][p], vkq = vec[k][q];
+                    vec[k][p] = c * vkp - s * vkq;
+                    vec[k][q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+}
+
+//FITTING
+/**
+ * @brief Reset the fit and set the correction to identity
+ *
+ * @param cal Calibration state
+ * @return int32_t Error code
+ */
+int32_t MLX90393_CalibInit(mlx_calib_t *cal){
+    if (cal == NULL){
+        return 1;
+    }
+    memset(cal, 0, sizeof(mlx_calib_t));
+    for (int axis = 0; axis < 3; axis++){
+        cal->matrix[axis][axis] = 1.0f;
+    }
+    return 0;
+}
+
+/**
+ * @brief Accumulate one sample into the fit
+ *
+ * @param cal Calibration state
+ * @param xyz Uncalibrated field [uT], taken with the settings the correction will be used with
+ * @return int32_t Error code
+ */
+int32_t MLX90393_CalibAdd(mlx_calib_t *cal, const float *xyz){
+    if (cal == NULL || xyz == NULL){
+        return 1;
+    }
+    if (cal->scale == 0.0){
+        double norm = sqrt((double) xyz[0] * xyz[0] + (double) xyz[1] * xyz[1] + (double) xyz[2] * xyz[2]);
+        if (norm == 0.0){
+            return 0; //Cannot set the scale with it, and a zero field says nothing about the ellipsoid
+        }
+        cal->scale = norm;
+    }
+    double x = xyz[0] / cal->scale, y = xyz[1] / cal->scale, z = xyz[2] / cal->scale;
+    double d[9] = {x * x, y * y, z * z, 2 * x * y, 2 * x * z, 2 * y * z, 2 * x, 2 * y, 2 * z};
+    for (int r = 0; r < 9; r++){
+        for (int c = r; c < 9; c++){
+            cal->ata[r][c] += d[r] * d[c];
+        }
+        cal->atb[r] += d[r];
+    }
+    cal->samples++;
+    return 0;
+}
+
+/**
+ * @brief Accumulate a block of decoded samples, e.g. the output of MLX90393_convertBatch
+ *
+ * @param cal Calibration state
+ * @param x X values [uT]
+ * @param y Y values [uT]
+ * @param z Z values [uT]
+ * @param n Number of samples
+ * @return int32_t Error code
+ */
+int32_t MLX90393_CalibAddBatch(mlx_calib_t *cal, const float *x, const float *y, const float *z, size_t n){
+    if (cal == NULL || x == NULL || y == NULL || z == NULL){
+        return 1;
+    }
+    for (size_t i = 0; i < n; i++){
+        float xyz[3] = {x[i], y[i], z[i]};
+        MLX90393_CalibAdd(cal, xyz);
+    }
+    return 0;
+}
+
+/**
+ * @brief Solve the fit accumulated so far and update offset, matrix and field_uT
+ *
+ * Can be called any number of times while samples keep coming in. On failure the previous
+ * correction is kept.
+ *
+ * @param cal Calibration state
+ * @return int32_t Error code (MLX90393_AGAIN if the samples do not cover enough orientations yet,
+ * MLX90393_MISMATCH if they do not lie on an ellipsoid)
+ */
+int32_t MLX90393_CalibSolve(mlx_calib_t *cal){
+    if (cal == NULL){
+        return 1;
+    }
+    if (cal->samples < MLX90393_CALIB_MIN_SAMPLES){
+        return MLX90393_AGAIN;
+    }
+    double v[9];
+    int32_t ret = MLX90393_CalibSolveNormal(cal->ata, cal->atb, v);
+    if (ret != 0){
+        return ret;
+    }
+
+    //Quadric A and linear term b, in units of scale
+    double a[3][3] = {{v[0], v[3], v[4]}, {v[3], v[1], v[5]}, {v[4], v[5], v[2]}};
+    double b[3] = {v[6], v[7], v[8]};
+    double cof[3][3];
+    for (int r = 0; r < 3; r++){
+        for (int c = 0; c < 3; c++){
+            int r1 = (r + 1) % 3, r2 = (r + 2) % 3, c1 = (c + 1) % 3, c2 = (c + 2) % 3;
+            cof[r][c] = a[r1][c1] * a[r2][c2] - a[r1][c2] * a[r2][c1];
+        }
+    }
+    double det = a[0][0] * cof[0][0] + a[0][1] * cof[0][1] + a[0][2] * cof[0][2];
+    if (det == 0.0){
+        return MLX90393_MISMATCH;
+    }
+    //Centre = -A^-1 b (A symmetric, so its inverse is cof / det)
+    double centre[3];
+    for (int r = 0; r < 3; r++){
+        centre[r] = -(cof[r][0] * b[0] + cof[r][1] * b[1] + cof[r][2] * b[2]) / det;
+    }
+    //(u - centre)^T A (u - centre) = 1 + centre^T A centre
+    double k = 1.0;
+    for (int r = 0; r < 3; r++){
+        for (int c = 0; c < 3; c++){
+            k += centre[r] * a[r][c] * centre[c];
+        }
+    }
+    if (k <= 0.0){
+        return MLX90393_MISMATCH;
+    }
+    for (int r = 0; r < 3; r++){
+        for (int c = 0; c < 3; c++){
+            a[r][c] /= k;
+        }
+    }
+
+    double vec[3][3];
+    MLX90393_CalibEigen3(a, vec);
+    double eig[3] = {a[0][0], a[1][1], a[2][2]};
+    if (eig[0] <= 0.0 || eig[1] <= 0.0 || eig[2] <= 0.0){
+        return MLX90393_MISMATCH; //Hyperboloid: the samples are not on a sphere seen through a linear distortion
+    }
+    //Sphere with the volume of the ellipsoid, so the correction keeps the average field strength
+    double radius = pow(eig[0] * eig[1] * eig[2], -1.0 / 6.0);
+    for (int r = 0; r < 3; r++){
+        for (int c = 0; c < 3; c++){
+            double acc = 0;
+            for (int e = 0; e < 3; e++){
+                acc += vec[r][e] * sqrt(eig[e]) * vec[c][e];
+            }
+            cal->matrix[r][c] = (float) (radius * acc);
+        }
+        cal->offset[r] = (float) (centre[r] * cal->scale);
+    }
+    cal->field_uT = (float) (radius * cal->scale);
+    cal->valid = 1;
+    return 0;
+}
+
+//CORRECTION
+/**
+ * @brief Correct one sample in place
+ *
+ * @param cal Calibration state
+ * @param xyz Field [uT]
+ * @return int32_t Error code
+ */
+int32_t MLX90393_CalibApply(const mlx_calib_t *cal, float *xyz){
+    if (cal == NULL || xyz == NULL){
+        return 1;
+    }
+    float d[3] = {xyz[0] - cal->offset[0], xyz[1] - cal->offset[1], xyz[2] - cal->offset[2]};
+    for (int r = 0; r < 3; r++){
+        xyz[r] = cal->matrix[r][0] * d[0] + cal->matrix[r][1] * d[1] + cal->matrix[r][2] * d[2];
+    }
+    return 0;
+}
+
+/**
+ * @brief Convert a block of raw RM payloads and apply the calibration in the same pass
+ *
+ * Same frame layout as MLX90393_convertBatch; zyxt must contain X, Y and Z (T is skipped). The
+ * sensitivities are folded into the matrix once per block, so the correction costs 9 multiply-adds
+ * per sample on top of the decode.
+ *
+ * @param cal Calibration state
+ * @param cfg Settings the measurements were taken with
+ * @param tcmp_en On-chip temperature compensation was enabled (changes the zero field offset of RES_16/RES_17)
+ * @param zyxt Magnetic axes-temperature measurement setting of the frames
+ * @param frames Raw payloads
+ * @param n Number of frames
+ * @param x Calibrated X values [uT] (n floats)
+ * @param y Calibrated Y values [uT] (n floats)
+ * @param z Calibrated Z values [uT] (n floats)
+ * @return int32_t Error code
+ */
+int32_t MLX90393_CalibConvertBatch(const mlx_calib_t *cal, const mlx_cfg_t *cfg, uint8_t tcmp_en, char zyxt,
+                                   const uint8_t *frames, size_t n, float *restrict x, float *restrict y, float *restrict z){
+    if (cal == NULL || cfg == NULL || frames == NULL || x == NULL || y == NULL || z == NULL ||
+        (zyxt & MLX90393_MAG_XYZ) != MLX90393_MAG_XYZ){
+        return 1;
+    }
+    const size_t stride = 2 * count_set_bits((uint8_t) zyxt);
+    const uint8_t *src = frames + ((zyxt & 0x01) ? 2 : 0);
+
+    //xyz_cal = matrix * (counts * sens - offset) = (matrix * diag(sens)) * counts - matrix * offset
+    mlx90393_resolution_t res[3] = {cfg->resolution_x, cfg->resolution_y, cfg->resolution_z};
+    uint16_t zero[3];
+    float m[3][3];
+    float bias[3];
+    for (int c = 0; c < 3; c++){
+        zero[c] = MLX90393_ZeroOffset(res[c], tcmp_en);
+    }
+    for (int r = 0; r < 3; r++){
+        bias[r] = 0;
+        for (int c = 0; c < 3; c++){
+            m[r][c] = cal->matrix[r][c] * MLX90393_Sensitivity_LookUp[cfg->gain][res[c]][c == 2];
+            bias[r] += cal->matrix[r][c] * cal->offset[c];
+        }
+    }
+
+    for (size_t i = 0; i < n; i++){
+        const uint8_t *p = src + i * stride;
+        float cx = (float) (int16_t) (uint16_t) ((uint16_t) ((p[0] << 8) | p[1]) - zero[0]);
+        float cy = (float) (int16_t) (uint16_t) ((uint16_t) ((p[2] << 8) | p[3]) - zero[1]);
+        float cz = (float) (int16_t) (uint16_t) ((uint16_t) ((p[4] << 8) | p[5]) - zero[2]);
+        x[i] = m[0][0] * cx + m[0][1] * cy + m[0][2] * cz - bias[0];
+        y[i] = m[1][0] * cx + m[1][1] * cy + m[1][2] * cz - bias[1];
+        z[i] = m[2][0] * cx + m[2][1] * cy + m[2][2] * cz - bias[2];
+    }
+    return 0;
+}
+
+//PERSISTENCE
+/**
+ * @brief Move the hard-iron offset into the OFFSET_X/Y/Z registers and store them with HS
+ *
+ * The device only applies the offset registers with temperature compensation (TCMP_EN) enabled,
+ * and they are in LSB of the current gain and resolution. On success the offset is cleared in cal,
+ * since the device removes it from then on; the soft-iron matrix stays on the host. The accumulated
+ * samples are discarded too: they were taken before the offset was applied, so a later fit starts over.
+ *
+ * @param cal Solved calibration
+ * @param dev Handle to MLX90393 device, with the settings the fit was made with
+ * @return int32_t Error code (MLX90393_AGAIN if there is no solved fit, MLX90393_MISMATCH if TCMP_EN is off,
+ * an offset does not fit in 16 bit or the device rejected HS)
+ */
+int32_t MLX90393_CalibStore(mlx_calib_t *cal, mlx_i2c_t *dev){
+    if (cal == NULL || dev == NULL || dev->settings == NULL){
+        return 1;
+    }
+    if (!cal->valid){
+        return MLX90393_AGAIN;
+    }
+
+    mlx_cfg_ext_t cfg;
+    int32_t ret = MLX90393_GetConfig(dev, &cfg);
+    if (ret == MLX90393_AGAIN){ //Shadow copy incomplete
+        ret = MLX90393_SyncRegisters(dev);
+        if (ret == 0){
+            ret = MLX90393_GetConfig(dev, &cfg);
+        }
+    }
+    if (ret != 0){
+        return ret;
+    }
+    if (!cfg.tcmp_en){
+        return MLX90393_MISMATCH;
+    }
+    for (int axis = 0; axis < 3; axis++){
+        float counts = cal->offset[axis] / MLX90393_GetSensitivity(dev->settings, axis);
+        if (counts < -32768.0f || counts > 32767.0f){
+            return MLX90393_MISMATCH;
+        }
+        cfg.offset[axis] = (uint16_t) (int16_t) lrintf(counts);
+    }
+    ret = MLX90393_ApplyConfig(dev, &cfg);
+    if (ret != 0){
+        return ret;
+    }
+
+    uint8_t status;
+    ret = MLX90393_HS(dev, &status);
+    if (ret != 0){
+        return ret;
+    }
+    if (status & MLX90393_STATUS_ERROR){
+        return MLX90393_MISMATCH;
+    }
+    for (int axis = 0; axis < 3; axis++){
+        cal->offset[axis] = 0;
+    }
+    memset(cal->ata, 0, sizeof(cal->ata));
+    memset(cal->atb, 0, sizeof(cal->atb));
+    cal->scale = 0;
+    cal->samples = 0;
+    return 0;
+}
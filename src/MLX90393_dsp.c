@@ -0,0 +1,289 @@
+#include <math.h>
+#include <string.h>
+#include "MLX90393.h"
+#include "MLX90393_dsp.h"
+
+/** Helper functions**/
+/**
+ * @brief Check and store the decimation factor common to every stage type
+ *
+ * @param dsp Filter stage
+ * @param type Stage type
+ * @param decim Keep one output out of decim samples
+ * @return int32_t Error code
+ */
+static int32_t MLX90393_DspSetup(mlx_dsp_t *dsp, mlx90393_dsp_type_t type, uint16_t decim){
+    if (dsp == NULL || decim == 0){
+        return 1;
+    }
+    memset(dsp, 0, sizeof(mlx_dsp_t));
+    dsp->type = type;
+    dsp->decim = decim;
+    return 0;
+}
+
+/**
+ * @brief Run one sample through a biquad section
+ *
+ * @param s Section
+ * @param x Input
+ * @return float Output
+ */
+static inline float MLX90393_Biquad(mlx_biquad_t *s, float x){
+    float y = s->b0 * x + s->z1;
+    s->z1 = s->b1 * x - s->a1 * y + s->z2;
+    s->z2 = s->b2 * x - s->a2 * y;
+    return y;
+}
+
+//SETUP
+/**
+ * @brief Set up a moving average over the last len samples
+ *
+ * Until the window has filled up, the output is the mean of the samples seen so far.
+ *
+ * @param dsp Filter stage
+ * @param window Storage for len samples, owned by the caller for the lifetime of the stage
+ * @param len Window length
+ * @param decim Keep one output out of decim samples (len == decim gives a block average)
+ * @return int32_t Error code
+ */
+int32_t MLX90393_DspMovingAverage(mlx_dsp_t *dsp, float *window, size_t len, uint16_t decim){
+    if (window == NULL || len == 0){
+        return 1;
+    }
+    int32_t ret = MLX90393_DspSetup(dsp, MLX90393_DSP_MOVAVG, decim);
+    if (ret != 0){
+        return ret;
+    }
+    dsp->movavg.window = window;
+    dsp->movavg.len = len;
+    return MLX90393_DspReset(dsp);
+}
+
+/**
+ * @brief Set up a Butterworth low-pass as a cascade of order / 2 biquads (bilinear transform)
+ *
+ * @param dsp Filter stage
+ * @param order Filter order (2, 4, ... 2 * MLX90393_DSP_MAX_SECTIONS)
+ * @param fc_hz -3 dB cut-off frequency
+ * @param fs_hz Sample rate of the input
+ * @param decim Keep one output out of decim samples (fc should stay below fs / (2 * decim))
+ * @return int32_t Error code
+ */
+int32_t MLX90393_DspButterworth(mlx_dsp_t *dsp, size_t order, float fc_hz, float fs_hz, uint16_t decim){
+    if (order == 0 || order % 2 != 0 || order / 2 > MLX90393_DSP_MAX_SECTIONS ||
+        !(fc_hz > 0.0f) || !(fc_hz < fs_hz / 2.0f)){
+        return 1;
+    }
+    int32_t ret = MLX90393_DspSetup(dsp, MLX90393_DSP_IIR, decim);
+    if (ret != 0){
+        return ret;
+    }
+    const double pi = 3.14159265358979323846;
+    const double w0 = 2.0 * pi * fc_hz / fs_hz;
+    const double cw = cos(w0);
+    dsp->iir.n = order / 2;
+    for (size_t k = 0; k < dsp->iir.n; k++){
+        //Pole pair k of the analogue prototype sets the Q of section k
+        double q = 1.0 / (2.0 * cos(pi * (2.0 * k + 1.0) / (2.0 * order)));
+        double alpha = sin(w0) / (2.0 * q);
+        double a0 = 1.0 + alpha;
+        mlx_biquad_t *s = &dsp->iir.sections[k];
+        s->b0 = (float) ((1.0 - cw) / 2.0 / a0);
+        s->b1 = (float) ((1.0 - cw) / a0);
+        s->b2 = s->b0;
+        s->a1 = (float) (-2.0 * cw / a0);
+        s->a2 = (float) ((1.0 - alpha) / a0);
+    }
+    return 0;
+}
+
+/**
+ * @brief Set up a CIC decimator (differential delay 1)
+ *
+ * Inputs are quantised to lsb and the filter runs on integers, so it never drifts. The first
+ * order outputs are the start-up transient.
+ *
+ * @param dsp Filter stage
+ * @param order Number of integrator / comb pairs (1 - MLX90393_DSP_CIC_MAX_ORDER)
+ * @param decim Decimation factor, decim^order must not exceed 2^32
+ * @param lsb Input quantisation [uT] (0 for MLX90393_DSP_CIC_LSB)
+ * @return int32_t Error code
+ */
+int32_t MLX90393_DspCIC(mlx_dsp_t *dsp, uint8_t order, uint16_t decim, float lsb){
+    if (order == 0 || order > MLX90393_DSP_CIC_MAX_ORDER || lsb < 0.0f){
+        return 1;
+    }
+    double gain = pow((double) decim, order);
+    if (gain > 4294967296.0){ //Keeps the register width above the bit growth of ~27 bit inputs
+        return 1;
+    }
+    int32_t ret = MLX90393_DspSetup(dsp, MLX90393_DSP_CIC, decim);
+    if (ret != 0){
+        return ret;
+    }
+    dsp->cic.order = order;
+    dsp->cic.lsb = lsb > 0.0f ? lsb : MLX90393_DSP_CIC_LSB;
+    dsp->cic.scale = (float) (dsp->cic.lsb / gain);
+    return 0;
+}
+
+/**
+ * @brief Clear the filter history, keeping the configuration
+ *
+ * @param dsp Filter stage
+ * @return int32_t Error code
+ */
+int32_t MLX90393_DspReset(mlx_dsp_t *dsp){
+    if (dsp == NULL){
+        return 1;
+    }
+    dsp->phase = 0;
+    switch (dsp->type){
+        case MLX90393_DSP_MOVAVG:
+            memset(dsp->movavg.window, 0, dsp->movavg.len * sizeof(float));
+            dsp->movavg.pos = 0;
+            dsp->movavg.count = 0;
+            dsp->movavg.sum = 0;
+            break;
+        case MLX90393_DSP_IIR:
+            for (size_t k = 0; k < dsp->iir.n; k++){
+                dsp->iir.sections[k].z1 = 0;
+                dsp->iir.sections[k].z2 = 0;
+            }
+            break;
+        case MLX90393_DSP_CIC:
+            memset(dsp->cic.integ, 0, sizeof(dsp->cic.integ));
+            memset(dsp->cic.comb, 0, sizeof(dsp->cic.comb));
+            break;
+        default:
+            return 1;
+    }
+    return 0;
+}
+
+//PROCESSING
+/**
+ * @brief Filter a block of samples of one axis
+ *
+ * in and out may be the same array: outputs never overtake the inputs.
+ *
+ * @param dsp Filter stage
+ * @param in n input samples
+ * @param out Filtered samples (room for n / decim + 1)
+ * @param n Number of input samples
+ * @param n_out Number of samples written to out
+ * @return int32_t Error code
+ */
+int32_t MLX90393_DspRun(mlx_dsp_t *dsp, const float *in, float *out, size_t n, size_t *n_out){
+    if (dsp == NULL || in == NULL || out == NULL || n_out == NULL){
+        return 1;
+    }
+    size_t k = 0;
+    uint16_t phase = dsp->phase;
+    const uint16_t decim = dsp->decim;
+
+    switch (dsp->type){
+        case MLX90393_DSP_MOVAVG:{
+            float *window = dsp->movavg.window;
+            const size_t len = dsp->movavg.len;
+            size_t pos = dsp->movavg.pos;
+            size_t count = dsp->movavg.count;
+            double sum = dsp->movavg.sum;
+            for (size_t i = 0; i < n; i++){
+                float x = in[i];
+                sum += (double) x - window[pos]; //Slot is 0 until the window has filled up
+                window[pos] = x;
+                pos = pos + 1 == len ? 0 : pos + 1;
+                count += count < len;
+                if (++phase == decim){
+                    phase = 0;
+                    out[k++] = (float) (sum / (double) count);
+                }
+            }
+            dsp->movavg.pos = pos;
+            dsp->movavg.count = count;
+            dsp->movavg.sum = sum;
+            break;
+        }
+        case MLX90393_DSP_IIR:{
+            const size_t sections = dsp->iir.n;
+            for (size_t i = 0; i < n; i++){
+                float y = in[i];
+                for (size_t s = 0; s < sections; s++){
+                    y = MLX90393_Biquad(&dsp->iir.sections[s], y);
+                }
+                if (++phase == decim){
+                    phase = 0;
+                    out[k++] = y;
+                }
+            }
+            break;
+        }
+        case MLX90393_DSP_CIC:{
+            const uint8_t order = dsp->cic.order;
+            const float inv_lsb = 1.0f / dsp->cic.lsb;
+            uint64_t *integ = dsp->cic.integ;
+            uint64_t *comb = dsp->cic.comb;
+            for (size_t i = 0; i < n; i++){
+                uint64_t v = (uint64_t) (int64_t) lrintf(in[i] * inv_lsb);
+                for (uint8_t s = 0; s < order; s++){
+                    integ[s] += v;
+                    v = integ[s];
+                }
+                if (++phase == decim){
+                    phase = 0;
+                    for (uint8_t s = 0; s < order; s++){
+                        uint64_t d = v - comb[s];
+                        comb[s] = v;
+                        v = d;
+                    }
+                    out[k++] = (float) (int64_t) v * dsp->cic.scale;
+                }
+            }
+            break;
+        }
+        default:
+            return 1;
+    }
+    dsp->phase = phase;
+    *n_out = k;
+    return 0;
+}
+
+/**
+ * @brief Filter a block of decoded XYZ samples in place, e.g. the output of MLX90393_convertBatch
+ *
+ * @param dsp Filter stages for X, Y and Z
+ * @param x [Optional] X samples
+ * @param y [Optional] Y samples
+ * @param z [Optional] Z samples
+ * @param n Number of input samples per axis
+ * @param n_out Number of filtered samples left at the start of each array
+ * @return int32_t Error code (MLX90393_MISMATCH if the axes decimate differently)
+ */
+int32_t MLX90393_DspRunXYZ(mlx_dsp_t *dsp, float *x, float *y, float *z, size_t n, size_t *n_out){
+    if (dsp == NULL || n_out == NULL){
+        return 1;
+    }
+    float *axes[3] = {x, y, z};
+    size_t produced[3];
+    int first = -1;
+    for (int axis = 0; axis < 3; axis++){
+        if (axes[axis] == NULL){
+            continue;
+        }
+        int32_t ret = MLX90393_DspRun(&dsp[axis], axes[axis], axes[axis], n, &produced[axis]);
+        if (ret != 0){
+            return ret;
+        }
+        if (first < 0){
+            first = axis;
+        } else if (produced[axis] != produced[first]){
+            return MLX90393_MISMATCH;
+        }
+    }
+    *n_out = first < 0 ? 0 : produced[first];
+    return 0;
+}
@@ -0,0 +1,246 @@
+#include "MLX90393.h"
+#include "MLX90393_linux.h"
+
+#if defined(__linux__)
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+//GCOV_EXCL_START
+int __attribute__((weak)) mlx_sys_open(const char *path, int flags){
+    return open(path, flags);
+}
+
+int __attribute__((weak)) mlx_sys_ioctl(int fd, unsigned long request, void *arg){
+    return ioctl(fd, request, arg);
+}
+
+int __attribute__((weak)) mlx_sys_close(int fd){
+    return close(fd);
+}
+//GCOV_EXCL_STOP
+
+/** Helper functions**/
+/**
+ * @brief Error code of the last failed syscall
+ * 
+ * @return int32_t -errno (-EIO if errno was not set)
+ */
+static int32_t MLX90393_LinuxErrno(void){
+    return errno != 0 ? -errno : -EIO;
+}
+
+/**
+ * @brief Issue a single I2C_RDWR ioctl over a prepared message array
+ * 
+ * @param fd i2c-dev descriptor
+ * @param msgs Messages, executed with repeated starts between them
+ * @param nmsgs Number of messages
+ * @return int32_t Error code
+ */
+static int32_t MLX90393_LinuxRdwr(int fd, struct i2c_msg *msgs, size_t nmsgs){
+    struct i2c_rdwr_ioctl_data rdwr = {
+        .msgs = msgs,
+        .nmsgs = (uint32_t) nmsgs
+    };
+    errno = 0;
+    int ret = mlx_sys_ioctl(fd, I2C_RDWR, &rdwr);
+    if (ret < 0){
+        return MLX90393_LinuxErrno();
+    }
+    if ((size_t) ret != nmsgs){
+        return -EIO;
+    }
+    return 0;
+}
+
+// BUS
+/**
+ * @brief Open the /dev/i2c-<adapter> character device
+ * 
+ * @param adapter I2C adapter number
+ * @param fd Returned descriptor, to be shared by all the devices on the bus
+ * @return int32_t Error code (-errno if open fails)
+ */
+int32_t MLX90393_LinuxOpen(int adapter, int *fd){
+    char path[32];
+    if (fd == NULL || adapter < 0){
+        return 1;
+    }
+    snprintf(path, sizeof(path), "/dev/i2c-%d", adapter);
+    errno = 0;
+    int ret = mlx_sys_open(path, O_RDWR);
+    if (ret < 0){
+        return MLX90393_LinuxErrno();
+    }
+    *fd = ret;
+    return 0;
+}
+
+/**
+ * @brief Close an i2c-dev descriptor opened with MLX90393_LinuxOpen
+ * 
+ * @param fd i2c-dev descriptor
+ * @return int32_t Error code (-errno if close fails)
+ */
+int32_t MLX90393_LinuxClose(int fd){
+    errno = 0;
+    if (mlx_sys_close(fd) < 0){
+        return MLX90393_LinuxErrno();
+    }
+    return 0;
+}
+
+/**
+ * @brief Bind a device to an i2c-dev link and install the Linux transport hooks
+ * 
+ * Every command then costs a single I2C_RDWR ioctl (write and response read combined).
+ * 
+ * @param dev Handle to MLX90393 device
+ * @param link Link storage, must outlive the device
+ * @param fd i2c-dev descriptor
+ * @param addr 7-bit I2C address of the device
+ * @return int32_t Error code
+ */
+int32_t MLX90393_LinuxAttach(mlx_i2c_t *dev, mlx_linux_t *link, int fd, uint16_t addr){
+    if (dev == NULL || link == NULL || fd < 0){
+        return 1;
+    }
+    link->fd = fd;
+    link->addr = addr;
+    dev->handle = link;
+    dev->write_function = MLX90393_LinuxWrite;
+    dev->read_function = MLX90393_LinuxRead;
+    dev->transfer = MLX90393_LinuxTransfer;
+    return 0;
+}
+
+// TRANSPORT HOOKS
+/**
+ * @brief mlx_wr_ptr hook: plain write through I2C_RDWR (no I2C_SLAVE address ioctl needed)
+ * 
+ * @param dev Handle to MLX90393 device (handle must be a mlx_linux_t)
+ * @param buf Bytes to write
+ * @param len Number of bytes
+ * @return int32_t Error code
+ */
+int32_t MLX90393_LinuxWrite(mlx_i2c_t *dev, uint8_t *buf, size_t len){
+    return MLX90393_LinuxTransfer(dev, buf, len, NULL, 0);
+}
+
+/**
+ * @brief mlx_rd_ptr hook: plain read through I2C_RDWR
+ * 
+ * @param dev Handle to MLX90393 device (handle must be a mlx_linux_t)
+ * @param data Buffer for the bytes read
+ * @param len Number of bytes
+ * @return int32_t Error code
+ */
+int32_t MLX90393_LinuxRead(mlx_i2c_t *dev, uint8_t *data, size_t len){
+    return MLX90393_LinuxTransfer(dev, NULL, 0, data, len);
+}
+
+/**
+ * @brief mlx_xfer_ptr hook: write followed by a repeated-start read, in one ioctl
+ * 
+ * @param dev Handle to MLX90393 device (handle must be a mlx_linux_t)
+ * @param wbuf [Optional] Bytes to write
+ * @param wlen Number of bytes to write
+ * @param rbuf [Optional] Buffer for the bytes read
+ * @param rlen Number of bytes to read
+ * @return int32_t Error code
+ */
+int32_t MLX90393_LinuxTransfer(mlx_i2c_t *dev, uint8_t *wbuf, size_t wlen, uint8_t *rbuf, size_t rlen){
+    if (dev == NULL || dev->handle == NULL){
+        return 1;
+    }
+    mlx_linux_t *link = (mlx_linux_t *) dev->handle;
+    mlx_linux_xfer_t xfer = {
+        .addr = link->addr,
+        .wbuf = wbuf,
+        .wlen = wlen,
+        .rbuf = rbuf,
+        .rlen = rlen
+    };
+    return MLX90393_LinuxBatch(link->fd, &xfer, 1);
+}
+
+// BATCHING
+/**
+ * @brief Run several write-read transactions, possibly to different devices, in one I2C_RDWR ioctl
+ * 
+ * @param fd i2c-dev descriptor
+ * @param xfers Transactions, executed in order
+ * @param n Number of transactions (their messages must fit in MLX90393_LINUX_MAX_MSGS)
+ * @return int32_t Error code
+ */
+int32_t MLX90393_LinuxBatch(int fd, mlx_linux_xfer_t *xfers, size_t n){
+    struct i2c_msg msgs[MLX90393_LINUX_MAX_MSGS];
+    size_t nmsgs = 0;
+    if (xfers == NULL || n == 0){
+        return 1;
+    }
+    for (size_t i = 0; i < n; i++){
+        mlx_linux_xfer_t *x = &xfers[i];
+        size_t needed = (x->wlen > 0) + (x->rlen > 0);
+        if (needed == 0 || nmsgs + needed > MLX90393_LINUX_MAX_MSGS ||
+            (x->wlen > 0 && x->wbuf == NULL) || (x->rlen > 0 && x->rbuf == NULL)){
+            return 1;
+        }
+        if (x->wlen > 0){
+            msgs[nmsgs++] = (struct i2c_msg) { .addr = x->addr, .flags = 0, .len = (uint16_t) x->wlen, .buf = x->wbuf };
+        }
+        if (x->rlen > 0){
+            msgs[nmsgs++] = (struct i2c_msg) { .addr = x->addr, .flags = I2C_M_RD, .len = (uint16_t) x->rlen, .buf = x->rbuf };
+        }
+    }
+    return MLX90393_LinuxRdwr(fd, msgs, nmsgs);
+}
+
+/**
+ * @brief Read the measurement of several devices on the same bus with a single ioctl (RM to each)
+ * 
+ * The payloads are stored back to back (2 bytes per bit set in zyxt), the layout MLX90393_convertBatch expects.
+ * 
+ * @param devs Devices, all attached to the same descriptor
+ * @param n Number of devices (up to MLX90393_LINUX_MAX_BATCH)
+ * @param zyxt Magnetic axes-temperature measurement setting
+ * @param status Status byte of each device (n bytes)
+ * @param data Payloads (n * 2 * bits set in zyxt bytes)
+ * @return int32_t Error code
+ */
+int32_t MLX90393_LinuxReadMeasurements(mlx_i2c_t **devs, size_t n, char zyxt, uint8_t *status, uint8_t *data){
+    mlx_linux_xfer_t xfers[MLX90393_LINUX_MAX_BATCH];
+    uint8_t frames[MLX90393_LINUX_MAX_BATCH][9];
+    uint8_t cmd = 0x40 | (uint8_t) zyxt;
+    size_t payload = 2 * count_set_bits((uint8_t) zyxt);
+    if (devs == NULL || status == NULL || data == NULL || n == 0 || n > MLX90393_LINUX_MAX_BATCH){
+        return 1;
+    }
+    for (size_t i = 0; i < n; i++){
+        if (devs[i] == NULL || devs[i]->handle == NULL){
+            return 1;
+        }
+        mlx_linux_t *link = (mlx_linux_t *) devs[i]->handle;
+        if (link->fd != ((mlx_linux_t *) devs[0]->handle)->fd){
+            return 1;
+        }
+        xfers[i] = (mlx_linux_xfer_t) { .addr = link->addr, .wbuf = &cmd, .wlen = 1, .rbuf = frames[i], .rlen = 1 + payload };
+    }
+    int32_t ret = MLX90393_LinuxBatch(((mlx_linux_t *) devs[0]->handle)->fd, xfers, n);
+    if (ret != 0){
+        return ret;
+    }
+    for (size_t i = 0; i < n; i++){
+        status[i] = frames[i][0];
+        memcpy(&data[i * payload], &frames[i][1], payload);
+    }
+    return 0;
+}
+
+#endif
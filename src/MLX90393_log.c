@@ -0,0 +1,522 @@
+#include <errno.h>
+#include <string.h>
+#include "MLX90393.h"
+#include "MLX90393_log.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define MLX90393_LOG_MMAP 1
+#endif
+
+static const uint8_t mlx_log_magic[8] = {'M', 'L', 'X', '9', '3', 'L', 'G', MLX90393_LOG_VERSION};
+
+/** Helper functions**/
+/**
+ * @brief Error code of the last failed library call
+ *
+ * @return int32_t -errno (-EIO if errno was not set)
+ */
+static int32_t MLX90393_LogErrno(void){
+    return errno != 0 ? -errno : -EIO;
+}
+
+static void MLX90393_LogPut32(uint8_t *p, uint32_t v){
+    for (int i = 0; i < 4; i++){
+        p[i] = (uint8_t) (v >> (8 * i));
+    }
+}
+
+static void MLX90393_LogPut64(uint8_t *p, uint64_t v){
+    for (int i = 0; i < 8; i++){
+        p[i] = (uint8_t) (v >> (8 * i));
+    }
+}
+
+static uint32_t MLX90393_LogGet32(const uint8_t *p){
+    uint32_t v = 0;
+    for (int i = 3; i >= 0; i--){
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+static uint64_t MLX90393_LogGet64(const uint8_t *p){
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--){
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+/**
+ * @brief Write raw bytes to the log file
+ *
+ * @param w Log writer
+ * @param buf Bytes
+ * @param len Number of bytes
+ * @return int32_t Error code
+ */
+static int32_t MLX90393_LogPut(mlx_log_writer_t *w, const uint8_t *buf, size_t len){
+    errno = 0;
+    if (fwrite(buf, 1, len, w->fp) != len){
+        return MLX90393_LogErrno();
+    }
+    return 0;
+}
+
+/**
+ * @brief Make the next frame available in r->block, reading CONFIG records on the way
+ *
+ * @param r Log reader
+ * @return int32_t Error code (MLX90393_AGAIN at the end of the log, MLX90393_MISMATCH if it is corrupt)
+ */
+static int32_t MLX90393_LogAdvance(mlx_log_reader_t *r){
+    while (r->index >= r->count){
+        if (r->pos >= r->size){
+            return MLX90393_AGAIN;
+        }
+        const uint8_t *p = r->map + r->pos;
+        size_t left = r->size - r->pos;
+        if (p[0] == MLX90393_LOG_CONFIG){
+            if (left < 13){
+                return MLX90393_AGAIN; //Cut short
+            }
+            if (p[5] > MLX90393_GAIN_1X || p[6] > MLX90393_RES_19 || p[7] > MLX90393_RES_19 || p[8] > MLX90393_RES_19 ||
+                p[9] > MLX90393_FILTER_7 || p[10] > MLX90393_OSR_3 || count_set_bits(p[12] & 0x0F) == 0){
+                return MLX90393_MISMATCH;
+            }
+            r->cfg_gen = MLX90393_LogGet32(p + 1);
+            r->cfg.gain = (mlx90393_gain_t) p[5];
+            r->cfg.resolution_x = (mlx90393_resolution_t) p[6];
+            r->cfg.resolution_y = (mlx90393_resolution_t) p[7];
+            r->cfg.resolution_z = (mlx90393_resolution_t) p[8];
+            r->cfg.filter = (mlx90393_filter_t) p[9];
+            r->cfg.oversampling = (mlx90393_oversampling_t) p[10];
+            r->tcmp_en = p[11];
+            r->zyxt = (char) (p[12] & 0x0F);
+            r->stride = 2 * count_set_bits((uint8_t) r->zyxt);
+            r->configs++;
+            r->pos += 13;
+        } else if (p[0] == MLX90393_LOG_FRAMES){
+            if (r->stride == 0){
+                return MLX90393_MISMATCH; //Frames without a configuration
+            }
+            if (left < 19){
+                return MLX90393_AGAIN;
+            }
+            uint16_t count = (uint16_t) (p[1] | (p[2] << 8));
+            size_t len = 19 + (size_t) count * r->stride;
+            if (left < len){
+                return MLX90393_AGAIN;
+            }
+            r->t_first_us = MLX90393_LogGet64(p + 3);
+            r->t_last_us = MLX90393_LogGet64(p + 11);
+            r->block = p + 19;
+            r->count = count;
+            r->index = 0;
+            r->pos += len;
+        } else {
+            return MLX90393_MISMATCH;
+        }
+    }
+    return 0;
+}
+
+//WRITER
+/**
+ * @brief Create (truncate) a log file and write its header
+ *
+ * @param w Log writer
+ * @param path File to create
+ * @return int32_t Error code (-errno on I/O errors)
+ */
+int32_t MLX90393_LogOpen(mlx_log_writer_t *w, const char *path){
+    if (w == NULL || path == NULL){
+        return 1;
+    }
+    memset(w, 0, sizeof(mlx_log_writer_t));
+    errno = 0;
+    w->fp = fopen(path, "wb");
+    if (w->fp == NULL){
+        return MLX90393_LogErrno();
+    }
+    setvbuf(w->fp, NULL, _IOFBF, MLX90393_LOG_IO_BUFFER);
+    int32_t ret = MLX90393_LogPut(w, mlx_log_magic, sizeof(mlx_log_magic));
+    if (ret != 0){
+        fclose(w->fp);
+        w->fp = NULL;
+    }
+    return ret;
+}
+
+/**
+ * @brief Start a new configuration: the following frames are decoded with it
+ *
+ * @param w Log writer
+ * @param cfg Settings of the following frames
+ * @param tcmp_en On-chip temperature compensation enabled (see MLX90393_TcmpEnabled)
+ * @param zyxt Channels in each frame
+ * @param cfg_gen mlx_i2c_t.cfg_gen of the device
+ * @return int32_t Error code
+ */
+int32_t MLX90393_LogConfig(mlx_log_writer_t *w, const mlx_cfg_t *cfg, uint8_t tcmp_en, char zyxt, uint32_t cfg_gen){
+    if (w == NULL || w->fp == NULL || cfg == NULL || count_set_bits((uint8_t) zyxt & 0x0F) == 0){
+        return 1;
+    }
+    int32_t ret = MLX90393_LogFlush(w);
+    if (ret != 0){
+        return ret;
+    }
+    uint8_t rec[13] = {MLX90393_LOG_CONFIG};
+    MLX90393_LogPut32(rec + 1, cfg_gen);
+    rec[5] = cfg->gain;
+    rec[6] = cfg->resolution_x;
+    rec[7] = cfg->resolution_y;
+    rec[8] = cfg->resolution_z;
+    rec[9] = cfg->filter;
+    rec[10] = cfg->oversampling;
+    rec[11] = tcmp_en != 0;
+    rec[12] = (uint8_t) zyxt & 0x0F;
+    ret = MLX90393_LogPut(w, rec, sizeof(rec));
+    if (ret == 0){
+        w->stride = 2 * count_set_bits(rec[12]);
+    }
+    return ret;
+}
+
+/**
+ * @brief Append one raw RM payload (without the status byte)
+ *
+ * @param w Log writer
+ * @param data 2 bytes per channel of the current configuration, as read from the sensor
+ * @param t_us Time of the frame (e.g. mlx_sample_t.t_done_us)
+ * @return int32_t Error code (MLX90393_MISMATCH before the first MLX90393_LogConfig)
+ */
+int32_t MLX90393_LogFrame(mlx_log_writer_t *w, const uint8_t *data, uint64_t t_us){
+    if (w == NULL || w->fp == NULL || data == NULL){
+        return 1;
+    }
+    if (w->stride == 0){
+        return MLX90393_MISMATCH;
+    }
+    if (w->count == 0){
+        w->t_first_us = t_us;
+    }
+    memcpy(w->block + (size_t) w->count * w->stride, data, w->stride);
+    w->t_last_us = t_us;
+    w->count++;
+    w->frames++;
+    if (w->count == MLX90393_LOG_BLOCK){
+        return MLX90393_LogFlush(w);
+    }
+    return 0;
+}
+
+/**
+ * @brief Write the pending frames as a FRAMES record (stdio may still buffer it)
+ *
+ * @param w Log writer
+ * @return int32_t Error code
+ */
+int32_t MLX90393_LogFlush(mlx_log_writer_t *w){
+    if (w == NULL || w->fp == NULL){
+        return 1;
+    }
+    if (w->count == 0){
+        return 0;
+    }
+    uint8_t rec[19] = {MLX90393_LOG_FRAMES, (uint8_t) w->count, (uint8_t) (w->count >> 8)};
+    MLX90393_LogPut64(rec + 3, w->t_first_us);
+    MLX90393_LogPut64(rec + 11, w->t_last_us);
+    int32_t ret = MLX90393_LogPut(w, rec, sizeof(rec));
+    if (ret == 0){
+        ret = MLX90393_LogPut(w, w->block, (size_t) w->count * w->stride);
+    }
+    w->count = 0;
+    return ret;
+}
+
+/**
+ * @brief Flush the pending frames and close the file
+ *
+ * @param w Log writer
+ * @return int32_t Error code
+ */
+int32_t MLX90393_LogClose(mlx_log_writer_t *w){
+    if (w == NULL || w->fp == NULL){
+        return 1;
+    }
+    int32_t ret = MLX90393_LogFlush(w);
+    errno = 0;
+    if (fclose(w->fp) != 0 && ret == 0){
+        ret = MLX90393_LogErrno();
+    }
+    w->fp = NULL;
+    return ret;
+}
+
+//READER
+/**
+ * @brief Map a log file read-only
+ *
+ * @param r Log reader
+ * @param path Log file
+ * @return int32_t Error code (-errno on I/O errors, MLX90393_MISMATCH if it is not a log)
+ */
+int32_t MLX90393_LogMap(mlx_log_reader_t *r, const char *path){
+    if (r == NULL || path == NULL){
+        return 1;
+    }
+    memset(r, 0, sizeof(mlx_log_reader_t));
+#ifdef MLX90393_LOG_MMAP
+    errno = 0;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0){
+        return MLX90393_LogErrno();
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0){
+        int32_t ret = MLX90393_LogErrno();
+        close(fd);
+        return ret;
+    }
+    if ((size_t) st.st_size < sizeof(mlx_log_magic)){
+        close(fd);
+        return MLX90393_MISMATCH;
+    }
+    void *map = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    int32_t ret = map == MAP_FAILED ? MLX90393_LogErrno() : 0;
+    close(fd); //The mapping stays valid
+    if (ret != 0){
+        return ret;
+    }
+    r->map = map;
+    r->size = (size_t) st.st_size;
+    if (memcmp(r->map, mlx_log_magic, sizeof(mlx_log_magic)) != 0){
+        MLX90393_LogUnmap(r);
+        return MLX90393_MISMATCH;
+    }
+    r->pos = sizeof(mlx_log_magic);
+    return 0;
+#else
+    return 1; //No mmap on this platform
+#endif
+}
+
+/**
+ * @brief Release the mapping of a log file
+ *
+ * @param r Log reader
+ * @return int32_t Error code
+ */
+int32_t MLX90393_LogUnmap(mlx_log_reader_t *r){
+    if (r == NULL || r->map == NULL){
+        return 1;
+    }
+#ifdef MLX90393_LOG_MMAP
+    munmap((void *) r->map, r->size);
+#endif
+    r->map = NULL;
+    r->size = 0;
+    r->count = 0;
+    r->index = 0;
+    return 0;
+}
+
+/**
+ * @brief Get the remaining frames of the current FRAMES record (or the next one), e.g. for MLX90393_convertBatch
+ *
+ * r->cfg, r->tcmp_en and r->zyxt describe the returned frames and are the arguments to pass to
+ * MLX90393_convertBatch. The frames point into the mapping and stay valid until MLX90393_LogUnmap.
+ *
+ * @param r Log reader
+ * @param frames Raw payloads, r->stride bytes each
+ * @param n Number of frames
+ * @return int32_t Error code (MLX90393_AGAIN at the end of the log, MLX90393_MISMATCH if it is corrupt)
+ */
+int32_t MLX90393_LogNextBlock(mlx_log_reader_t *r, const uint8_t **frames, size_t *n){
+    if (r == NULL || r->map == NULL || frames == NULL || n == NULL){
+        return 1;
+    }
+    int32_t ret = MLX90393_LogAdvance(r);
+    if (ret != 0){
+        return ret;
+    }
+    *frames = r->block + (size_t) r->index * r->stride;
+    *n = r->count - r->index;
+    r->seq += *n;
+    r->index = r->count;
+    return 0;
+}
+
+/**
+ * @brief Decode the next frame with the same conversion as MLX90393_readMeasurement
+ *
+ * The timestamps are interpolated over the FRAMES record, seq counts the frames of the log.
+ *
+ * @param r Log reader
+ * @param sample Decoded measurement
+ * @return int32_t Error code (MLX90393_AGAIN at the end of the log, MLX90393_MISMATCH if it is corrupt)
+ */
+int32_t MLX90393_LogNext(mlx_log_reader_t *r, mlx_sample_t *sample){
+    if (r == NULL || r->map == NULL || sample == NULL){
+        return 1;
+    }
+    int32_t ret = MLX90393_LogAdvance(r);
+    if (ret != 0){
+        return ret;
+    }
+    const uint8_t *frame = r->block + (size_t) r->index * r->stride;
+    ret = MLX90393_convert(&r->cfg, r->tcmp_en, r->zyxt, frame, sample);
+    if (ret != 0){
+        return ret;
+    }
+    uint64_t t = r->t_first_us;
+    if (r->count > 1){
+        t += (r->t_last_us - r->t_first_us) * r->index / (uint64_t) (r->count - 1);
+    }
+    sample->status = 0;
+    sample->cfg_gen = r->cfg_gen;
+    sample->seq = r->seq++;
+    sample->t_issue_us = t;
+    sample->t_expected_us = t;
+    sample->t_done_us = t;
+    r->index++;
+    return 0;
+}
+
+//REPLAY
+static void MLX90393_LogReplayDelay(uint32_t ms){
+    (void) ms; //Logged frames are ready at once
+}
+
+/**
+ * @brief Bring the device state in line with the configuration of the frames being replayed
+ *
+ * @param dev Handle to MLX90393 device
+ * @param replay Replay state
+ */
+static void MLX90393_LogReplayApply(mlx_i2c_t *dev, mlx_log_replay_t *replay){
+    const mlx_log_reader_t *r = replay->reader;
+    replay->configs = r->configs;
+    replay->conf[0] = 0x000C | (uint16_t) (r->cfg.gain << 4);
+    replay->conf[1] = (uint16_t) (r->tcmp_en << 10);
+    replay->conf[2] = (uint16_t) (r->cfg.oversampling | r->cfg.filter << 2 | r->cfg.resolution_x << 5 |
+                                  r->cfg.resolution_y << 7 | r->cfg.resolution_z << 9);
+    if (dev->settings != NULL){
+        *dev->settings = r->cfg;
+    }
+    dev->cfg_gen = r->cfg_gen;
+    for (int reg = 0; reg < 3; reg++){
+        dev->regs[MLX90393_REG_CONF1 + reg] = replay->conf[reg];
+    }
+    dev->regs_valid |= 0x07 << MLX90393_REG_CONF1;
+}
+
+/**
+ * @brief Connect a device to a log: RM returns the logged frames in order
+ *
+ * @param dev Handle to MLX90393 device (settings, if set, follow the log)
+ * @param replay Replay state
+ * @param reader Mapped log, positioned where the replay starts
+ * @return int32_t Error code
+ */
+int32_t MLX90393_LogReplayAttach(mlx_i2c_t *dev, mlx_log_replay_t *replay, mlx_log_reader_t *reader){
+    if (dev == NULL || replay == NULL || reader == NULL || reader->map == NULL){
+        return 1;
+    }
+    memset(replay, 0, sizeof(mlx_log_replay_t));
+    replay->reader = reader;
+    replay->conf[0] = 0x000C; //HALLCONF default until the first CONFIG
+    dev->handle = replay;
+    dev->write_function = MLX90393_LogReplayWrite;
+    dev->read_function = MLX90393_LogReplayRead;
+    dev->transfer = NULL;
+    dev->mdelay = MLX90393_LogReplayDelay;
+    dev->udelay = NULL;
+    dev->clock_us = NULL;
+    if (reader->stride != 0){ //Attached in the middle of the log
+        MLX90393_LogReplayApply(dev, replay);
+    }
+    return 0;
+}
+
+/**
+ * @brief Transport hook: execute a command against the log
+ *
+ * @param dev Handle to MLX90393 device
+ * @param buf Command bytes
+ * @param len Number of command bytes
+ * @return int32_t Error code
+ */
+int32_t MLX90393_LogReplayWrite(mlx_i2c_t *dev, uint8_t *buf, size_t len){
+    if (dev == NULL || dev->handle == NULL || buf == NULL || len == 0){
+        return 1;
+    }
+    mlx_log_replay_t *replay = dev->handle;
+    mlx_log_reader_t *r = replay->reader;
+    uint8_t cmd = buf[0] & 0xF0;
+    uint8_t zyxt = buf[0] & 0x0F;
+    uint8_t status = 0;
+    memset(replay->response, 0, sizeof(replay->response));
+    replay->response_len = 1;
+
+    if (cmd == 0x40){ //RM
+        replay->response_len = 1 + 2 * count_set_bits(zyxt);
+        if (zyxt == 0 || MLX90393_LogAdvance(r) != 0 || (zyxt & ~r->zyxt) != 0){
+            status = MLX90393_STATUS_ERROR; //End of the log, or channels that were not recorded
+        } else {
+            if (replay->configs != r->configs){ //Reconfigured while recording
+                MLX90393_LogReplayApply(dev, replay);
+            }
+            const uint8_t *frame = r->block + (size_t) r->index * r->stride;
+            size_t src = 0, dst = 1;
+            for (int ch = 0; ch < 4; ch++){ //Sensor order T, X, Y, Z
+                if (!(r->zyxt & (1 << ch))){
+                    continue;
+                }
+                if (zyxt & (1 << ch)){
+                    replay->response[dst++] = frame[src];
+                    replay->response[dst++] = frame[src + 1];
+                }
+                src += 2;
+            }
+            r->index++;
+            r->seq++;
+            status = count_set_bits(zyxt) - 1; //D1:D0
+        }
+    } else if (cmd == 0x50){ //RR
+        uint8_t reg = len > 1 ? buf[1] >> 2 : 0xFF;
+        replay->response_len = 3;
+        if (reg <= MLX90393_REG_CONF3){
+            replay->response[1] = replay->conf[reg] >> 8;
+            replay->response[2] = replay->conf[reg] & 0xFF;
+        } else if (reg > MLX90393_REG_WOT_THRESHOLD){
+            status = MLX90393_STATUS_ERROR;
+        }
+    }
+    replay->response[0] = status;
+    return 0;
+}
+
+/**
+ * @brief Transport hook: return the response of the last command
+ *
+ * @param dev Handle to MLX90393 device
+ * @param data Response bytes (status first)
+ * @param len Number of bytes to read
+ * @return int32_t Error code
+ */
+int32_t MLX90393_LogReplayRead(mlx_i2c_t *dev, uint8_t *data, size_t len){
+    if (dev == NULL || dev->handle == NULL || data == NULL){
+        return 1;
+    }
+    mlx_log_replay_t *replay = dev->handle;
+    for (size_t i = 0; i < len; i++){
+        data[i] = i < replay->response_len ? replay->response[i] : 0;
+    }
+    return 0;
+}
@@ -0,0 +1,272 @@
+#include "MLX90393.h"
+#include "MLX90393_sched.h"
+
+/**
+ * @brief Initialise an empty bus scheduler
+ * 
+ * @param sched Scheduler structure
+ * @param clock_us Monotonic clock [us], also given to the devices that lack their own
+ * @param udelay Microsecond delay used to wait for the conversions
+ * @param on_sample [Optional] Called with every collected sample
+ * @param ctx [Optional] User context passed to on_sample
+ * @return int32_t Error code
+ */
+int32_t MLX90393_SchedInit(mlx_sched_t *sched, mlx_clock_ptr clock_us, mlx_udelay_ptr udelay, mlx_sched_cb on_sample, void *ctx){
+    if(sched == NULL || clock_us == NULL || udelay == NULL){
+        return 1;
+    }
+    sched->count = 0;
+    sched->first = 0;
+    sched->clock_us = clock_us;
+    sched->udelay = udelay;
+    sched->on_sample = on_sample;
+    sched->ctx = ctx;
+    return 0;
+}
+
+/**
+ * @brief Add an initialised device to the scheduler
+ * 
+ * @param sched Scheduler structure
+ * @param dev Handle to MLX90393 device (distinct address on the same bus)
+ * @param period_us Target sampling period [us] (0 = as fast as possible)
+ * @return int32_t Error code (MLX90393_AGAIN if the scheduler is full)
+ */
+int32_t MLX90393_SchedAdd(mlx_sched_t *sched, mlx_i2c_t *dev, uint32_t period_us){
+    if(sched == NULL || dev == NULL || dev->settings == NULL){
+        return 1;
+    }
+    if(sched->count >= MLX90393_SCHED_MAX_DEVICES){
+        return MLX90393_AGAIN;
+    }
+    if(dev->clock_us == NULL){
+        dev->clock_us = sched->clock_us;
+    }
+
+    mlx_sched_slot_t *slot = &sched->slots[sched->count++];
+    slot->dev = dev;
+    slot->period_us = period_us;
+    slot->next_due_us = 0;
+    slot->samples = 0;
+    slot->errors = 0;
+    return 0;
+}
+
+/**
+ * @brief Run one scheduling round: start every due device back to back, then collect
+ * the results in deadline order. N devices cost about one Tconv plus N short reads.
+ * 
+ * @param sched Scheduler structure
+ * @param collected [Optional] Number of samples delivered in this round
+ * @return int32_t Error code (MLX90393_AGAIN if no device was due)
+ */
+int32_t MLX90393_SchedRound(mlx_sched_t *sched, uint32_t *collected){
+    if(sched == NULL || sched->count == 0){
+        return 1;
+    }
+
+    uint32_t started = 0;
+    uint32_t done = 0;
+    uint8_t retries[MLX90393_SCHED_MAX_DEVICES] = {0};
+    uint64_t now = sched->clock_us();
+
+    //Start phase: SM to all due devices, rotating who goes first
+    for(size_t n = 0; n < sched->count; n++){
+        mlx_sched_slot_t *slot = &sched->slots[(sched->first + n) % sched->count];
+        if(now < slot->next_due_us || slot->dev->pending){
+            continue;
+        }
+        if(MLX90393_StartXYZ(slot->dev, NULL) != 0){
+            slot->errors++;
+            continue;
+        }
+        started++;
+        slot->next_due_us += slot->period_us;
+        if(slot->next_due_us < now){ //Fell behind: don't burst to catch up
+            slot->next_due_us = now + slot->period_us;
+        }
+    }
+    sched->first = (sched->first + 1) % sched->count;
+
+    //Complete phase: RM in deadline order
+    while(started > 0){
+        mlx_sched_slot_t *next = NULL;
+        size_t idx = 0;
+        for(size_t i = 0; i < sched->count; i++){
+            mlx_sched_slot_t *slot = &sched->slots[i];
+            if(slot->dev->pending && (next == NULL || slot->dev->deadline_us < next->dev->deadline_us)){
+                next = slot;
+                idx = i;
+            }
+        }
+        if(next == NULL){
+            break;
+        }
+
+        now = sched->clock_us();
+        if(now < next->dev->deadline_us){
+            sched->udelay((uint32_t) (next->dev->deadline_us - now));
+        }
+
+        float xyz[3];
+        int32_t ret = MLX90393_CompleteXYZ(next->dev, xyz);
+        if(ret == MLX90393_AGAIN){
+            //The delay came back early or the data is late: poll over about one more Tconv, then give up
+            if(sched->clock_us() < next->dev->deadline_us){
+                continue;
+            }
+            if(++retries[idx] <= MLX90393_SCHED_MAX_RETRIES){
+                sched->udelay(MLX90393_GetTconv_us(next->dev) / MLX90393_SCHED_MAX_RETRIES + 1);
+                continue;
+            }
+        }
+        started--;
+        if(ret != 0){
+            MLX90393_CancelXYZ(next->dev); //Drop it, it will be started again next round
+            next->errors++;
+            continue;
+        }
+        next->samples++;
+        done++;
+        if(sched->on_sample != NULL){
+            sched->on_sample(sched->ctx, idx, xyz);
+        }
+    }
+
+    if(collected != NULL){
+        *collected = done;
+    }
+    return done > 0 ? 0 : MLX90393_AGAIN;
+}
+
+/**
+ * @brief Run a number of scheduling rounds, sleeping until the next due device in between
+ * 
+ * @param sched Scheduler structure
+ * @param rounds Number of rounds to run
+ * @return int32_t Error code
+ */
+int32_t MLX90393_SchedRun(mlx_sched_t *sched, uint32_t rounds){
+    if(sched == NULL || sched->count == 0){
+        return 1;
+    }
+
+    for(uint32_t r = 0; r < rounds; r++){
+        int32_t ret = MLX90393_SchedRound(sched, NULL);
+        if(ret != 0 && ret != MLX90393_AGAIN){
+            return ret;
+        }
+
+        uint64_t next_due = MLX90393_SchedNextDue(sched);
+        uint64_t now = sched->clock_us();
+        if(now < next_due){
+            sched->udelay((uint32_t) (next_due - now));
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Time the next device is due
+ * 
+ * @param sched Scheduler structure
+ * @return uint64_t Earliest next_due_us of the devices [us] (0 without devices)
+ */
+uint64_t MLX90393_SchedNextDue(const mlx_sched_t *sched){
+    if(sched == NULL || sched->count == 0){
+        return 0;
+    }
+    uint64_t next_due = sched->slots[0].next_due_us;
+    for(size_t i = 1; i < sched->count; i++){
+        if(sched->slots[i].next_due_us < next_due){
+            next_due = sched->slots[i].next_due_us;
+        }
+    }
+    return next_due;
+}
+
+/**
+ * @brief Measure every device at (nearly) the same instant: SM to all devices back to back,
+ * a single wait for the slowest conversion, then RM from all in the same order.
+ * 
+ * The MLX90393 has no general-call trigger, so the devices are started one write apart;
+ * the spread is reported in snap->skew_us. Rate targets are ignored and on_sample is not called.
+ * 
+ * @param sched Scheduler structure
+ * @param snap Where to store the frame
+ * @return int32_t Error code (MLX90393_AGAIN if a device is busy or did not deliver, see snap->valid)
+ */
+int32_t MLX90393_SchedSnapshot(mlx_sched_t *sched, mlx_snapshot_t *snap){
+    if(sched == NULL || snap == NULL || sched->count == 0){
+        return 1;
+    }
+    for(size_t i = 0; i < sched->count; i++){
+        if(sched->slots[i].dev->pending){
+            return MLX90393_AGAIN;
+        }
+    }
+
+    uint64_t first = 0;
+    uint64_t last = 0;
+    uint64_t latest = 0;
+    uint32_t started = 0;
+    snap->valid = 0;
+
+    //Trigger phase: nothing else on the bus in between
+    for(size_t i = 0; i < sched->count; i++){
+        mlx_i2c_t *dev = sched->slots[i].dev;
+        if(MLX90393_StartXYZ(dev, NULL) != 0){
+            sched->slots[i].errors++;
+            continue;
+        }
+        uint64_t trigger = dev->deadline_us - MLX90393_GetTconv_us(dev);
+        if(started == 0){
+            first = trigger;
+        }
+        last = trigger;
+        if(dev->deadline_us > latest){
+            latest = dev->deadline_us;
+        }
+        started |= 1u << i;
+    }
+    snap->t_trigger_us = first;
+    snap->skew_us = (uint32_t) (last - first);
+    if(started == 0){
+        return MLX90393_AGAIN;
+    }
+
+    uint64_t now = sched->clock_us();
+    if(now < latest){
+        sched->udelay((uint32_t) (latest - now));
+    }
+
+    //Read phase: same order, so every device spends about the same time between SM and RM
+    for(size_t i = 0; i < sched->count; i++){
+        if(!(started & (1u << i))){
+            continue;
+        }
+        mlx_sched_slot_t *slot = &sched->slots[i];
+        mlx_sample_t *sample = &snap->samples[i];
+        int32_t ret = MLX90393_CompleteXYZ(slot->dev, sample->xyz);
+        if(ret == MLX90393_AGAIN){ //The delay came back early, or the data was not ready yet
+            now = sched->clock_us();
+            if(now < slot->dev->deadline_us){
+                sched->udelay((uint32_t) (slot->dev->deadline_us - now));
+            }
+            ret = MLX90393_CompleteXYZ(slot->dev, sample->xyz);
+        }
+        if(ret != 0){
+            slot->dev->pending = 0;
+            slot->errors++;
+            continue;
+        }
+        sample->t = 0;
+        sample->zyxt = MLX90393_MAG_XYZ;
+        sample->status = 0;
+        MLX90393_StampSample(slot->dev, sample, slot->dev->deadline_us - MLX90393_GetTconv_us(slot->dev), slot->dev->deadline_us);
+        slot->samples++;
+        snap->valid |= 1u << i;
+    }
+
+    return snap->valid == (1u << sched->count) - 1 ? 0 : MLX90393_AGAIN;
+}
@@ -0,0 +1,454 @@
+#include <math.h>
+#include <string.h>
+#include "MLX90393.h"
+#include "MLX90393_lut.h"
+#include "MLX90393_sim.h"
+
+//Virtual time: thread-local so that every thread (e.g. one per simulated bus) owns a timeline
+static _Thread_local uint64_t mlx_sim_now_us;
+
+/** Helper functions**/
+/**
+ * @brief Gaussian random number (xorshift32 + Box-Muller)
+ * 
+ * @param sim Simulated device (owns the generator state)
+ * @return float Sample of N(0, 1)
+ */
+static float MLX90393_SimGauss(mlx_sim_t *sim){
+    float u[2];
+    for (int i = 0; i < 2; i++){
+        uint32_t x = sim->seed;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        sim->seed = x;
+        u[i] = ((float) (x >> 8) + 1.0f) / 16777217.0f; //(0, 1]
+    }
+    return sqrtf(-2.0f * logf(u[0])) * cosf(6.2831853f * u[1]);
+}
+
+/**
+ * @brief Conversion time of the requested channels programmed in CONF3 (same model as the driver)
+ * 
+ * @param sim Simulated device
+ * @param zyxt Channels being converted
+ * @return uint32_t Tconv [us]
+ */
+static uint32_t MLX90393_SimTconv_us(const mlx_sim_t *sim, char zyxt){
+    uint16_t conf3 = sim->regs[MLX90393_REG_CONF3];
+    return MLX90393_TconvChannels_us((conf3 >> 2) & 0x07, conf3 & 0x03, (conf3 >> 11) & 0x03, (uint8_t) zyxt);
+}
+
+/**
+ * @brief Take a measurement of every channel at a given virtual time and latch it
+ * 
+ * @param sim Simulated device
+ * @param t_us Virtual time of the conversion
+ */
+static void MLX90393_SimConvert(mlx_sim_t *sim, uint64_t t_us){
+    uint16_t conf1 = sim->regs[MLX90393_REG_CONF1];
+    uint16_t conf2 = sim->regs[MLX90393_REG_CONF2];
+    uint16_t conf3 = sim->regs[MLX90393_REG_CONF3];
+    uint8_t gain = (conf1 >> 4) & 0x07;
+    uint8_t tcmp_en = (conf2 >> 10) & 0x01;
+    float t_s = (float) t_us * 1e-6f;
+
+    for (int axis = 0; axis < 3; axis++){
+        uint8_t res = (conf3 >> (5 + 2 * axis)) & 0x03;
+        float b = sim->field[axis] + sim->sine_amp[axis] * sinf(6.2831853f * sim->sine_hz * t_s);
+        if (sim->waveform != NULL){
+            b += sim->waveform(sim->ctx, axis, t_us);
+        }
+        if (sim->noise_uT > 0.0f){
+            b += sim->noise_uT * MLX90393_SimGauss(sim);
+        }
+        //Zero field code and output range of the resolution (see MLX90393_ZeroOffset)
+        int32_t zero = 0, lo = -32768, hi = 32767;
+        if (res == MLX90393_RES_19){
+            zero = 0x4000; lo = 0; hi = 0x7FFF;
+        } else if (res == MLX90393_RES_18 || tcmp_en){
+            zero = 0x8000; lo = 0; hi = 0xFFFF;
+        }
+        int32_t raw = (int32_t) lroundf(b / MLX90393_Sensitivity_LookUp[gain][res][axis == 2]) + zero;
+        if (tcmp_en){
+            raw -= (int16_t) sim->regs[MLX90393_REG_OFFSET_X + axis]; //Offset correction only runs with TCMP_EN
+        }
+        raw = raw < lo ? lo : (raw > hi ? hi : raw);
+        sim->result[1 + axis] = (uint16_t) raw;
+    }
+    int32_t t_raw = (int32_t) lroundf(MLX90393_TREF_LSB + (sim->temp_degc - MLX90393_TREF_DEGC) * MLX90393_TSENS_LSB);
+    sim->result[0] = (uint16_t) (t_raw < 0 ? 0 : (t_raw > 0xFFFF ? 0xFFFF : t_raw));
+}
+
+/**
+ * @brief Wake-up-on-change comparison of the latched measurement against the reference
+ * 
+ * @param sim Simulated device
+ * @return uint8_t 1 if a channel moved by more than its threshold
+ */
+static uint8_t MLX90393_SimWocTriggered(const mlx_sim_t *sim){
+    const uint16_t thresholds[4] = {
+        sim->regs[MLX90393_REG_WOT_THRESHOLD],
+        sim->regs[MLX90393_REG_WOXY_THRESHOLD],
+        sim->regs[MLX90393_REG_WOXY_THRESHOLD],
+        sim->regs[MLX90393_REG_WOZ_THRESHOLD]
+    };
+    for (int ch = 0; ch < 4; ch++){
+        if (!(sim->zyxt & (1 << ch))){
+            continue;
+        }
+        int32_t diff = (int32_t) sim->result[ch] - (int32_t) sim->woc_ref[ch];
+        if ((uint32_t) (diff < 0 ? -diff : diff) > thresholds[ch]){
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Bring the measurement state up to the current virtual time
+ * 
+ * Burst / WOC conversions that happened since the last call are not replayed one by one:
+ * only the most recent one is taken (WOC compares it alone against the reference).
+ * 
+ * @param sim Simulated device
+ */
+static void MLX90393_SimAdvance(mlx_sim_t *sim){
+    if (sim->mode == 0 || mlx_sim_now_us < sim->ready_us){
+        return;
+    }
+    if (sim->mode == MLX90393_STATUS_SM){
+        if (!sim->data_ready){
+            MLX90393_SimConvert(sim, sim->ready_us);
+            sim->data_ready = 1;
+        }
+        return;
+    }
+    uint64_t periods = (mlx_sim_now_us - sim->ready_us) / sim->period_us;
+    uint64_t t_us = sim->ready_us + periods * sim->period_us;
+    sim->ready_us = t_us + sim->period_us;
+    MLX90393_SimConvert(sim, t_us);
+    if (sim->mode == MLX90393_STATUS_BURST){
+        sim->data_ready = 1;
+    } else if (MLX90393_SimWocTriggered(sim)){
+        sim->data_ready = 1;
+        if (!((sim->regs[MLX90393_REG_CONF2] >> 12) & 0x01)){ //WOC_DIFF = 0: compare against the first measurement
+            return;
+        }
+        memcpy(sim->woc_ref, sim->result, sizeof(sim->woc_ref));
+    } else if ((sim->regs[MLX90393_REG_CONF2] >> 12) & 0x01){ //WOC_DIFF = 1: compare against the previous measurement
+        memcpy(sim->woc_ref, sim->result, sizeof(sim->woc_ref));
+    }
+}
+
+/**
+ * @brief Start a measurement mode (SB / SWOC / SM)
+ * 
+ * @param sim Simulated device
+ * @param mode MLX90393_STATUS_BURST, MLX90393_STATUS_WOC or MLX90393_STATUS_SM
+ * @param zyxt Channels requested by the command (0 = BURST_SEL of CONF2 for SB / SWOC)
+ * @return uint8_t 1 if the command is rejected
+ */
+static uint8_t MLX90393_SimStart(mlx_sim_t *sim, uint8_t mode, char zyxt){
+    if (sim->mode != 0){
+        return 1;
+    }
+    if (zyxt == 0 && mode != MLX90393_STATUS_SM){
+        zyxt = (char) ((sim->regs[MLX90393_REG_CONF2] >> 6) & 0x0F);
+    }
+    uint32_t tconv = MLX90393_SimTconv_us(sim, zyxt);
+    uint32_t interval = (uint32_t) (sim->regs[MLX90393_REG_CONF2] & 0x3F) * 20000;
+    sim->mode = mode;
+    sim->zyxt = zyxt;
+    sim->data_ready = 0;
+    sim->period_us = interval > tconv ? interval : tconv;
+    sim->ready_us = mlx_sim_now_us + tconv;
+    if (mode == MLX90393_STATUS_WOC){ //Reference measurement
+        MLX90393_SimConvert(sim, mlx_sim_now_us);
+        memcpy(sim->woc_ref, sim->result, sizeof(sim->woc_ref));
+    }
+    return 0;
+}
+
+/**
+ * @brief Decode and execute one command, preparing the response for the next read
+ * 
+ * @param sim Simulated device
+ * @param buf Command bytes
+ * @param len Number of command bytes
+ */
+static void MLX90393_SimExecute(mlx_sim_t *sim, const uint8_t *buf, size_t len){
+    uint8_t cmd = buf[0] & 0xF0;
+    char zyxt = (char) (buf[0] & 0x0F);
+    uint8_t error = 0;
+    uint8_t d = 0;
+    uint8_t was_reset = sim->reset;
+    sim->reset = 0;
+    sim->response_len = 1;
+
+    MLX90393_SimAdvance(sim);
+    if (sim->mode != 0 && sim->mode != MLX90393_STATUS_SM && cmd != 0x40 && cmd != 0x80 && cmd != 0xF0 && cmd != 0x00){
+        cmd = 0xFF; //Only RM, EX, RT and NOP are accepted in burst and WOC modes
+    }
+
+    switch (cmd){
+        case 0x00: //NOP
+            break;
+        case 0x10: //SB
+            error = MLX90393_SimStart(sim, MLX90393_STATUS_BURST, zyxt);
+            break;
+        case 0x20: //SWOC
+            error = MLX90393_SimStart(sim, MLX90393_STATUS_WOC, zyxt);
+            break;
+        case 0x30: //SM
+            error = MLX90393_SimStart(sim, MLX90393_STATUS_SM, zyxt);
+            break;
+        case 0x40: //RM
+            if (!sim->data_ready){
+                error = 1; //Nothing converted yet, stale data
+            }
+            for (int ch = 0; ch < 4; ch++){
+                if (zyxt & (1 << ch)){
+                    sim->response[sim->response_len++] = sim->result[ch] >> 8;
+                    sim->response[sim->response_len++] = sim->result[ch] & 0xFF;
+                }
+            }
+            d = sim->response_len > 1 ? (uint8_t) ((sim->response_len - 3) / 2) : 0;
+            if (!error){
+                sim->data_ready = 0;
+                if (sim->mode == MLX90393_STATUS_SM){
+                    sim->mode = 0;
+                }
+            }
+            break;
+        case 0x50: //RR
+            if (len < 2 || (buf[1] >> 2) >= MLX90393_SIM_NUM_REGS){
+                error = 1;
+                sim->response[1] = sim->response[2] = 0;
+            } else {
+                sim->response[1] = sim->regs[buf[1] >> 2] >> 8;
+                sim->response[2] = sim->regs[buf[1] >> 2] & 0xFF;
+            }
+            sim->response_len = 3;
+            break;
+        case 0x60: //WR
+            if (len < 4 || (buf[3] >> 2) >= MLX90393_SIM_NUM_REGS){
+                error = 1;
+            } else {
+                sim->regs[buf[3] >> 2] = (uint16_t) (buf[1] << 8 | buf[2]);
+            }
+            break;
+        case 0x80: //EX
+            sim->mode = 0;
+            sim->data_ready = 0;
+            break;
+        case 0xD0: //HR
+            memcpy(sim->regs, sim->nvram, sizeof(sim->regs));
+            break;
+        case 0xE0: //HS
+            memcpy(sim->nvram, sim->regs, sizeof(sim->nvram));
+            break;
+        case 0xF0: //RT
+            memcpy(sim->regs, sim->nvram, sizeof(sim->regs));
+            sim->mode = 0;
+            sim->data_ready = 0;
+            was_reset = 1;
+            sim->reset = 1;
+            break;
+        default:
+            error = 1;
+            break;
+    }
+
+    uint8_t status = sim->mode | d;
+    if (error){
+        status |= MLX90393_STATUS_ERROR;
+    }
+    if (was_reset){
+        status |= MLX90393_STATUS_RS;
+    }
+    if (sim->sed_next > 0){
+        sim->sed_next--;
+        status |= MLX90393_STATUS_SED;
+    }
+    sim->response[0] = status;
+}
+
+// SETUP
+/**
+ * @brief Power up a simulated device: default non-volatile memory, no field, 25 degC, RS pending
+ * 
+ * @param sim Simulated device
+ * @return int32_t Error code
+ */
+int32_t MLX90393_SimInit(mlx_sim_t *sim){
+    if (sim == NULL){
+        return 1;
+    }
+    memset(sim, 0, sizeof(mlx_sim_t));
+    sim->nvram[MLX90393_REG_CONF1] = 0x007C; //GAIN_SEL = 7, HALLCONF = 0xC
+    memcpy(sim->regs, sim->nvram, sizeof(sim->regs));
+    sim->temp_degc = 25.0f;
+    sim->seed = 0x2545F491;
+    sim->reset = 1;
+    return 0;
+}
+
+/**
+ * @brief Connect a device to a simulated sensor: transport, delay and clock hooks all use the simulation
+ * 
+ * @param dev Handle to MLX90393 device
+ * @param sim Simulated device, must outlive dev
+ * @return int32_t Error code
+ */
+int32_t MLX90393_SimAttach(mlx_i2c_t *dev, mlx_sim_t *sim){
+    if (dev == NULL || sim == NULL){
+        return 1;
+    }
+    dev->handle = sim;
+    dev->write_function = MLX90393_SimWrite;
+    dev->read_function = MLX90393_SimRead;
+    dev->mdelay = MLX90393_SimMdelay;
+    dev->udelay = MLX90393_SimUdelay;
+    dev->clock_us = MLX90393_SimClock;
+    return 0;
+}
+
+/**
+ * @brief Fault injection: reset the device behind the driver's back (e.g. a supply brown-out)
+ * 
+ * @param sim Simulated device
+ */
+void MLX90393_SimGlitch(mlx_sim_t *sim){
+    if (sim == NULL){
+        return;
+    }
+    memcpy(sim->regs, sim->nvram, sizeof(sim->regs));
+    sim->mode = 0;
+    sim->data_ready = 0;
+    sim->reset = 1;
+}
+
+// VIRTUAL TIME
+/**
+ * @brief mlx_clock_ptr hook: current virtual time
+ * 
+ * @return uint64_t Virtual time [us]
+ */
+uint64_t MLX90393_SimClock(void){
+    return mlx_sim_now_us;
+}
+
+/**
+ * @brief Set the virtual time of the calling thread
+ * 
+ * @param t_us New virtual time [us]
+ */
+void MLX90393_SimSetClock(uint64_t t_us){
+    mlx_sim_now_us = t_us;
+}
+
+/**
+ * @brief mlx_udelay_ptr hook: advance the virtual time
+ * 
+ * @param us Delay [us]
+ */
+void MLX90393_SimUdelay(uint32_t us){
+    mlx_sim_now_us += us;
+}
+
+/**
+ * @brief mlx_mdelay_ptr hook: advance the virtual time
+ * 
+ * @param ms Delay [ms]
+ */
+void MLX90393_SimMdelay(uint32_t ms){
+    mlx_sim_now_us += (uint64_t) ms * 1000;
+}
+
+// TRANSPORT HOOKS
+/**
+ * @brief mlx_wr_ptr hook: the command is executed when it is written
+ * 
+ * @param dev Handle to MLX90393 device (handle must be a mlx_sim_t)
+ * @param buf Command bytes
+ * @param len Number of command bytes
+ * @return int32_t Error code (1 if a NACK was injected)
+ */
+int32_t MLX90393_SimWrite(mlx_i2c_t *dev, uint8_t *buf, size_t len){
+    if (dev == NULL || dev->handle == NULL || buf == NULL || len == 0){
+        return 1;
+    }
+    mlx_sim_t *sim = (mlx_sim_t *) dev->handle;
+    sim->transactions++;
+    mlx_sim_now_us += (len + 1) * sim->byte_us;
+    if (sim->nack_next > 0){
+        sim->nack_next--;
+        return 1;
+    }
+    sim->bytes_written += len;
+    MLX90393_SimExecute(sim, buf, len);
+    return 0;
+}
+
+/**
+ * @brief mlx_rd_ptr hook: return the response of the last command (zero padded)
+ * 
+ * @param dev Handle to MLX90393 device (handle must be a mlx_sim_t)
+ * @param data Buffer for the response
+ * @param len Number of bytes to read
+ * @return int32_t Error code (1 if a NACK was injected)
+ */
+int32_t MLX90393_SimRead(mlx_i2c_t *dev, uint8_t *data, size_t len){
+    if (dev == NULL || dev->handle == NULL || data == NULL){
+        return 1;
+    }
+    mlx_sim_t *sim = (mlx_sim_t *) dev->handle;
+    sim->transactions++;
+    mlx_sim_now_us += (len + 1) * sim->byte_us;
+    if (sim->nack_next > 0){
+        sim->nack_next--;
+        return 1;
+    }
+    sim->bytes_read += len;
+    for (size_t i = 0; i < len; i++){
+        data[i] = i < sim->response_len ? sim->response[i] : 0;
+    }
+    return 0;
+}
+
+/**
+ * @brief mlx_xfer_ptr hook: command and response as one repeated-start transaction
+ * 
+ * @param dev Handle to MLX90393 device (handle must be a mlx_sim_t)
+ * @param wbuf Command bytes
+ * @param wlen Number of command bytes
+ * @param rbuf Buffer for the response
+ * @param rlen Number of bytes to read
+ * @return int32_t Error code (1 if a NACK was injected)
+ */
+int32_t MLX90393_SimTransfer(mlx_i2c_t *dev, uint8_t *wbuf, size_t wlen, uint8_t *rbuf, size_t rlen){
+    int32_t ret = MLX90393_SimWrite(dev, wbuf, wlen);
+    if (ret != 0){
+        return ret;
+    }
+    mlx_sim_t *sim = (mlx_sim_t *) dev->handle;
+    sim->transactions--; //Same transaction, no second address byte
+    mlx_sim_now_us -= sim->byte_us;
+    return MLX90393_SimRead(dev, rbuf, rlen);
+}
+
+/**
+ * @brief Level of the INT / DRDY pin (usable as the WOC drdy hook)
+ * 
+ * @param dev Handle to MLX90393 device (handle must be a mlx_sim_t)
+ * @return int32_t 1 when a measurement is ready to be read
+ */
+int32_t MLX90393_SimDataReady(mlx_i2c_t *dev){
+    if (dev == NULL || dev->handle == NULL){
+        return 0;
+    }
+    mlx_sim_t *sim = (mlx_sim_t *) dev->handle;
+    MLX90393_SimAdvance(sim);
+    return sim->data_ready;
+}
@@ -0,0 +1,247 @@
+#include "MLX90393.h"
+#include "MLX90393_cmds.h"
+#include "MLX90393_stream.h"
+
+//RING BUFFER
+/**
+ * @brief Initialise a SPSC ring buffer over caller-provided storage
+ * 
+ * @param ring Ring buffer to initialise
+ * @param buffer Storage for the samples
+ * @param capacity Number of samples in buffer (must be a power of 2)
+ * @return int32_t Error code
+ */
+int32_t MLX90393_RingInit(mlx_ring_t *ring, mlx_sample_t *buffer, size_t capacity){
+    if(ring == NULL || buffer == NULL || capacity == 0 || (capacity & (capacity - 1)) != 0){
+        return 1;
+    }
+    ring->buffer = buffer;
+    ring->mask = capacity - 1;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    return 0;
+}
+
+/**
+ * @brief Push a sample into the ring (producer side only)
+ * 
+ * @param ring Ring buffer
+ * @param sample Sample to copy into the ring
+ * @return int32_t Error code (MLX90393_AGAIN if the ring is full)
+ */
+int32_t MLX90393_RingPush(mlx_ring_t *ring, const mlx_sample_t *sample){
+    if(ring == NULL || sample == NULL){
+        return 1;
+    }
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if(head - tail > ring->mask){
+        return MLX90393_AGAIN;
+    }
+    ring->buffer[head & ring->mask] = *sample;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release); //Publish the slot to the consumer
+    return 0;
+}
+
+/**
+ * @brief Pop the oldest sample from the ring (consumer side only)
+ * 
+ * @param ring Ring buffer
+ * @param sample Where to copy the sample
+ * @return int32_t Error code (MLX90393_AGAIN if the ring is empty)
+ */
+int32_t MLX90393_RingPop(mlx_ring_t *ring, mlx_sample_t *sample){
+    if(ring == NULL || sample == NULL){
+        return 1;
+    }
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if(head == tail){
+        return MLX90393_AGAIN;
+    }
+    *sample = ring->buffer[tail & ring->mask];
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release); //Hand the slot back to the producer
+    return 0;
+}
+
+/**
+ * @brief Number of samples waiting in the ring
+ * 
+ * @param ring Ring buffer
+ * @return size_t Sample count
+ */
+size_t MLX90393_RingCount(mlx_ring_t *ring){
+    if(ring == NULL){
+        return 0;
+    }
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    return head - tail;
+}
+
+//STREAMING
+/**
+ * @brief Bind a device and a ring buffer into a stream
+ * 
+ * @param stream Stream structure to initialise
+ * @param dev Handle to an initialised MLX90393 device
+ * @param ring Ring buffer the samples are pushed into
+ * @return int32_t Error code
+ */
+int32_t MLX90393_StreamInit(mlx_stream_t *stream, mlx_i2c_t *dev, mlx_ring_t *ring){
+    if(stream == NULL || dev == NULL || ring == NULL){
+        return 1;
+    }
+    stream->dev = dev;
+    stream->ring = ring;
+    stream->zyxt = MLX90393_MAG_XYZ;
+    atomic_init(&stream->running, 0);
+    stream->dropped = 0;
+    return 0;
+}
+
+/**
+ * @brief Put the sensor in burst mode. From here on the samples are collected with RM only
+ * 
+ * @param stream Stream handle
+ * @return int32_t Error code (MLX90393_MISMATCH if the device rejected SB)
+ */
+int32_t MLX90393_StreamStart(mlx_stream_t *stream){
+    if(stream == NULL || stream->dev == NULL || stream->dev->settings == NULL){
+        return 1;
+    }
+    uint8_t status;
+    int32_t ret = MLX90393_SB(stream->dev, stream->zyxt, &status);
+    if(ret != 0){
+        return ret;
+    }
+    if(status & MLX90393_STATUS_ERROR){
+        return MLX90393_MISMATCH; //Not in burst mode, e.g. still in WOC mode
+    }
+    atomic_store_explicit(&stream->running, 1, memory_order_release);
+    return 0;
+}
+
+/**
+ * @brief Read the latest burst measurement and push it into the ring (producer side)
+ * 
+ * @param stream Stream handle
+ * @return int32_t Error code (MLX90393_AGAIN if there is no new data or the sample was dropped because the ring is full)
+ */
+int32_t MLX90393_StreamPoll(mlx_stream_t *stream){
+    if(stream == NULL || stream->dev == NULL || stream->dev->settings == NULL ||
+       !atomic_load_explicit(&stream->running, memory_order_acquire)){
+        return 1;
+    }
+
+    int32_t ret;
+    uint8_t data[8];
+    mlx_sample_t sample = {0}; //t stays 0 without a T channel
+
+    uint64_t t_issue = stream->dev->clock_us != NULL ? stream->dev->clock_us() : 0;
+    ret = MLX90393_RM(stream->dev, stream->zyxt, &sample.status, data);
+    if(ret != 0){
+        return ret;
+    }
+    if(sample.status & MLX90393_STATUS_ERROR){
+        return MLX90393_AGAIN; //No new conversion since the last read
+    }
+    MLX90393_convert(stream->dev->settings, MLX90393_TcmpEnabled(stream->dev), stream->zyxt, data, &sample);
+    MLX90393_StampSample(stream->dev, &sample, t_issue, t_issue); //Burst / WOC data is already converted
+
+    ret = MLX90393_RingPush(stream->ring, &sample);
+    if(ret != 0){
+        stream->dropped++;
+    }
+    return ret;
+}
+
+/**
+ * @brief Producer loop: collect a number of samples at the burst cadence
+ * 
+ * The period is BURST_DATA_RATE x 20 ms from the CONF2 shadow, or the Tconv of the streamed channels
+ * when the sensor converts back to back (BURST_DATA_RATE = 0), waited with udelay when available.
+ * Only samples pushed into the ring count. When MLX90393_StreamStop clears the running flag,
+ * the loop leaves burst mode itself (MLX90393_StreamFinish) so EX is sent from this thread.
+ * 
+ * @param stream Stream handle (must be started)
+ * @param samples Number of samples to push (0 = run until MLX90393_StreamStop)
+ * @return int32_t Error code (MLX90393_TIMEOUT after MLX90393_STREAM_MAX_MISSES periods without new data)
+ */
+int32_t MLX90393_StreamRun(mlx_stream_t *stream, uint32_t samples){
+    if(stream == NULL || stream->dev == NULL || (stream->dev->mdelay == NULL && stream->dev->udelay == NULL)){
+        return 1;
+    }
+    mlx_i2c_t *dev = stream->dev;
+
+    uint32_t period_us = MLX90393_GetTconvZyxt_us(dev, stream->zyxt);
+    if(dev->regs_valid & (1 << MLX90393_REG_CONF2)){
+        uint32_t interval_us = (uint32_t) (dev->regs[MLX90393_REG_CONF2] & 0x3F) * 20000;
+        if(interval_us > period_us) period_us = interval_us;
+    }
+
+    uint32_t pushed = 0;
+    uint32_t misses = 0;
+    while(samples == 0 || pushed < samples){
+        if(!atomic_load_explicit(&stream->running, memory_order_acquire)){
+            return MLX90393_StreamFinish(stream);
+        }
+        if(dev->udelay != NULL){
+            dev->udelay(period_us);
+        }else{
+            dev->mdelay((period_us + 999) / 1000);
+        }
+        uint32_t dropped = stream->dropped;
+        int32_t ret = MLX90393_StreamPoll(stream);
+        if(ret == 0){
+            pushed++;
+            misses = 0;
+        }else if(ret == MLX90393_AGAIN && stream->dropped != dropped){
+            misses = 0; //The sensor delivered, the consumer is behind
+        }else if(ret == MLX90393_AGAIN){
+            if(++misses >= MLX90393_STREAM_MAX_MISSES){
+                return MLX90393_TIMEOUT;
+            }
+        }else if(ret == 1 && !atomic_load_explicit(&stream->running, memory_order_acquire)){
+            return MLX90393_StreamFinish(stream); //Stopped between the check and the poll
+        }else{
+            return ret;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Ask the producer to stop streaming. Safe to call from any thread: it only clears the
+ * running flag, and MLX90393_StreamRun sends EX on its way out. Without StreamRun, call
+ * MLX90393_StreamFinish from the thread that polls.
+ * 
+ * @param stream Stream handle
+ * @return int32_t Error code
+ */
+int32_t MLX90393_StreamStop(mlx_stream_t *stream){
+    if(stream == NULL){
+        return 1;
+    }
+    atomic_store_explicit(&stream->running, 0, memory_order_release);
+    return 0;
+}
+
+/**
+ * @brief Leave burst mode (producer side: must not race with MLX90393_StreamPoll)
+ * 
+ * @param stream Stream handle
+ * @return int32_t Error code (MLX90393_MISMATCH if the device rejected EX)
+ */
+int32_t MLX90393_StreamFinish(mlx_stream_t *stream){
+    if(stream == NULL || stream->dev == NULL){
+        return 1;
+    }
+    uint8_t status;
+    atomic_store_explicit(&stream->running, 0, memory_order_release);
+    int32_t ret = MLX90393_EX(stream->dev, &status);
+    if(ret == 0 && (status & MLX90393_STATUS_ERROR)){
+        return MLX90393_MISMATCH;
+    }
+    return ret;
+}
@@ -0,0 +1,159 @@
+#include "MLX90393.h"
+#include "MLX90393_cmds.h"
+#include "MLX90393_woc.h"
+
+/**
+ * @brief Initialise the Wake-On-Change state of a device
+ * 
+ * @param woc WOC structure
+ * @param dev Handle to an initialised MLX90393 device
+ * @param drdy [Optional] INT pin reader. Without it, events are only signalled through MLX90393_WOCNotify
+ * @param on_change Called with every field change event
+ * @param ctx [Optional] User context passed to on_change
+ * @return int32_t Error code
+ */
+int32_t MLX90393_WOCInit(mlx_woc_t *woc, mlx_i2c_t *dev, mlx_drdy_ptr drdy, mlx_woc_cb on_change, void *ctx){
+    if(woc == NULL || dev == NULL || on_change == NULL){
+        return 1;
+    }
+    woc->dev = dev;
+    woc->drdy = drdy;
+    woc->on_change = on_change;
+    woc->ctx = ctx;
+    atomic_init(&woc->irq, 0);
+    woc->armed = 0;
+    woc->events = 0;
+    return 0;
+}
+
+/**
+ * @brief Convert a threshold in uT to LSB of the given axis, saturating to the register range
+ * 
+ * @param cfg Current settings
+ * @param axis 0 = X, 1 = Y, 2 = Z
+ * @param threshold Threshold [uT]
+ * @return uint16_t Threshold [LSB]
+ */
+static uint16_t MLX90393_WOCThreshold(const mlx_cfg_t *cfg, int axis, float threshold){
+    float lsb = threshold / MLX90393_GetSensitivity(cfg, axis);
+    if(lsb < 0) lsb = -lsb;
+    if(lsb > 0xFFFF) lsb = 0xFFFF;
+    return (uint16_t) (lsb + 0.5f);
+}
+
+/**
+ * @brief Program the per-axis change thresholds and start Wake-On-Change on X, Y and Z
+ * 
+ * @param woc WOC structure
+ * @param xy_threshold Change that triggers an event on X or Y [uT]. X and Y share one LSB threshold: it is
+ * converted with the finer of the two resolutions, so neither axis wakes for a smaller change
+ * @param z_threshold Change that triggers an event on Z [uT]
+ * @param t_threshold Change that triggers an event on T [LSB]
+ * @param diff_mode 0: compare with the first measurement, 1: compare with the previous one
+ * @return int32_t Error code
+ */
+int32_t MLX90393_WOCArm(mlx_woc_t *woc, float xy_threshold, float z_threshold, uint16_t t_threshold, uint8_t diff_mode){
+    if(woc == NULL || woc->dev == NULL || woc->dev->settings == NULL){
+        return 1;
+    }
+
+    int32_t ret;
+    uint8_t status;
+    mlx_cfg_ext_t cfg;
+
+    if(MLX90393_GetConfig(woc->dev, &cfg) != 0){
+        ret = MLX90393_SyncRegisters(woc->dev);
+        if(ret != 0){
+            return ret;
+        }
+        MLX90393_GetConfig(woc->dev, &cfg);
+    }
+    cfg.base = *(woc->dev->settings);
+    int xy_axis = MLX90393_GetSensitivity(&cfg.base, 1) < MLX90393_GetSensitivity(&cfg.base, 0) ? 1 : 0;
+    cfg.woxy_threshold = MLX90393_WOCThreshold(&cfg.base, xy_axis, xy_threshold);
+    cfg.woz_threshold = MLX90393_WOCThreshold(&cfg.base, 2, z_threshold);
+    cfg.wot_threshold = t_threshold;
+    cfg.woc_diff = diff_mode;
+    cfg.burst_sel = MLX90393_MAG_XYZ;
+
+    ret = MLX90393_ApplyConfig(woc->dev, &cfg);
+    if(ret != 0){
+        return ret;
+    }
+
+    atomic_store(&woc->irq, 0);
+    ret = MLX90393_SWOC(woc->dev, MLX90393_MAG_XYZ, &status);
+    if(ret != 0){
+        return ret;
+    }
+    if(status & MLX90393_STATUS_ERROR){
+        return MLX90393_MISMATCH; //Not in WOC mode, e.g. still in burst mode
+    }
+    woc->armed = 1;
+    return 0;
+}
+
+/**
+ * @brief Signal a data ready interrupt. Safe to call from the INT pin ISR / GPIO callback
+ * 
+ * @param woc WOC structure
+ */
+void MLX90393_WOCNotify(mlx_woc_t *woc){
+    if(woc != NULL){
+        atomic_store(&woc->irq, 1);
+    }
+}
+
+/**
+ * @brief Deliver the pending field change event, if any. No bus traffic unless the sensor signalled a change
+ * 
+ * @param woc WOC structure
+ * @return int32_t Error code (MLX90393_AGAIN if there is no event or the sensor had no new data)
+ */
+int32_t MLX90393_WOCService(mlx_woc_t *woc){
+    if(woc == NULL || woc->dev == NULL || woc->dev->settings == NULL || !woc->armed){
+        return 1;
+    }
+
+    uint8_t triggered = atomic_exchange(&woc->irq, 0);
+    if(!triggered && (woc->drdy == NULL || woc->drdy(woc->dev) == 0)){
+        return MLX90393_AGAIN;
+    }
+
+    int32_t ret;
+    uint8_t data[8];
+    mlx_sample_t sample = {0};
+    uint64_t t_issue = woc->dev->clock_us != NULL ? woc->dev->clock_us() : 0;
+    ret = MLX90393_RM(woc->dev, MLX90393_MAG_XYZ, &sample.status, data);
+    if(ret != 0){
+        return ret;
+    }
+    if(sample.status & MLX90393_STATUS_ERROR){
+        return MLX90393_AGAIN; //Spurious or level-triggered notify: no new conversion
+    }
+    MLX90393_convert(woc->dev->settings, MLX90393_TcmpEnabled(woc->dev), MLX90393_MAG_XYZ, data, &sample);
+    MLX90393_StampSample(woc->dev, &sample, t_issue, t_issue); //Burst / WOC data is already converted
+
+    woc->events++;
+    woc->on_change(woc->ctx, &sample);
+    return 0;
+}
+
+/**
+ * @brief Leave Wake-On-Change mode
+ * 
+ * @param woc WOC structure
+ * @return int32_t Error code
+ */
+int32_t MLX90393_WOCDisarm(mlx_woc_t *woc){
+    if(woc == NULL || woc->dev == NULL){
+        return 1;
+    }
+    uint8_t status;
+    woc->armed = 0;
+    int32_t ret = MLX90393_EX(woc->dev, &status);
+    if(ret == 0 && (status & MLX90393_STATUS_ERROR)){
+        return MLX90393_MISMATCH;
+    }
+    return ret;
+}
@@ -5,7 +5,11 @@
 
 int32_t write_function(mlx_i2c_t *dev, uint8_t *buf, size_t len);
 int32_t read_function(mlx_i2c_t *dev, uint8_t *data, size_t len);
+int32_t transfer_function(mlx_i2c_t *dev, uint8_t *wbuf, size_t wlen, uint8_t *rbuf, size_t rlen);
 void delay_function(uint32_t ms);
+void udelay_function(uint32_t us);
+uint64_t clock_function(void);
+int32_t drdy_function(mlx_i2c_t *dev);
 
 int32_t GetSettings(mlx_i2c_t *dev); 
 int32_t ApplySettings(mlx_i2c_t *dev, mlx_cfg_t *settings);
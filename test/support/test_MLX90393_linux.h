@@ -0,0 +1,8 @@
+#ifndef _TEST_MLX90393_LINUX_H
+#define _TEST_MLX90393_LINUX_H
+
+int mlx_sys_open(const char *path, int flags);
+int mlx_sys_ioctl(int fd, unsigned long request, void *arg);
+int mlx_sys_close(int fd);
+
+#endif
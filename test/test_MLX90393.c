@@ -2,6 +2,8 @@
 #include <stdlib.h>
 #include "unity.h"
 #include "MLX90393.h"
+#include "MLX90393_cmds.h"
+#include "MLX90393_lut.h"
 #include "mock_test_MLX90393.h"
 //#include "mock_test_MLX90393_cmds.h"
 
@@ -21,6 +23,51 @@ static void cb_free(void *memory, int n){
     free(memory);
 }
 
+//Bus log of written command bytes
+static uint8_t written[16][4];
+static int write_count = 0;
+
+static int32_t cb_write_log(mlx_i2c_t *dev, uint8_t *buf, size_t len, int n){
+    memcpy(written[write_count++], buf, len > 4 ? 4 : len);
+    return 0;
+}
+
+//RR answers with the register address in the high byte and 0x5A in the low byte
+static int32_t cb_read_reg(mlx_i2c_t *dev, uint8_t *data, size_t len, int n){
+    data[0] = 0x00;
+    if (len == 3){
+        data[1] = written[write_count - 1][1] >> 2;
+        data[2] = 0x5A;
+    }
+    return 0;
+}
+
+//Every command succeeds with an all-zero response (status 0x00)
+static int32_t cb_read_ok(mlx_i2c_t *dev, uint8_t *data, size_t len, int n){
+    memset(data, 0, len);
+    return 0;
+}
+
+//Same as cb_read_ok for the combined write-read hook
+static int32_t cb_transfer_ok(mlx_i2c_t *dev, uint8_t *wbuf, size_t wlen, uint8_t *rbuf, size_t rlen, int n){
+    memset(rbuf, 0, rlen);
+    return 0;
+}
+
+//Let the mocked ApplySettings run the real one
+static int32_t cb_ApplySettings_real(mlx_i2c_t *dev, mlx_cfg_t *settings, int n){
+    return MLX90393_ApplySettings(dev, settings);
+}
+
+//RM reports ERROR (data not ready) on the first attempt only
+static int32_t cb_read_not_ready_once(mlx_i2c_t *dev, uint8_t *data, size_t len, int n){
+    memset(data, 0, len);
+    if (n == 1){ //Call 0 is the SM status byte
+        data[0] = 0x10;
+    }
+    return 0;
+}
+
 
 void setUp(void) { 
     //Get a full-function structure before for the tests that require the low-level functions to be called
@@ -30,12 +77,19 @@ void setUp(void) {
     fake_mlx.read_function = read_function;
     
     fake_mlx.mdelay = delay_function; 
+    fake_mlx.transfer = NULL;
+    fake_mlx.udelay = NULL;
+    fake_mlx.ready_retries = 0;
+    fake_mlx.clock_us = clock_function;
+    fake_mlx.pending = 0;
+    fake_mlx.regs_valid = 0;
 
 }
 
 void tearDown(void) {
     //Reset calls to malloc
     count_malloc = 0;
+    write_count = 0;
 }
 
 void test_CountSetBitsCountsBits(void){
@@ -52,8 +106,11 @@ void test_CountSetBitsReturns0WhenCountIsGreaterThan4(void){
 
 void test_MLX90393_Init_callsGetSettingsWhenNullSettings(void){
     //GetSettings_AddCallback(cb_GetSettings);
+    write_function_IgnoreAndReturn(0);
+    read_function_Stub(cb_read_ok);
     GetSettings_ExpectAndReturn(&fake_mlx, 0);
     MLX90393_Init(&fake_mlx, NULL);
+    TEST_ASSERT_EQUAL_HEX16((1 << MLX90393_NUM_REGS) - 1, fake_mlx.regs_valid); //Whole shadow known
 }
 
 void test_MLX90393_Init_callsApplySettingsWhenSettings(void){
@@ -68,7 +125,25 @@ void test_MLX90393_Init_callsApplySettingsWhenSettings(void){
     };
     //ApplySettings_AddCallback(cb_ApplySettings);
     ApplySettings_ExpectAndReturn(&fake_mlx, &settings, 0);
-    MLX90393_Init(&fake_mlx, &settings);
+    write_function_IgnoreAndReturn(0);
+    read_function_Stub(cb_read_ok);
+    TEST_ASSERT_EQUAL(0, MLX90393_Init(&fake_mlx, &settings));
+    TEST_ASSERT_EQUAL_HEX16((1 << MLX90393_NUM_REGS) - 1, fake_mlx.regs_valid); //Whole shadow known
+}
+
+void test_MLX90393_Init_SyncsOnceThenWritesOnlyTheDiff(void){
+    mlx_cfg_t settings = { .gain = MLX90393_GAIN_1X }; //CONF1 changes, CONF3 is already all zero
+    mlx_cfg_t storage;
+    fake_mlx.settings = &storage;
+    write_function_Stub(cb_write_log);
+    read_function_Stub(cb_read_ok);
+    ApplySettings_Stub(cb_ApplySettings_real);
+
+    TEST_ASSERT_EQUAL(0, MLX90393_Init(&fake_mlx, &settings));
+    TEST_ASSERT_EQUAL(MLX90393_NUM_REGS + 1, write_count); //10 RR, then a single WR
+    TEST_ASSERT_EQUAL_HEX8(0x60, written[MLX90393_NUM_REGS][0]);
+    TEST_ASSERT_EQUAL_HEX8(MLX90393_REG_CONF1 << 2, written[MLX90393_NUM_REGS][3]);
+    fake_mlx.settings = NULL;
 }
 
 void test_MLX90393_Init_Returns1WhenNullDev(void){
@@ -90,13 +165,22 @@ void test_MLX90393_Init_Returns2WhenNoFullDevStruct(void){
     TEST_ASSERT_EQUAL(2, MLX90393_Init(&fake_mlx, NULL));
 }
 
+void test_MLX90393_Init_AcceptsTransferInsteadOfWriteRead(void){
+    fake_mlx.write_function = NULL;
+    fake_mlx.read_function = NULL;
+    fake_mlx.transfer = transfer_function;
+    transfer_function_Stub(cb_transfer_ok);
+    GetSettings_ExpectAndReturn(&fake_mlx, 0);
+    TEST_ASSERT_EQUAL(0, MLX90393_Init(&fake_mlx, NULL));
+}
+
 void test_MLX90393_GetSettings_Returns1WhenNullDevStruct(void){
     TEST_ASSERT_EQUAL(1, MLX90393_GetSettings(NULL));
 }
 void test_MLX90393_GetSettings_WontCallMallocWhenSettingsProvided(void){ //It calls it just once to create the new_settings struct with the readings of the sensor
 
     write_function_IgnoreAndReturn(0);
-    read_function_IgnoreAndReturn(0);
+    read_function_Stub(cb_read_ok);
 
     fake_mlx.settings = (mlx_cfg_t *) malloc(sizeof(mlx_cfg_t));
     mlx_cfg_t settings = {
@@ -117,7 +201,7 @@ void test_MLX90393_GetSettings_AllocatesMemoryIfNullSettingsAndThenProceedsAsUsu
     //We expect malloc to be called. 
     mlx_malloc_Stub(cb_malloc);
     write_function_IgnoreAndReturn(0);
-    read_function_IgnoreAndReturn(0);
+    read_function_Stub(cb_read_ok);
     fake_mlx.settings = NULL; 
     (void) MLX90393_GetSettings(&fake_mlx); 
     free(fake_mlx.settings);
@@ -140,7 +224,7 @@ void test_MLX90393_ApplySettings_Returns1WhenNullDevStructOrNullNewDevSettings(v
 void test_MLX90393_ApplySettings_WontCallMallocWhenDevSettingsProvided(void){ //It calls it just once to create the new_settings struct with the readings of the sensor
 
     write_function_IgnoreAndReturn(0);
-    read_function_IgnoreAndReturn(0);
+    read_function_Stub(cb_read_ok);
 
     fake_mlx.settings = (mlx_cfg_t *) malloc(sizeof(mlx_cfg_t));  
     mlx_cfg_t settings = {
@@ -163,7 +247,7 @@ void test_MLX90393_ApplySettings_AllocatesMemoryIfNullDevSettingsAndThenProceeds
     mlx_cfg_t new_settings;
     mlx_malloc_Stub(cb_malloc);
     write_function_IgnoreAndReturn(0);
-    read_function_IgnoreAndReturn(0);
+    read_function_Stub(cb_read_ok);
     fake_mlx.settings = NULL; 
     (void) MLX90393_ApplySettings(&fake_mlx, &new_settings); 
     free(fake_mlx.settings);
@@ -178,6 +262,245 @@ void test_MLX90393_ApplySettings_ReturnsNeg1IfMemoryAllocationFails(void){
 }
 
 
+void test_MLX90393_SyncRegisters_ReadsWholeVolatileMap(void){
+    write_function_Stub(cb_write_log);
+    read_function_Stub(cb_read_reg);
+
+    TEST_ASSERT_EQUAL(0, MLX90393_SyncRegisters(&fake_mlx));
+    TEST_ASSERT_EQUAL(MLX90393_NUM_REGS, write_count);
+    TEST_ASSERT_EQUAL_HEX16((1 << MLX90393_NUM_REGS) - 1, fake_mlx.regs_valid);
+    TEST_ASSERT_EQUAL_HEX16(0x095A, fake_mlx.regs[9]);
+}
+
+//The second RR fails on the bus, later ones would succeed
+static int32_t cb_read_fail_second(mlx_i2c_t *dev, uint8_t *data, size_t len, int n){
+    memset(data, 0, len);
+    return n == 1 ? 7 : 0;
+}
+
+void test_MLX90393_GetSettings_ReturnsFirstReadError(void){
+    mlx_cfg_t settings;
+    fake_mlx.settings = &settings;
+    write_function_Stub(cb_write_log);
+    read_function_Stub(cb_read_fail_second);
+
+    TEST_ASSERT_EQUAL(7, MLX90393_GetSettings(&fake_mlx));
+    TEST_ASSERT_EQUAL(2, write_count);
+    TEST_ASSERT_EQUAL_HEX16(0x0001, fake_mlx.regs_valid);
+}
+
+void test_MLX90393_GetSettings_ReadsOnlyConf1AndConf3(void){
+    mlx_cfg_t settings;
+    fake_mlx.settings = &settings;
+    write_function_Stub(cb_write_log);
+    read_function_Stub(cb_read_reg);
+
+    TEST_ASSERT_EQUAL(0, MLX90393_GetSettings(&fake_mlx));
+    TEST_ASSERT_EQUAL(2, write_count);
+    TEST_ASSERT_EQUAL_HEX8(MLX90393_REG_CONF1 << 2, written[0][1]);
+    TEST_ASSERT_EQUAL_HEX8(MLX90393_REG_CONF3 << 2, written[1][1]);
+
+    TEST_ASSERT_EQUAL(0, MLX90393_GetSettings(&fake_mlx)); //Both now come from the shadow
+    TEST_ASSERT_EQUAL(2, write_count);
+    fake_mlx.settings = NULL;
+}
+
+void test_MLX90393_GetSettings_DecodesFromShadowRegisters(void){
+    mlx_cfg_t settings;
+    fake_mlx.settings = &settings;
+    write_function_Stub(cb_write_log);
+    read_function_Stub(cb_read_reg);
+
+    TEST_ASSERT_EQUAL(0, MLX90393_GetSettings(&fake_mlx));
+    //CONF1 = 0x005A -> gain 5, CONF3 = 0x025A -> OSR 2, filter 6, res x 2, y 0, z 1
+    TEST_ASSERT_EQUAL(MLX90393_GAIN_1_67X, settings.gain);
+    TEST_ASSERT_EQUAL(MLX90393_OSR_2, settings.oversampling);
+    TEST_ASSERT_EQUAL(MLX90393_FILTER_6, settings.filter);
+    TEST_ASSERT_EQUAL(MLX90393_RES_18, settings.resolution_x);
+    TEST_ASSERT_EQUAL(MLX90393_RES_16, settings.resolution_y);
+    TEST_ASSERT_EQUAL(MLX90393_RES_17, settings.resolution_z);
+    fake_mlx.settings = NULL;
+}
+
+void test_MLX90393_ApplySettings_NoBusTrafficWhenNothingChanges(void){
+    mlx_cfg_t current;
+    mlx_cfg_t settings = {
+        .gain = MLX90393_GAIN_1X,
+        .resolution_x = MLX90393_RES_17,
+        .resolution_y = MLX90393_RES_17,
+        .resolution_z = MLX90393_RES_16,
+        .filter = MLX90393_FILTER_3,
+        .oversampling = MLX90393_OSR_2
+    };
+    fake_mlx.settings = &current;
+    fake_mlx.regs[MLX90393_REG_CONF1] = 0x0070;
+    fake_mlx.regs[MLX90393_REG_CONF3] = 0x00AE;
+    fake_mlx.regs_valid = (1 << MLX90393_REG_CONF1) | (1 << MLX90393_REG_CONF3);
+
+    //No write_function/read_function expectations: any bus access fails the test
+    TEST_ASSERT_EQUAL(0, MLX90393_ApplySettings(&fake_mlx, &settings));
+    fake_mlx.settings = NULL;
+}
+
+void test_MLX90393_ApplySettings_WritesOnlyChangedRegister(void){
+    mlx_cfg_t current;
+    mlx_cfg_t settings = {
+        .gain = MLX90393_GAIN_5X,
+        .resolution_x = MLX90393_RES_17,
+        .resolution_y = MLX90393_RES_17,
+        .resolution_z = MLX90393_RES_16,
+        .filter = MLX90393_FILTER_3,
+        .oversampling = MLX90393_OSR_2
+    };
+    fake_mlx.settings = &current;
+    fake_mlx.regs[MLX90393_REG_CONF1] = 0x007C;
+    fake_mlx.regs[MLX90393_REG_CONF3] = 0x00AE;
+    fake_mlx.regs_valid = (1 << MLX90393_REG_CONF1) | (1 << MLX90393_REG_CONF3);
+    write_function_Stub(cb_write_log);
+    read_function_Stub(cb_read_ok);
+
+    TEST_ASSERT_EQUAL(0, MLX90393_ApplySettings(&fake_mlx, &settings));
+    TEST_ASSERT_EQUAL(1, write_count);
+    uint8_t expected[4] = {0x60, 0x00, 0x0C, MLX90393_REG_CONF1 << 2}; //HALLCONF bits preserved
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, written[0], 4);
+    TEST_ASSERT_EQUAL_HEX16(0x000C, fake_mlx.regs[MLX90393_REG_CONF1]);
+    fake_mlx.settings = NULL;
+}
+
+void test_MLX90393_RT_InvalidatesShadowRegisters(void){
+    uint8_t status;
+    fake_mlx.regs_valid = 0x3FF;
+    write_function_IgnoreAndReturn(0);
+    read_function_Stub(cb_read_ok);
+
+    TEST_ASSERT_EQUAL(0, MLX90393_RT(&fake_mlx, &status));
+    TEST_ASSERT_EQUAL(0, fake_mlx.regs_valid);
+}
+
+void test_MLX90393_InvalidateRegisters_ForgetsShadow(void){
+    fake_mlx.regs_valid = 0x3FF;
+    MLX90393_InvalidateRegisters(&fake_mlx);
+    TEST_ASSERT_EQUAL(0, fake_mlx.regs_valid);
+}
+
+//RR answers with what the shadow says was written
+static int32_t cb_read_echo(mlx_i2c_t *dev, uint8_t *data, size_t len, int n){
+    data[0] = 0x00;
+    if (len == 3){
+        int reg = written[write_count - 1][1] >> 2;
+        data[1] = dev->regs[reg] >> 8;
+        data[2] = dev->regs[reg] & 0xFF;
+    }
+    return 0;
+}
+
+static void prepare_ext_cfg(mlx_cfg_ext_t *cfg){
+    memset(cfg, 0, sizeof(mlx_cfg_ext_t));
+    cfg->base.gain = MLX90393_GAIN_1X;
+    cfg->base.resolution_x = MLX90393_RES_17;
+    cfg->base.resolution_y = MLX90393_RES_17;
+    cfg->base.resolution_z = MLX90393_RES_16;
+    cfg->base.filter = MLX90393_FILTER_3;
+    cfg->base.oversampling = MLX90393_OSR_2;
+    cfg->hallconf = 0x0C;
+    //Shadow matching cfg: nothing to write
+    memset(fake_mlx.regs, 0, sizeof(fake_mlx.regs));
+    fake_mlx.regs[MLX90393_REG_CONF1] = 0x007C;
+    fake_mlx.regs[MLX90393_REG_CONF3] = 0x00AE;
+    fake_mlx.regs_valid = (1 << MLX90393_NUM_REGS) - 1;
+}
+
+void test_MLX90393_ApplyConfig_Returns1WhenNullArguments(void){
+    mlx_cfg_ext_t cfg;
+    TEST_ASSERT_EQUAL(1, MLX90393_ApplyConfig(NULL, &cfg));
+    TEST_ASSERT_EQUAL(1, MLX90393_ApplyConfig(&fake_mlx, NULL));
+}
+
+void test_MLX90393_ApplyConfig_NoBusTrafficWhenShadowMatches(void){
+    mlx_cfg_t current;
+    mlx_cfg_ext_t cfg;
+    fake_mlx.settings = &current;
+    prepare_ext_cfg(&cfg);
+
+    TEST_ASSERT_EQUAL(0, MLX90393_ApplyConfig(&fake_mlx, &cfg));
+    TEST_ASSERT_EQUAL(MLX90393_GAIN_1X, current.gain);
+    fake_mlx.settings = NULL;
+}
+
+void test_MLX90393_ApplyConfig_BatchesWritesAndVerifiesOnce(void){
+    mlx_cfg_t current;
+    mlx_cfg_ext_t cfg;
+    fake_mlx.settings = &current;
+    prepare_ext_cfg(&cfg);
+    cfg.burst_data_rate = 5;
+    cfg.burst_sel = MLX90393_MAG_XYZ;
+    cfg.woz_threshold = 0x0100;
+    write_function_Stub(cb_write_log);
+    read_function_Stub(cb_read_echo);
+
+    TEST_ASSERT_EQUAL(0, MLX90393_ApplyConfig(&fake_mlx, &cfg));
+    TEST_ASSERT_EQUAL(3, write_count); //WR CONF2, WR WOZ, RR WOZ
+    uint8_t conf2[4] = {0x60, 0x03, 0x85, MLX90393_REG_CONF2 << 2};
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(conf2, written[0], 4);
+    TEST_ASSERT_EQUAL_HEX8(0x60, written[1][0]);
+    TEST_ASSERT_EQUAL_HEX8(0x50, written[2][0]);
+    TEST_ASSERT_EQUAL_HEX8(MLX90393_REG_WOZ_THRESHOLD << 2, written[2][1]);
+    fake_mlx.settings = NULL;
+}
+
+void test_MLX90393_ApplyConfig_ReturnsMismatchWhenReadBackDiffers(void){
+    mlx_cfg_t current;
+    mlx_cfg_ext_t cfg;
+    fake_mlx.settings = &current;
+    prepare_ext_cfg(&cfg);
+    cfg.wot_threshold = 0x1234;
+    write_function_Stub(cb_write_log);
+    read_function_Stub(cb_read_reg);
+
+    TEST_ASSERT_EQUAL(MLX90393_MISMATCH, MLX90393_ApplyConfig(&fake_mlx, &cfg));
+    fake_mlx.settings = NULL;
+}
+
+//WR accepted, RR rejected
+static int32_t cb_read_rr_error(mlx_i2c_t *dev, uint8_t *data, size_t len, int n){
+    memset(data, 0, len);
+    if (len == 3){
+        data[0] = 0x10;
+    }
+    return 0;
+}
+
+void test_MLX90393_ApplyConfig_ReturnsMismatchWhenReadBackRejected(void){
+    mlx_cfg_t current;
+    mlx_cfg_ext_t cfg;
+    fake_mlx.settings = &current;
+    prepare_ext_cfg(&cfg);
+    cfg.wot_threshold = 0x1234;
+    write_function_Stub(cb_write_log);
+    read_function_Stub(cb_read_rr_error);
+
+    TEST_ASSERT_EQUAL(MLX90393_MISMATCH, MLX90393_ApplyConfig(&fake_mlx, &cfg));
+    fake_mlx.settings = NULL;
+}
+
+void test_MLX90393_GetConfig_DecodesShadow(void){
+    mlx_cfg_ext_t cfg;
+    prepare_ext_cfg(&cfg);
+    fake_mlx.regs[MLX90393_REG_CONF2] = 0x0785; //TCMP_EN, burst XYZ every 100 ms
+    fake_mlx.regs[MLX90393_REG_OFFSET_Y] = 0x8001;
+
+    TEST_ASSERT_EQUAL(0, MLX90393_GetConfig(&fake_mlx, &cfg));
+    TEST_ASSERT_EQUAL(5, cfg.burst_data_rate);
+    TEST_ASSERT_EQUAL_HEX8(MLX90393_MAG_XYZ, cfg.burst_sel);
+    TEST_ASSERT_EQUAL(1, cfg.tcmp_en);
+    TEST_ASSERT_EQUAL(0x0C, cfg.hallconf);
+    TEST_ASSERT_EQUAL(MLX90393_FILTER_3, cfg.base.filter);
+    TEST_ASSERT_EQUAL_HEX16(0x8001, cfg.offset[1]);
+
+    fake_mlx.regs_valid = 0;
+    TEST_ASSERT_EQUAL(MLX90393_AGAIN, MLX90393_GetConfig(&fake_mlx, &cfg));
+}
+
 void test_MLX90393_readXYZ_returns1IfNullDevPointerOrNullXYZarray(void){
     float xyz[3];
     TEST_ASSERT_EQUAL(1, MLX90393_readXYZ(&fake_mlx, NULL));
@@ -199,7 +522,7 @@ void test_MLX90393_readXYZ_callsMdelayWithCorrectTime(void){
     float xyz[3];
 
     write_function_IgnoreAndReturn(0);
-    read_function_IgnoreAndReturn(0);
+    read_function_Stub(cb_read_ok);
     delay_function_Expect(9); //MLX90393_Tconv_LookUp[3][2] + 1
 
     TEST_ASSERT_EQUAL(0, MLX90393_readXYZ(&fake_mlx, xyz));
@@ -219,7 +542,7 @@ void test_MLX90393_readXYZsubtractsForHiResSettings(void){
     float xyz[3];
 
     write_function_IgnoreAndReturn(0);
-    read_function_IgnoreAndReturn(0);
+    read_function_Stub(cb_read_ok);
     delay_function_Ignore();
 
     TEST_ASSERT_EQUAL(0, MLX90393_readXYZ(&fake_mlx, xyz));
@@ -232,6 +555,398 @@ void test_MLX90393_readXYZsubtractsForHiResSettings(void){
 
 }
 
+void test_MLX90393_readXYZ_waitsExactTconvInMicrosecondsWhenUdelayProvided(void){
+    fake_mlx.udelay = udelay_function;
+    fake_mlx.settings->filter = MLX90393_FILTER_0;
+    fake_mlx.settings->oversampling = MLX90393_OSR_0;
+    float xyz[3];
+
+    write_function_IgnoreAndReturn(0);
+    read_function_Stub(cb_read_ok);
+    udelay_function_Expect(1270); //MLX90393_Tconv_LookUp[0][0] = 1.27 ms, no whole-ms rounding
+
+    TEST_ASSERT_EQUAL(0, MLX90393_readXYZ(&fake_mlx, xyz));
+}
+
+void test_MLX90393_readXYZ_repollsWhileStatusReportsNotReady(void){
+    fake_mlx.udelay = udelay_function;
+    fake_mlx.ready_retries = 3;
+    fake_mlx.settings->filter = MLX90393_FILTER_3;
+    fake_mlx.settings->oversampling = MLX90393_OSR_2;
+    float xyz[3];
+
+    write_function_IgnoreAndReturn(0);
+    read_function_Stub(cb_read_not_ready_once);
+    udelay_function_Expect(8370);
+    udelay_function_Expect(MLX90393_READY_POLL_US);
+
+    TEST_ASSERT_EQUAL(0, MLX90393_readXYZ(&fake_mlx, xyz));
+}
+
+void test_MLX90393_readMeasurement_waitsTconvOfRequestedChannels(void){
+    mlx_sample_t sample;
+    fake_mlx.udelay = udelay_function;
+    fake_mlx.settings->filter = MLX90393_FILTER_3;
+    fake_mlx.settings->oversampling = MLX90393_OSR_2;
+
+    write_function_IgnoreAndReturn(0);
+    read_function_Stub(cb_read_ok);
+    clock_function_IgnoreAndReturn(0);
+    udelay_function_Expect(8370 + 67 + 192); //XYZ + TCONVT at OSR2 = 0
+    TEST_ASSERT_EQUAL(0, MLX90393_readMeasurement(&fake_mlx, MLX90393_MAG_XYZT, &sample));
+    TEST_ASSERT_EQUAL(8629, MLX90393_GetTconvZyxt_us(&fake_mlx, MLX90393_MAG_XYZT));
+
+    fake_mlx.regs[MLX90393_REG_CONF3] = 3 << 11; //OSR2 = 3
+    fake_mlx.regs_valid |= 1 << MLX90393_REG_CONF3;
+    udelay_function_Expect(8370 - 2 * 2627 + 67 + (192 << 3)); //Z + T
+    TEST_ASSERT_EQUAL(0, MLX90393_readMeasurement(&fake_mlx, MLX90393_MAG_Z | MLX90393_TEMP, &sample));
+    TEST_ASSERT_EQUAL(MLX90393_GetTconv_us(&fake_mlx), MLX90393_GetTconvZyxt_us(&fake_mlx, MLX90393_MAG_XYZ));
+}
+
+void test_MLX90393_WaitAndRead_returnsLastStatusAfterRetryBudget(void){
+    uint8_t status;
+    uint8_t data[6];
+    fake_mlx.udelay = udelay_function;
+    fake_mlx.ready_retries = 0;
+
+    write_function_IgnoreAndReturn(0);
+    read_function_Stub(cb_read_not_ready_once);
+    udelay_function_Ignore();
+
+    TEST_ASSERT_EQUAL(0, MLX90393_SM(&fake_mlx, MLX90393_MAG_XYZ, &status));
+    TEST_ASSERT_EQUAL(0, MLX90393_WaitAndRead(&fake_mlx, MLX90393_MAG_XYZ, &status, data));
+    TEST_ASSERT_EQUAL_HEX8(0x10, status);
+}
+
+void test_MLX90393_StartXYZ_Returns1WithoutClockHook(void){
+    fake_mlx.clock_us = NULL;
+    TEST_ASSERT_EQUAL(1, MLX90393_StartXYZ(&fake_mlx, NULL));
+}
+
+void test_MLX90393_StartXYZ_ReturnsDeadlineFromTconv(void){
+    uint64_t deadline;
+    fake_mlx.settings->filter = MLX90393_FILTER_3;
+    fake_mlx.settings->oversampling = MLX90393_OSR_2;
+
+    write_function_IgnoreAndReturn(0);
+    read_function_Stub(cb_read_ok);
+    clock_function_ExpectAndReturn(1000);
+
+    TEST_ASSERT_EQUAL(0, MLX90393_StartXYZ(&fake_mlx, &deadline));
+    TEST_ASSERT_EQUAL_UINT64(1000 + 8370, deadline);
+    TEST_ASSERT_EQUAL(MLX90393_AGAIN, MLX90393_StartXYZ(&fake_mlx, &deadline)); //Already in flight
+}
+
+void test_MLX90393_CompleteXYZ_Returns1WhenNothingStarted(void){
+    float xyz[3];
+    TEST_ASSERT_EQUAL(1, MLX90393_CompleteXYZ(&fake_mlx, xyz));
+}
+
+void test_MLX90393_CompleteXYZ_ReturnsAgainWithoutBusTrafficBeforeDeadline(void){
+    float xyz[3];
+    fake_mlx.pending = 1;
+    fake_mlx.deadline_us = 5000;
+    clock_function_ExpectAndReturn(4999);
+
+    TEST_ASSERT_EQUAL(MLX90393_AGAIN, MLX90393_CompleteXYZ(&fake_mlx, xyz));
+    TEST_ASSERT_EQUAL(1, fake_mlx.pending);
+}
+
+void test_MLX90393_CompleteXYZ_ReadsOnceDeadlineIsReached(void){
+    float xyz[3];
+    fake_mlx.pending = 1;
+    fake_mlx.deadline_us = 5000;
+    clock_function_ExpectAndReturn(5000);
+    write_function_IgnoreAndReturn(0);
+    read_function_Stub(cb_read_ok);
+
+    TEST_ASSERT_EQUAL(0, MLX90393_CompleteXYZ(&fake_mlx, xyz));
+    TEST_ASSERT_EQUAL(0, fake_mlx.pending);
+}
+
+static int32_t cb_read_error(mlx_i2c_t *dev, uint8_t *data, size_t len, int n){
+    memset(data, 0, len);
+    data[0] = 0x10; //ERROR
+    return 0;
+}
+
+void test_MLX90393_StartXYZ_ReturnsMismatchWhenSMRejected(void){
+    write_function_IgnoreAndReturn(0);
+    read_function_Stub(cb_read_error);
+
+    TEST_ASSERT_EQUAL(MLX90393_MISMATCH, MLX90393_StartXYZ(&fake_mlx, NULL));
+    TEST_ASSERT_EQUAL(0, fake_mlx.pending);
+}
+
+void test_MLX90393_CompleteXYZ_TimesOutOneTconvPastDeadline(void){
+    float xyz[3];
+    fake_mlx.pending = 1;
+    fake_mlx.deadline_us = 5000;
+    write_function_IgnoreAndReturn(0);
+    read_function_Stub(cb_read_error);
+
+    clock_function_ExpectAndReturn(5000);
+    TEST_ASSERT_EQUAL(MLX90393_AGAIN, MLX90393_CompleteXYZ(&fake_mlx, xyz));
+    TEST_ASSERT_EQUAL(1, fake_mlx.pending);
+    clock_function_ExpectAndReturn(5000 + MLX90393_GetTconv_us(&fake_mlx));
+    TEST_ASSERT_EQUAL(MLX90393_TIMEOUT, MLX90393_CompleteXYZ(&fake_mlx, xyz));
+    TEST_ASSERT_EQUAL(0, fake_mlx.pending);
+}
+
+void test_MLX90393_CancelXYZ_AllowsANewStart(void){
+    fake_mlx.pending = 1;
+    MLX90393_CancelXYZ(&fake_mlx);
+    TEST_ASSERT_EQUAL(0, fake_mlx.pending);
+    MLX90393_CancelXYZ(NULL);
+}
+
+void test_MLX90393_convertXYZ_nT_Returns1WhenNullArguments(void){
+    mlx_cfg_t cfg;
+    uint8_t data[6];
+    int32_t xyz[3];
+    TEST_ASSERT_EQUAL(1, MLX90393_convertXYZ_nT(NULL, data, xyz));
+    TEST_ASSERT_EQUAL(1, MLX90393_convertXYZ_nT(&cfg, NULL, xyz));
+    TEST_ASSERT_EQUAL(1, MLX90393_convertXYZ_nT(&cfg, data, NULL));
+}
+
+void test_MLX90393_convertXYZ_nT_MatchesFloatPathForAllGainsAndResolutions(void){
+    static const int32_t extremes[] = {-32768, -32767, -1, 0, 1, 32766, 32767};
+    uint8_t data[6];
+    float xyz[3];
+    int32_t xyz_nT[3];
+    mlx_cfg_t cfg = { .filter = MLX90393_FILTER_0, .oversampling = MLX90393_OSR_0 };
+    size_t n_extremes = sizeof(extremes) / sizeof(extremes[0]);
+
+    for (int gain = 0; gain < 8; gain++){
+        for (int res = 0; res < 4; res++){
+            cfg.gain = (mlx90393_gain_t) gain;
+            cfg.resolution_x = cfg.resolution_y = cfg.resolution_z = (mlx90393_resolution_t) res;
+            uint16_t offset = MLX90393_ZeroOffset((mlx90393_resolution_t) res, 0);
+            //The extremes, then a stride through the whole int16 range
+            for (size_t k = 0; k < n_extremes + 65536 / 97; k++){
+                int32_t counts = k < n_extremes ? extremes[k] : -32768 + 97 * (int32_t) (k - n_extremes);
+                int16_t c[3] = {(int16_t) counts, (int16_t) ~counts, (int16_t) (counts ^ 0x5555)};
+                for (int axis = 0; axis < 3; axis++){
+                    uint16_t raw = (uint16_t) (c[axis] + offset);
+                    data[2 * axis] = raw >> 8;
+                    data[2 * axis + 1] = raw & 0xFF;
+                }
+                TEST_ASSERT_EQUAL(0, MLX90393_convertXYZ(&cfg, data, xyz));
+                TEST_ASSERT_EQUAL(0, MLX90393_convertXYZ_nT(&cfg, data, xyz_nT));
+                for (int axis = 0; axis < 3; axis++){
+                    TEST_ASSERT_EQUAL_INT32((int32_t) c[axis] * MLX90393_Sensitivity_nT_LookUp[gain][res][axis == 2], xyz_nT[axis]);
+                    //2 ulp of the float path, + 1 nT for rounding it back to an integer
+                    int32_t tolerance = (int32_t) (1.2e-7 * abs(xyz_nT[axis])) + 1;
+                    int32_t from_float = (int32_t) ((double) xyz[axis] * 1000.0 + (xyz[axis] < 0 ? -0.5 : 0.5));
+                    TEST_ASSERT_INT_WITHIN(tolerance, from_float, xyz_nT[axis]);
+                }
+            }
+        }
+    }
+}
+
+void test_MLX90393_convertXYZ_nT_IsExactIntegerProduct(void){
+    uint8_t data[6] = {0x00, 0x64, 0xFF, 0x9C, 0x80, 0x00};
+    int32_t xyz_nT[3];
+    mlx_cfg_t cfg = {
+        .gain = MLX90393_GAIN_1X,
+        .resolution_x = MLX90393_RES_16,
+        .resolution_y = MLX90393_RES_16,
+        .resolution_z = MLX90393_RES_18, //0x8000 is zero field
+    };
+    TEST_ASSERT_EQUAL(0, MLX90393_convertXYZ_nT(&cfg, data, xyz_nT));
+    TEST_ASSERT_EQUAL_INT32(16100, xyz_nT[0]);
+    TEST_ASSERT_EQUAL_INT32(-16100, xyz_nT[1]);
+    TEST_ASSERT_EQUAL_INT32(0, xyz_nT[2]);
+}
+
+void test_MLX90393_convertBatch_Returns1WhenNoChannelsOrNullFrames(void){
+    mlx_cfg_t cfg = {0};
+    uint8_t frames[6];
+    float x[1];
+    TEST_ASSERT_EQUAL(1, MLX90393_convertBatch(&cfg, 0, 0x00, frames, 1, x, NULL, NULL, NULL));
+    TEST_ASSERT_EQUAL(1, MLX90393_convertBatch(&cfg, 0, MLX90393_MAG_XYZ, NULL, 1, x, NULL, NULL, NULL));
+    TEST_ASSERT_EQUAL(1, MLX90393_convertBatch(NULL, 0, MLX90393_MAG_XYZ, frames, 1, x, NULL, NULL, NULL));
+}
+
+void test_MLX90393_convertBatch_MatchesPerSampleConversion(void){
+    uint8_t frames[4][6] = {
+        {0x00, 0x64, 0xFF, 0x9C, 0x80, 0x00},
+        {0x7F, 0xFF, 0x80, 0x00, 0x12, 0x34},
+        {0xC0, 0x00, 0x40, 0x00, 0x00, 0x00},
+        {0xFF, 0xFF, 0x00, 0x01, 0xBF, 0xFF}
+    };
+    float x[4], y[4], z[4];
+    float xyz[3];
+    mlx_cfg_t cfg = { .gain = MLX90393_GAIN_2X };
+
+    for (int res = 0; res < 4; res++){
+        cfg.resolution_x = (mlx90393_resolution_t) res;
+        cfg.resolution_y = (mlx90393_resolution_t) ((res + 1) % 4);
+        cfg.resolution_z = (mlx90393_resolution_t) ((res + 2) % 4);
+        TEST_ASSERT_EQUAL(0, MLX90393_convertBatch(&cfg, 0, MLX90393_MAG_XYZ, frames[0], 4, x, y, z, NULL));
+        for (int i = 0; i < 4; i++){
+            MLX90393_convertXYZ(&cfg, frames[i], xyz);
+            TEST_ASSERT_EQUAL_FLOAT(xyz[0], x[i]);
+            TEST_ASSERT_EQUAL_FLOAT(xyz[1], y[i]);
+            TEST_ASSERT_EQUAL_FLOAT(xyz[2], z[i]);
+        }
+    }
+}
+
+void test_MLX90393_convertBatch_UsesTcmpZeroOffset(void){
+    //With TCMP_EN, RES_16/RES_17 are unsigned around 0x8000: X = 100, Y = -100, Z = 0
+    uint8_t frames[2][6] = {
+        {0x80, 0x64, 0x7F, 0x9C, 0x80, 0x00},
+        {0xFF, 0xFF, 0x00, 0x00, 0x12, 0x34}
+    };
+    float x[2], y[2], z[2];
+    mlx_cfg_t cfg = { .gain = MLX90393_GAIN_1X, .resolution_x = MLX90393_RES_16,
+                      .resolution_y = MLX90393_RES_16, .resolution_z = MLX90393_RES_17 };
+    mlx_sample_t sample;
+
+    TEST_ASSERT_EQUAL(0, MLX90393_convertBatch(&cfg, 1, MLX90393_MAG_XYZ, frames[0], 2, x, y, z, NULL));
+    TEST_ASSERT_EQUAL_FLOAT(100 * MLX90393_GetSensitivity(&cfg, 0), x[0]);
+    TEST_ASSERT_EQUAL_FLOAT(-100 * MLX90393_GetSensitivity(&cfg, 1), y[0]);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, z[0]);
+    for (int i = 0; i < 2; i++){
+        MLX90393_convert(&cfg, 1, MLX90393_MAG_XYZ, frames[i], &sample);
+        TEST_ASSERT_EQUAL_FLOAT(sample.xyz[0], x[i]);
+        TEST_ASSERT_EQUAL_FLOAT(sample.xyz[1], y[i]);
+        TEST_ASSERT_EQUAL_FLOAT(sample.xyz[2], z[i]);
+    }
+}
+
+void test_MLX90393_convertBatch_DecodesTemperatureFirstAndSkipsNullOutputs(void){
+    //T = 46244 + 452 (45 degC), X = 100, Y = 200 (ignored), Z = -100
+    uint8_t frames[2][8] = {
+        {0xB6, 0x68, 0x00, 0x64, 0x00, 0xC8, 0xFF, 0x9C},
+        {0xB4, 0xA4, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}
+    };
+    float t[2], x[2], z[2];
+    mlx_cfg_t cfg = { .gain = MLX90393_GAIN_1X };
+
+    TEST_ASSERT_EQUAL(0, MLX90393_convertBatch(&cfg, 0, 0x0F, frames[0], 2, x, NULL, z, t));
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 45.0, t[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 35.0, t[1]);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 16.1, x[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, -29.4, z[0]);
+}
+
+static size_t last_read_len;
+
+//SM status, then a Z-only RM payload of -100 counts
+static int32_t cb_read_z(mlx_i2c_t *dev, uint8_t *data, size_t len, int n){
+    last_read_len = len;
+    memset(data, 0, len);
+    if (len == 3){
+        data[1] = 0xFF;
+        data[2] = 0x9C;
+    }
+    return 0;
+}
+
+void test_MLX90393_readMeasurement_Returns1ForNoChannels(void){
+    mlx_sample_t sample;
+    TEST_ASSERT_EQUAL(1, MLX90393_readMeasurement(&fake_mlx, 0x00, &sample));
+    TEST_ASSERT_EQUAL(1, MLX90393_readMeasurement(&fake_mlx, MLX90393_MAG_Z, NULL));
+}
+
+void test_MLX90393_readMeasurement_ZOnlyTransfersTwoDataBytes(void){
+    mlx_cfg_t settings = { .gain = MLX90393_GAIN_1X, .filter = MLX90393_FILTER_0 };
+    mlx_sample_t sample;
+    fake_mlx.settings = &settings;
+    write_function_Stub(cb_write_log);
+    read_function_Stub(cb_read_z);
+    delay_function_Ignore();
+    clock_function_IgnoreAndReturn(0);
+
+    TEST_ASSERT_EQUAL(0, MLX90393_readMeasurement(&fake_mlx, MLX90393_MAG_Z, &sample));
+    TEST_ASSERT_EQUAL_HEX8(0x38, written[0][0]);
+    TEST_ASSERT_EQUAL_HEX8(0x48, written[1][0]);
+    TEST_ASSERT_EQUAL(3, last_read_len);
+    TEST_ASSERT_EQUAL_HEX8(MLX90393_MAG_Z, sample.zyxt);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, -29.4, sample.xyz[2]);
+    fake_mlx.settings = NULL;
+}
+
+void test_MLX90393_readMeasurement_StampsSample(void){
+    mlx_cfg_t settings = { .gain = MLX90393_GAIN_1X, .filter = MLX90393_FILTER_0 };
+    mlx_sample_t sample;
+    mlx_jitter_t jitter = {0};
+    fake_mlx.settings = &settings;
+    fake_mlx.jitter = &jitter;
+    fake_mlx.seq = 41;
+    write_function_Stub(cb_write_log);
+    read_function_Stub(cb_read_z);
+    delay_function_Ignore();
+    clock_function_ExpectAndReturn(1000); //SM issued
+    clock_function_ExpectAndReturn(2900); //RM done
+
+    TEST_ASSERT_EQUAL(0, MLX90393_readMeasurement(&fake_mlx, MLX90393_MAG_Z, &sample));
+    TEST_ASSERT_EQUAL(41, sample.seq);
+    TEST_ASSERT_EQUAL(42, fake_mlx.seq);
+    TEST_ASSERT_EQUAL(1000, sample.t_issue_us);
+    TEST_ASSERT_EQUAL(1000 + 752, sample.t_expected_us); //1270 us XYZ - 2 * 259 us TCONVM
+    TEST_ASSERT_EQUAL(2900, sample.t_done_us);
+    TEST_ASSERT_EQUAL(1, jitter.samples);
+    TEST_ASSERT_EQUAL(2900 - sample.t_expected_us, jitter.latency_max_us);
+    fake_mlx.settings = NULL;
+    fake_mlx.jitter = NULL;
+}
+
+void test_MLX90393_JitterUpdate_TracksPeriodJitterAndLatency(void){
+    mlx_jitter_t jitter = {0};
+    mlx_sample_t sample = {0};
+    TEST_ASSERT_EQUAL(1, MLX90393_JitterUpdate(NULL, &sample));
+    for (int i = 0; i < 64; i++){
+        sample.t_expected_us = 1000 * i;
+        sample.t_done_us = sample.t_expected_us + 100 + (i & 1) * 50; //Every other read is 50 us late
+        TEST_ASSERT_EQUAL(0, MLX90393_JitterUpdate(&jitter, &sample));
+    }
+    TEST_ASSERT_EQUAL(64, jitter.samples);
+    TEST_ASSERT_FLOAT_WITHIN(5.0f, 1000.0f, jitter.period_us);
+    TEST_ASSERT_FLOAT_WITHIN(5.0f, 50.0f, jitter.jitter_us);
+    TEST_ASSERT_FLOAT_WITHIN(25.0f, 125.0f, jitter.latency_us);
+    TEST_ASSERT_EQUAL(100, jitter.latency_min_us);
+    TEST_ASSERT_EQUAL(150, jitter.latency_max_us);
+}
+
+void test_MLX90393_convert_DecodesTemperatureOnly(void){
+    mlx_cfg_t cfg = {0};
+    mlx_sample_t sample;
+    uint8_t data[2] = {0xB3, 0x18}; //46244 - 396 -> 26.24 degC
+    TEST_ASSERT_EQUAL(0, MLX90393_convert(&cfg, 0, MLX90393_TEMP, data, &sample));
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 26.24, sample.t);
+}
+
+void test_MLX90393_convert_UsesUnsignedOffsetWhenTcmpEnabled(void){
+    mlx_cfg_t cfg = { .gain = MLX90393_GAIN_1X, .resolution_x = MLX90393_RES_16, .resolution_y = MLX90393_RES_17, .resolution_z = MLX90393_RES_19 };
+    mlx_sample_t sample;
+    uint8_t data[6] = {0x80, 0x64, 0x80, 0x00, 0x40, 0x00};
+
+    TEST_ASSERT_EQUAL(0, MLX90393_convert(&cfg, 1, MLX90393_MAG_XYZ, data, &sample));
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 16.1, sample.xyz[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 0.0, sample.xyz[1]);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 0.0, sample.xyz[2]);
+
+    TEST_ASSERT_EQUAL(0, MLX90393_convert(&cfg, 0, MLX90393_MAG_XYZ, data, &sample)); //Signed without TCMP_EN
+    TEST_ASSERT_FLOAT_WITHIN(0.01, -32668 * 0.161, sample.xyz[0]);
+}
+
+void test_MLX90393_TcmpEnabled_FollowsShadowConf2(void){
+    fake_mlx.regs[MLX90393_REG_CONF2] = 0x0400;
+    TEST_ASSERT_EQUAL(0, MLX90393_TcmpEnabled(&fake_mlx)); //Not cached yet
+    fake_mlx.regs_valid = 1 << MLX90393_REG_CONF2;
+    TEST_ASSERT_EQUAL(1, MLX90393_TcmpEnabled(&fake_mlx));
+}
+
+void test_MLX90393_readXYZ_nT_returns1IfNullDevPointerOrNullXYZarray(void){
+    int32_t xyz[3];
+    TEST_ASSERT_EQUAL(1, MLX90393_readXYZ_nT(&fake_mlx, NULL));
+    TEST_ASSERT_EQUAL(1, MLX90393_readXYZ_nT(NULL, xyz));
+}
+
 void test_MLX90393_Free_IdlesWhenNullDevice(void){
     MLX90393_Free(NULL); 
 }
@@ -0,0 +1,172 @@
+#include <pthread.h>
+#include <string.h>
+#include "unity.h"
+#include "MLX90393.h"
+#include "MLX90393_cmds.h"
+#include "MLX90393_sched.h"
+#include "MLX90393_stream.h"
+#include "MLX90393_array.h"
+#include "MLX90393_sim.h"
+
+#define BUSES 2
+#define PER_BUS 3
+#define ROUNDS 50
+
+static mlx_array_t array;
+static mlx_mpsc_t merged;
+static mlx_mpsc_cell_t cells[512];
+static mlx_i2c_t devs[BUSES * PER_BUS];
+static mlx_sim_t sims[BUSES * PER_BUS];
+static mlx_cfg_t settings[BUSES * PER_BUS];
+static mlx_ring_t rings[BUSES * PER_BUS];
+static mlx_sample_t ring_storage[BUSES * PER_BUS][64];
+
+void setUp(void) {
+    MLX90393_MpscInit(&merged, cells, 512);
+    MLX90393_ArrayInit(&array, &merged);
+    for (int i = 0; i < BUSES * PER_BUS; i++){
+        memset(&devs[i], 0, sizeof(mlx_i2c_t));
+        MLX90393_SimInit(&sims[i]);
+        MLX90393_SimAttach(&devs[i], &sims[i]);
+        sims[i].field[0] = 10.0f * (float) i;
+        settings[i] = (mlx_cfg_t) {
+            .gain = MLX90393_GAIN_1X, .resolution_x = MLX90393_RES_16, .resolution_y = MLX90393_RES_16,
+            .resolution_z = MLX90393_RES_16, .filter = MLX90393_FILTER_1, .oversampling = MLX90393_OSR_1
+        };
+        devs[i].settings = &settings[i];
+        MLX90393_ApplySettings(&devs[i], &settings[i]);
+        MLX90393_RingInit(&rings[i], ring_storage[i], 64);
+    }
+}
+
+void tearDown(void) {
+    MLX90393_ArrayStop(&array);
+}
+
+void test_MLX90393_Array_RejectsInvalidSetup(void){
+    mlx_mpsc_cell_t odd[3];
+    TEST_ASSERT_EQUAL(1, MLX90393_MpscInit(&merged, odd, 3));
+    TEST_ASSERT_EQUAL(1, MLX90393_ArrayStart(&array, 1)); //No bus
+    TEST_ASSERT_EQUAL(1, MLX90393_ArrayAddDevice(&array, 0, &devs[0], 0, NULL, NULL));
+    for (int b = 0; b < MLX90393_ARRAY_MAX_BUSES; b++){
+        TEST_ASSERT_EQUAL(0, MLX90393_ArrayAddBus(&array, MLX90393_SimClock, MLX90393_SimUdelay, MLX90393_ARRAY_ANY_CPU, NULL));
+    }
+    TEST_ASSERT_EQUAL(MLX90393_AGAIN, MLX90393_ArrayAddBus(&array, MLX90393_SimClock, MLX90393_SimUdelay, MLX90393_ARRAY_ANY_CPU, NULL));
+}
+
+void test_MLX90393_MpscPushPop_FifoAndFull(void){
+    mlx_mpsc_cell_t small[2];
+    mlx_array_item_t item = {0}, out;
+    MLX90393_MpscInit(&merged, small, 2);
+    TEST_ASSERT_EQUAL(MLX90393_AGAIN, MLX90393_MpscPop(&merged, &out));
+    for (uint32_t i = 0; i < 2; i++){
+        item.device = i;
+        TEST_ASSERT_EQUAL(0, MLX90393_MpscPush(&merged, &item));
+    }
+    TEST_ASSERT_EQUAL(MLX90393_AGAIN, MLX90393_MpscPush(&merged, &item));
+    TEST_ASSERT_EQUAL(0, MLX90393_MpscPop(&merged, &out));
+    TEST_ASSERT_EQUAL(0, out.device);
+    TEST_ASSERT_EQUAL(0, MLX90393_MpscPush(&merged, &item)); //Wraps around
+    TEST_ASSERT_EQUAL(0, MLX90393_MpscPop(&merged, &out));
+    TEST_ASSERT_EQUAL(1, out.device);
+}
+
+#define PRODUCERS 4
+#define PUSHES 20000
+
+static void *producer(void *arg){
+    mlx_array_item_t item = {0};
+    item.device = (uint32_t) (uintptr_t) arg;
+    for (uint32_t i = 0; i < PUSHES; i++){
+        item.sample.seq = i;
+        while (MLX90393_MpscPush(&merged, &item) != 0){
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+void test_MLX90393_Mpsc_KeepsOrderPerProducerUnderContention(void){
+    pthread_t threads[PRODUCERS];
+    uint32_t next[PRODUCERS] = {0};
+    mlx_array_item_t out;
+    for (uintptr_t p = 0; p < PRODUCERS; p++){
+        pthread_create(&threads[p], NULL, producer, (void *) p);
+    }
+    for (uint32_t got = 0; got < PRODUCERS * PUSHES;){
+        if (MLX90393_MpscPop(&merged, &out) != 0){
+            continue;
+        }
+        TEST_ASSERT_LESS_THAN(PRODUCERS, out.device);
+        TEST_ASSERT_EQUAL(next[out.device], out.sample.seq);
+        next[out.device]++;
+        got++;
+    }
+    for (int p = 0; p < PRODUCERS; p++){
+        pthread_join(threads[p], NULL);
+    }
+    TEST_ASSERT_EQUAL(MLX90393_AGAIN, MLX90393_MpscPop(&merged, &out));
+}
+
+void test_MLX90393_Array_DeliversEverySampleOnceFromEveryBus(void){
+    size_t bus, id;
+    mlx_array_item_t item;
+    mlx_sample_t sample;
+    uint32_t per_dev[BUSES * PER_BUS] = {0};
+    for (int b = 0; b < BUSES; b++){
+        TEST_ASSERT_EQUAL(0, MLX90393_ArrayAddBus(&array, MLX90393_SimClock, MLX90393_SimUdelay, MLX90393_ARRAY_ANY_CPU, &bus));
+        TEST_ASSERT_EQUAL(b, bus);
+        for (int d = 0; d < PER_BUS; d++){
+            TEST_ASSERT_EQUAL(0, MLX90393_ArrayAddDevice(&array, bus, &devs[b * PER_BUS + d], 0, &rings[b * PER_BUS + d], &id));
+            TEST_ASSERT_EQUAL(b * PER_BUS + d, id);
+        }
+    }
+    TEST_ASSERT_EQUAL(0, MLX90393_ArrayStart(&array, ROUNDS));
+    TEST_ASSERT_EQUAL(0, MLX90393_ArrayWait(&array));
+
+    while (MLX90393_MpscPop(&merged, &item) == 0){
+        TEST_ASSERT_EQUAL(per_dev[item.device], item.sample.seq);
+        TEST_ASSERT_FLOAT_WITHIN(0.2f, 10.0f * (float) item.device, item.sample.xyz[0]);
+        TEST_ASSERT_GREATER_OR_EQUAL(item.sample.t_expected_us, item.sample.t_done_us);
+        per_dev[item.device]++;
+    }
+    for (int i = 0; i < BUSES * PER_BUS; i++){
+        TEST_ASSERT_EQUAL(ROUNDS, per_dev[i]);
+        TEST_ASSERT_EQUAL(ROUNDS, MLX90393_RingCount(&rings[i]));
+        TEST_ASSERT_EQUAL(0, MLX90393_RingPop(&rings[i], &sample));
+        TEST_ASSERT_EQUAL(0, sample.seq);
+        TEST_ASSERT_EQUAL(0, atomic_load(&array.devs[i].dropped));
+    }
+}
+
+void test_MLX90393_ArrayStop_EndsUnboundedRun(void){
+    size_t bus;
+    MLX90393_ArrayAddBus(&array, MLX90393_SimClock, MLX90393_SimUdelay, 0, &bus);
+    MLX90393_ArrayAddDevice(&array, bus, &devs[0], 0, NULL, NULL);
+    TEST_ASSERT_EQUAL(0, MLX90393_ArrayStart(&array, 0));
+    TEST_ASSERT_EQUAL(1, MLX90393_ArrayStart(&array, 0)); //Already running
+    mlx_array_item_t item;
+    while (MLX90393_MpscPop(&merged, &item) != 0){
+        sched_yield();
+    }
+    TEST_ASSERT_EQUAL(0, MLX90393_ArrayStop(&array));
+    TEST_ASSERT_EQUAL(0, atomic_load(&array.running));
+}
+
+void test_MLX90393_ArrayStop_EndsBusWithUnresponsiveDevice(void){
+    size_t bus;
+    uint8_t status;
+    MLX90393_ArrayAddBus(&array, MLX90393_SimClock, MLX90393_SimUdelay, MLX90393_ARRAY_ANY_CPU, &bus);
+    MLX90393_ArrayAddDevice(&array, bus, &devs[0], 0, NULL, NULL);
+    MLX90393_ArrayAddDevice(&array, bus, &devs[1], 60000000, NULL, NULL); //Long idle waits
+    MLX90393_SWOC(&devs[0], MLX90393_MAG_XYZ, &status); //Rejects SM from now on
+    TEST_ASSERT_EQUAL(0, MLX90393_ArrayStart(&array, 0));
+    mlx_array_item_t item;
+    while (MLX90393_MpscPop(&merged, &item) != 0){ //devs[1] delivers in the first round
+        sched_yield();
+    }
+    TEST_ASSERT_EQUAL(1, item.device);
+    TEST_ASSERT_EQUAL(0, MLX90393_ArrayStop(&array));
+    TEST_ASSERT_GREATER_THAN(0, array.buses[bus].sched.slots[0].errors);
+    TEST_ASSERT_EQUAL(0, devs[0].pending);
+}
@@ -0,0 +1,126 @@
+#include <string.h>
+#include "unity.h"
+#include "MLX90393.h"
+#include "MLX90393_autorange.h"
+#include "MLX90393_sim.h"
+
+static mlx_i2c_t fake_mlx;
+static mlx_sim_t sim;
+static mlx_cfg_t settings;
+static mlx_autorange_t ar;
+
+void setUp(void) {
+    memset(&fake_mlx, 0, sizeof(fake_mlx));
+    MLX90393_SimInit(&sim);
+    MLX90393_SimAttach(&fake_mlx, &sim);
+    MLX90393_SimSetClock(0);
+    settings = (mlx_cfg_t) {
+        .gain = MLX90393_GAIN_1X,
+        .resolution_x = MLX90393_RES_16,
+        .resolution_y = MLX90393_RES_16,
+        .resolution_z = MLX90393_RES_16,
+        .filter = MLX90393_FILTER_1,
+        .oversampling = MLX90393_OSR_0
+    };
+    fake_mlx.settings = &settings;
+    MLX90393_ApplySettings(&fake_mlx, &settings);
+    MLX90393_AutorangeInit(&ar, &fake_mlx);
+}
+
+void tearDown(void) {
+}
+
+void test_MLX90393_AutorangeInit_TakesCurrentSettingsAsSensitiveEnd(void){
+    TEST_ASSERT_EQUAL(1, MLX90393_AutorangeInit(&ar, NULL));
+    TEST_ASSERT_EQUAL(MLX90393_GAIN_1X, ar.max_gain);
+    TEST_ASSERT_EQUAL(MLX90393_RES_16, ar.base_res[2]);
+    TEST_ASSERT_EQUAL(MLX90393_AUTORANGE_HIGH_PCT, ar.high_pct);
+}
+
+void test_MLX90393_AutorangeRead_KeepsRangeInsideDeadBand(void){
+    mlx_sample_t sample;
+    sim.field[2] = 5000.0f; //~52 % of full scale at GAIN_1X / RES_16
+    for (int i = 0; i < 10; i++){
+        TEST_ASSERT_EQUAL(0, MLX90393_AutorangeRead(&ar, &sample, NULL));
+    }
+    TEST_ASSERT_EQUAL(0, ar.switches);
+    TEST_ASSERT_FLOAT_WITHIN(0.3f, 5000.0f, sample.xyz[2]);
+}
+
+void test_MLX90393_AutorangeRead_StepsDownGainNearFullScaleAndTagsSample(void){
+    mlx_sample_t sample;
+    mlx_cfg_t used;
+    uint32_t transactions;
+    sim.field[2] = 9000.0f; //~93 %
+
+    transactions = sim.transactions;
+    TEST_ASSERT_EQUAL(0, MLX90393_AutorangeRead(&ar, &sample, &used));
+    //SM + RM, then a single WR of CONF1 (its shadow is valid, CONF3 unchanged)
+    TEST_ASSERT_EQUAL(4 + 2, sim.transactions - transactions);
+    TEST_ASSERT_EQUAL(MLX90393_GAIN_1X, used.gain);
+    TEST_ASSERT_EQUAL(MLX90393_GAIN_1_33X, fake_mlx.settings->gain);
+    TEST_ASSERT_EQUAL(1, ar.switches);
+    TEST_ASSERT_FLOAT_WITHIN(0.3f, 9000.0f, sample.xyz[2]);
+
+    uint32_t gen = sample.cfg_gen;
+    TEST_ASSERT_EQUAL(0, MLX90393_AutorangeRead(&ar, &sample, &used));
+    TEST_ASSERT_EQUAL(MLX90393_GAIN_1_33X, used.gain);
+    TEST_ASSERT_NOT_EQUAL(gen, sample.cfg_gen);
+    TEST_ASSERT_FLOAT_WITHIN(0.4f, 9000.0f, sample.xyz[2]);
+    TEST_ASSERT_EQUAL(1, ar.switches);
+}
+
+void test_MLX90393_AutorangeRead_RecoversFromSaturation(void){
+    mlx_sample_t sample;
+    mlx_cfg_t used;
+    sim.field[0] = -20000.0f;
+    for (int i = 0; i < 8; i++){
+        TEST_ASSERT_EQUAL(0, MLX90393_AutorangeRead(&ar, &sample, &used));
+    }
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, -20000.0f, sample.xyz[0]);
+    TEST_ASSERT_EQUAL(MLX90393_GAIN_5X, fake_mlx.settings->gain); //Only gain with 20 mT below 90 % on X
+}
+
+void test_MLX90393_AutorangeRead_StepsBackUpAfterHold(void){
+    mlx_sample_t sample;
+    sim.field[2] = 9000.0f;
+    MLX90393_AutorangeRead(&ar, &sample, NULL);
+    TEST_ASSERT_EQUAL(MLX90393_GAIN_1_33X, fake_mlx.settings->gain);
+
+    sim.field[2] = 1000.0f;
+    for (int i = 0; i < MLX90393_AUTORANGE_HOLD - 1; i++){
+        MLX90393_AutorangeRead(&ar, &sample, NULL);
+    }
+    TEST_ASSERT_EQUAL(MLX90393_GAIN_1_33X, fake_mlx.settings->gain);
+    MLX90393_AutorangeRead(&ar, &sample, NULL);
+    TEST_ASSERT_EQUAL(MLX90393_GAIN_1X, fake_mlx.settings->gain);
+
+    for (int i = 0; i < 2 * MLX90393_AUTORANGE_HOLD; i++){ //Never above the configured gain
+        MLX90393_AutorangeRead(&ar, &sample, NULL);
+    }
+    TEST_ASSERT_EQUAL(MLX90393_GAIN_1X, fake_mlx.settings->gain);
+    TEST_ASSERT_EQUAL(2, ar.switches);
+}
+
+void test_MLX90393_AutorangeRead_ExtendsWithResolution(void){
+    mlx_sample_t sample;
+    settings.gain = MLX90393_GAIN_5X;
+    MLX90393_ApplySettings(&fake_mlx, &settings);
+    MLX90393_AutorangeInit(&ar, &fake_mlx);
+    sim.field[2] = 45000.0f; //~96 % at GAIN_5X / RES_16 on Z
+
+    MLX90393_AutorangeRead(&ar, &sample, NULL);
+    TEST_ASSERT_EQUAL(0, ar.switches);
+
+    ar.use_resolution = 1;
+    MLX90393_AutorangeRead(&ar, &sample, NULL);
+    TEST_ASSERT_EQUAL(MLX90393_RES_17, fake_mlx.settings->resolution_z);
+    TEST_ASSERT_EQUAL(MLX90393_RES_17, fake_mlx.settings->resolution_x);
+
+    sim.field[2] = 100.0f;
+    for (int i = 0; i < MLX90393_AUTORANGE_HOLD; i++){
+        MLX90393_AutorangeRead(&ar, &sample, NULL);
+    }
+    TEST_ASSERT_EQUAL(MLX90393_RES_16, fake_mlx.settings->resolution_z);
+    TEST_ASSERT_EQUAL(MLX90393_GAIN_5X, fake_mlx.settings->gain);
+}
@@ -0,0 +1,158 @@
+#include <math.h>
+#include <string.h>
+#include "unity.h"
+#include "MLX90393.h"
+#include "MLX90393_calib.h"
+#include "MLX90393_sim.h"
+
+static mlx_calib_t cal;
+
+//Distortion of the simulated sensor: soft iron (symmetric) then hard iron
+static const float soft[3][3] = {{1.20f, 0.10f, 0.00f}, {0.10f, 0.90f, -0.05f}, {0.00f, -0.05f, 1.05f}};
+static const float hard[3] = {30.0f, -12.0f, 7.5f};
+
+static void distort(const float *b, float *xyz){
+    for (int r = 0; r < 3; r++){
+        xyz[r] = soft[r][0] * b[0] + soft[r][1] * b[1] + soft[r][2] * b[2] + hard[r];
+    }
+}
+
+//Earth field of 50 uT seen from orientation i of a spiral over the sphere
+static void orientation(int i, int n, float *b){
+    float zc = 1.0f - 2.0f * ((float) i + 0.5f) / (float) n;
+    float r = sqrtf(1.0f - zc * zc);
+    float phi = 2.3999632f * (float) i; //Golden angle
+    b[0] = 50.0f * r * cosf(phi);
+    b[1] = 50.0f * r * sinf(phi);
+    b[2] = 50.0f * zc;
+}
+
+static float magnitude(const float *xyz){
+    return sqrtf(xyz[0] * xyz[0] + xyz[1] * xyz[1] + xyz[2] * xyz[2]);
+}
+
+void setUp(void) {
+    MLX90393_CalibInit(&cal);
+}
+
+void tearDown(void) {
+}
+
+void test_MLX90393_CalibInit_StartsWithIdentity(void){
+    float xyz[3] = {1.0f, -2.0f, 3.0f};
+    TEST_ASSERT_EQUAL(1, MLX90393_CalibInit(NULL));
+    TEST_ASSERT_EQUAL(0, MLX90393_CalibApply(&cal, xyz));
+    TEST_ASSERT_EQUAL_FLOAT(-2.0f, xyz[1]);
+    TEST_ASSERT_EQUAL(MLX90393_AGAIN, MLX90393_CalibSolve(&cal));
+}
+
+void test_MLX90393_CalibSolve_RecoversHardAndSoftIron(void){
+    float xyz[3], b[3];
+    for (int i = 0; i < 200; i++){
+        orientation(i, 200, b);
+        distort(b, xyz);
+        TEST_ASSERT_EQUAL(0, MLX90393_CalibAdd(&cal, xyz));
+    }
+    TEST_ASSERT_EQUAL(0, MLX90393_CalibSolve(&cal));
+    TEST_ASSERT_EQUAL(1, cal.valid);
+    for (int axis = 0; axis < 3; axis++){
+        TEST_ASSERT_FLOAT_WITHIN(0.01f, hard[axis], cal.offset[axis]);
+    }
+    //Every corrected sample lies on one sphere, including orientations not used by the fit
+    for (int i = 0; i < 37; i++){
+        orientation(i, 37, b);
+        distort(b, xyz);
+        MLX90393_CalibApply(&cal, xyz);
+        TEST_ASSERT_FLOAT_WITHIN(0.01f, cal.field_uT, magnitude(xyz));
+    }
+    TEST_ASSERT_FLOAT_WITHIN(3.0f, 50.0f, cal.field_uT);
+}
+
+void test_MLX90393_CalibSolve_NeedsSeveralOrientations(void){
+    float xyz[3], b[3];
+    for (int i = 0; i < 100; i++){ //Rotation about Z only: the Z terms stay undetermined
+        float phi = 0.0628f * (float) i;
+        b[0] = 40.0f * cosf(phi);
+        b[1] = 40.0f * sinf(phi);
+        b[2] = 30.0f;
+        distort(b, xyz);
+        MLX90393_CalibAdd(&cal, xyz);
+    }
+    TEST_ASSERT_NOT_EQUAL(0, MLX90393_CalibSolve(&cal));
+    TEST_ASSERT_EQUAL(0, cal.valid);
+}
+
+void test_MLX90393_CalibConvertBatch_MatchesDecodeThenApply(void){
+    mlx_cfg_t cfg = {
+        .gain = MLX90393_GAIN_1X, .resolution_x = MLX90393_RES_16, .resolution_y = MLX90393_RES_18,
+        .resolution_z = MLX90393_RES_19
+    };
+    uint8_t frames[3][8] = {
+        {0x67, 0x40, 0x01, 0x20, 0x80, 0x40, 0x40, 0x10}, //T, X, Y, Z
+        {0x67, 0x40, 0xFF, 0x00, 0x7F, 0x00, 0x3F, 0x00},
+        {0x67, 0x40, 0x00, 0x00, 0x80, 0x00, 0x40, 0x00},
+    };
+    float x[3], y[3], z[3], ref[3][3];
+    cal.offset[0] = 5.0f;
+    cal.offset[2] = -3.0f;
+    cal.matrix[0][1] = 0.2f;
+    cal.matrix[2][2] = 0.8f;
+    MLX90393_convertBatch(&cfg, 0, MLX90393_MAG_XYZ | MLX90393_TEMP, frames[0], 3, ref[0], ref[1], ref[2], NULL);
+
+    TEST_ASSERT_EQUAL(1, MLX90393_CalibConvertBatch(&cal, &cfg, 0, MLX90393_MAG_Z, frames[0], 3, x, y, z));
+    TEST_ASSERT_EQUAL(0, MLX90393_CalibConvertBatch(&cal, &cfg, 0, MLX90393_MAG_XYZ | MLX90393_TEMP, frames[0], 3, x, y, z));
+    for (int i = 0; i < 3; i++){
+        float xyz[3] = {ref[0][i], ref[1][i], ref[2][i]};
+        MLX90393_CalibApply(&cal, xyz);
+        TEST_ASSERT_FLOAT_WITHIN(1e-3f, xyz[0], x[i]);
+        TEST_ASSERT_FLOAT_WITHIN(1e-3f, xyz[1], y[i]);
+        TEST_ASSERT_FLOAT_WITHIN(1e-3f, xyz[2], z[i]);
+    }
+}
+
+void test_MLX90393_CalibStore_MovesOffsetToDevice(void){
+    mlx_i2c_t dev;
+    mlx_sim_t sim;
+    mlx_cfg_t settings = {
+        .gain = MLX90393_GAIN_1X, .resolution_x = MLX90393_RES_16, .resolution_y = MLX90393_RES_16,
+        .resolution_z = MLX90393_RES_16, .filter = MLX90393_FILTER_2, .oversampling = MLX90393_OSR_1
+    };
+    mlx_cfg_ext_t ext;
+    mlx_sample_t sample;
+    float b[3];
+    memset(&dev, 0, sizeof(dev));
+    MLX90393_SimInit(&sim);
+    MLX90393_SimAttach(&dev, &sim);
+    dev.settings = &settings;
+    MLX90393_ApplySettings(&dev, &settings);
+
+    //Fit from live samples
+    for (int i = 0; i < 100; i++){
+        orientation(i, 100, b);
+        distort(b, sim.field);
+        TEST_ASSERT_EQUAL(0, MLX90393_readMeasurement(&dev, MLX90393_MAG_XYZ, &sample));
+        MLX90393_CalibAdd(&cal, sample.xyz);
+    }
+    TEST_ASSERT_EQUAL(0, MLX90393_CalibSolve(&cal));
+    TEST_ASSERT_FLOAT_WITHIN(0.3f, hard[0], cal.offset[0]);
+
+    TEST_ASSERT_EQUAL(MLX90393_MISMATCH, MLX90393_CalibStore(&cal, &dev)); //TCMP_EN off
+    MLX90393_GetConfig(&dev, &ext);
+    ext.tcmp_en = 1;
+    MLX90393_ApplyConfig(&dev, &ext);
+    TEST_ASSERT_EQUAL(0, MLX90393_CalibStore(&cal, &dev));
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, cal.offset[1]);
+    TEST_ASSERT_EQUAL(0, cal.samples); //Fit restarts in the new offset frame
+    TEST_ASSERT_EQUAL(MLX90393_AGAIN, MLX90393_CalibSolve(&cal));
+    TEST_ASSERT_EQUAL(1, cal.valid);
+    TEST_ASSERT_EQUAL_HEX16(sim.regs[MLX90393_REG_OFFSET_Y], sim.nvram[MLX90393_REG_OFFSET_Y]);
+    TEST_ASSERT_INT_WITHIN(2, (int16_t) lrintf(hard[1] / MLX90393_GetSensitivity(&settings, 1)),
+                           (int16_t) sim.nvram[MLX90393_REG_OFFSET_Y]);
+
+    //The device now removes the hard iron; the host only applies the matrix
+    orientation(5, 100, b);
+    distort(b, sim.field);
+    TEST_ASSERT_EQUAL(0, MLX90393_readMeasurement(&dev, MLX90393_MAG_XYZ, &sample));
+    MLX90393_CalibApply(&cal, sample.xyz);
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, cal.field_uT, magnitude(sample.xyz));
+}
@@ -300,3 +300,47 @@ void test_MLX90393_NOP_SunnyDay(void){ //Everything works correctly
 
 
 
+//Combined transfer hook: one transaction per command, write/read hooks untouched
+
+static int32_t cb_transfer_rr(mlx_i2c_t *dev, uint8_t *wbuf, size_t wlen, uint8_t *rbuf, size_t rlen, int n){
+    TEST_ASSERT_EQUAL(2, wlen);
+    TEST_ASSERT_EQUAL_HEX8(0x50, wbuf[0]);
+    TEST_ASSERT_EQUAL_HEX8(MLX90393_REG_CONF3 << 2, wbuf[1]);
+    TEST_ASSERT_EQUAL(3, rlen);
+    rbuf[0] = 0x00;
+    rbuf[1] = 0x12;
+    rbuf[2] = 0x34;
+    return 0;
+}
+
+void test_MLX90393_Commands_UseTransferWhenProvided(void){
+    uint8_t status;
+    uint8_t data[6];
+    fake_mlx_ptr->transfer = transfer_function;
+
+    transfer_function_ExpectAnyArgsAndReturn(0);
+    transfer_function_ExpectAnyArgsAndReturn(0);
+    transfer_function_ExpectAnyArgsAndReturn(0);
+    TEST_ASSERT_EQUAL(0, MLX90393_SM(fake_mlx_ptr, 0x0E, &status));
+    TEST_ASSERT_EQUAL(0, MLX90393_RM(fake_mlx_ptr, 0x0E, &status, data));
+    TEST_ASSERT_EQUAL(0, MLX90393_WR(fake_mlx_ptr, &status, 0, 1));
+}
+
+void test_MLX90393_RR_ThroughTransferReturnsRegisterData(void){
+    uint8_t status;
+    uint8_t data[2];
+    fake_mlx_ptr->transfer = transfer_function;
+
+    transfer_function_Stub(cb_transfer_rr);
+    TEST_ASSERT_EQUAL(0, MLX90393_RR(fake_mlx_ptr, &status, MLX90393_REG_CONF3, data));
+    TEST_ASSERT_EQUAL_HEX8(0x12, data[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x34, data[1]);
+}
+
+void test_MLX90393_Commands_ReturnTransferFailure(void){
+    uint8_t status;
+    fake_mlx_ptr->transfer = transfer_function;
+
+    transfer_function_ExpectAnyArgsAndReturn(5);
+    TEST_ASSERT_EQUAL(5, MLX90393_NOP(fake_mlx_ptr, &status));
+}
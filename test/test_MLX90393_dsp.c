@@ -0,0 +1,145 @@
+#include <math.h>
+#include <string.h>
+#include "unity.h"
+#include "MLX90393.h"
+#include "MLX90393_dsp.h"
+
+#define N 512
+
+static mlx_dsp_t dsp;
+static float window[16];
+static float in[N];
+static float out[N];
+static size_t n_out;
+
+static void fill_sine(float *buf, size_t n, float amp, float cycles_per_sample, float dc){
+    for (size_t i = 0; i < n; i++){
+        buf[i] = dc + amp * sinf(6.2831853f * cycles_per_sample * (float) i);
+    }
+}
+
+static float rms(const float *buf, size_t from, size_t to, float mean){
+    double acc = 0;
+    for (size_t i = from; i < to; i++){
+        acc += ((double) buf[i] - mean) * ((double) buf[i] - mean);
+    }
+    return (float) sqrt(acc / (double) (to - from));
+}
+
+void setUp(void) {
+    memset(&dsp, 0, sizeof(dsp));
+}
+
+void tearDown(void) {
+}
+
+void test_MLX90393_DspSetup_RejectsInvalidArguments(void){
+    TEST_ASSERT_EQUAL(1, MLX90393_DspMovingAverage(NULL, window, 16, 1));
+    TEST_ASSERT_EQUAL(1, MLX90393_DspMovingAverage(&dsp, NULL, 16, 1));
+    TEST_ASSERT_EQUAL(1, MLX90393_DspMovingAverage(&dsp, window, 16, 0));
+    TEST_ASSERT_EQUAL(1, MLX90393_DspButterworth(&dsp, 3, 10.0f, 100.0f, 1));
+    TEST_ASSERT_EQUAL(1, MLX90393_DspButterworth(&dsp, 10, 10.0f, 100.0f, 1));
+    TEST_ASSERT_EQUAL(1, MLX90393_DspButterworth(&dsp, 2, 60.0f, 100.0f, 1));
+    TEST_ASSERT_EQUAL(1, MLX90393_DspCIC(&dsp, 6, 8, 0));
+    TEST_ASSERT_EQUAL(1, MLX90393_DspCIC(&dsp, 5, 128, 0)); //128^5 = 2^35
+    TEST_ASSERT_EQUAL(1, MLX90393_DspRun(&dsp, in, out, N, &n_out)); //Never set up
+}
+
+void test_MLX90393_DspMovingAverage_AveragesAndDecimates(void){
+    TEST_ASSERT_EQUAL(0, MLX90393_DspMovingAverage(&dsp, window, 4, 4));
+    for (int i = 0; i < 12; i++){
+        in[i] = (float) i;
+    }
+    TEST_ASSERT_EQUAL(0, MLX90393_DspRun(&dsp, in, out, 12, &n_out));
+    TEST_ASSERT_EQUAL(3, n_out);
+    TEST_ASSERT_EQUAL_FLOAT(1.5f, out[0]);
+    TEST_ASSERT_EQUAL_FLOAT(5.5f, out[1]);
+    TEST_ASSERT_EQUAL_FLOAT(9.5f, out[2]);
+}
+
+void test_MLX90393_DspMovingAverage_WarmsUpWithPartialWindow(void){
+    MLX90393_DspMovingAverage(&dsp, window, 16, 1);
+    in[0] = 10.0f;
+    in[1] = 20.0f;
+    MLX90393_DspRun(&dsp, in, out, 2, &n_out);
+    TEST_ASSERT_EQUAL(2, n_out);
+    TEST_ASSERT_EQUAL_FLOAT(10.0f, out[0]);
+    TEST_ASSERT_EQUAL_FLOAT(15.0f, out[1]);
+}
+
+void test_MLX90393_DspRun_BlockSplitDoesNotChangeOutput(void){
+    static float ref[N];
+    size_t n_ref, n_a, n_b;
+    fill_sine(in, N, 50.0f, 0.013f, 20.0f);
+
+    MLX90393_DspButterworth(&dsp, 4, 5.0f, 100.0f, 3);
+    MLX90393_DspRun(&dsp, in, ref, N, &n_ref);
+    MLX90393_DspReset(&dsp);
+    MLX90393_DspRun(&dsp, in, out, 100, &n_a);
+    MLX90393_DspRun(&dsp, in + 100, out + n_a, N - 100, &n_b);
+    TEST_ASSERT_EQUAL(N / 3, n_ref);
+    TEST_ASSERT_EQUAL(n_ref, n_a + n_b);
+    TEST_ASSERT_EQUAL_MEMORY(ref, out, n_ref * sizeof(float));
+
+    MLX90393_DspCIC(&dsp, 3, 8, 0);
+    MLX90393_DspRun(&dsp, in, ref, N, &n_ref);
+    MLX90393_DspReset(&dsp);
+    MLX90393_DspRun(&dsp, in, out, 77, &n_a);
+    MLX90393_DspRun(&dsp, in + 77, out + n_a, N - 77, &n_b);
+    TEST_ASSERT_EQUAL(N / 8, n_ref);
+    TEST_ASSERT_EQUAL(n_ref, n_a + n_b);
+    TEST_ASSERT_EQUAL_MEMORY(ref, out, n_ref * sizeof(float));
+}
+
+void test_MLX90393_DspButterworth_PassesDcAndStopsHighFrequencies(void){
+    MLX90393_DspButterworth(&dsp, 4, 5.0f, 100.0f, 1);
+    fill_sine(in, N, 0.0f, 0.0f, -42.0f);
+    MLX90393_DspRun(&dsp, in, out, N, &n_out);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, -42.0f, out[N - 1]);
+
+    MLX90393_DspReset(&dsp);
+    fill_sine(in, N, 10.0f, 0.25f, 0.0f); //25 Hz, 2.3 octaves above fc: -55 dB for 4th order
+    MLX90393_DspRun(&dsp, in, out, N, &n_out);
+    TEST_ASSERT_LESS_THAN(0.03f, rms(out, N / 2, N, 0.0f));
+
+    MLX90393_DspReset(&dsp);
+    fill_sine(in, N, 10.0f, 0.05f, 0.0f); //At fc: -3 dB
+    MLX90393_DspRun(&dsp, in, out, N, &n_out);
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 10.0f / sqrtf(2.0f) / sqrtf(2.0f), rms(out, N / 2, N, 0.0f));
+}
+
+void test_MLX90393_DspCIC_HasUnityDcGainAndReducesNoise(void){
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < N; i++){
+        seed = seed * 1664525u + 1013904223u;
+        in[i] = 100.0f + ((float) (seed >> 8) / 16777216.0f - 0.5f) * 4.0f; //Uniform noise, 1.15 uT rms
+    }
+    TEST_ASSERT_EQUAL(0, MLX90393_DspCIC(&dsp, 2, 16, 0));
+    MLX90393_DspRun(&dsp, in, out, N, &n_out);
+    TEST_ASSERT_EQUAL(N / 16, n_out);
+    //Sinc^2 over 16 samples: noise down by ~sqrt(11.3)
+    TEST_ASSERT_FLOAT_WITHIN(0.2f, 100.0f, out[n_out - 1]);
+    TEST_ASSERT_LESS_THAN(0.45f, rms(out, 2, n_out, 100.0f));
+}
+
+void test_MLX90393_DspRunXYZ_FiltersDecodedBatchInPlace(void){
+    mlx_dsp_t xyz[3];
+    static float win[3][4];
+    float x[8], y[8], z[8];
+    for (int axis = 0; axis < 3; axis++){
+        MLX90393_DspMovingAverage(&xyz[axis], win[axis], 4, 4);
+    }
+    for (int i = 0; i < 8; i++){
+        x[i] = 1.0f;
+        y[i] = (float) i;
+        z[i] = -2.0f;
+    }
+    TEST_ASSERT_EQUAL(0, MLX90393_DspRunXYZ(xyz, x, y, z, 8, &n_out));
+    TEST_ASSERT_EQUAL(2, n_out);
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, x[1]);
+    TEST_ASSERT_EQUAL_FLOAT(5.5f, y[1]);
+    TEST_ASSERT_EQUAL_FLOAT(-2.0f, z[0]);
+
+    MLX90393_DspMovingAverage(&xyz[1], win[1], 4, 2);
+    TEST_ASSERT_EQUAL(MLX90393_MISMATCH, MLX90393_DspRunXYZ(xyz, x, y, NULL, 8, &n_out));
+}
@@ -0,0 +1,193 @@
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include "unity.h"
+#include "MLX90393.h"
+#include "MLX90393_cmds.h"
+#include "MLX90393_linux.h"
+#include "mock_test_MLX90393_linux.h"
+
+#define FAKE_FD 7
+
+static mlx_i2c_t fake_mlx;
+static mlx_linux_t fake_link;
+static struct i2c_msg seen[MLX90393_LINUX_MAX_MSGS];
+static uint8_t seen_wbuf[MLX90393_LINUX_MAX_MSGS];
+static uint32_t seen_nmsgs;
+
+//Fake i2c-dev: records the messages and answers every read with status 0x00 and bytes addr, 1, 2, ...
+static int cb_ioctl(int fd, unsigned long request, void *arg, int n){
+    struct i2c_rdwr_ioctl_data *rdwr = (struct i2c_rdwr_ioctl_data *) arg;
+    TEST_ASSERT_EQUAL(FAKE_FD, fd);
+    TEST_ASSERT_EQUAL(I2C_RDWR, request);
+    seen_nmsgs = rdwr->nmsgs;
+    for (uint32_t i = 0; i < rdwr->nmsgs; i++){
+        struct i2c_msg *m = &rdwr->msgs[i];
+        seen[i] = *m;
+        if (m->flags & I2C_M_RD){
+            m->buf[0] = 0x00;
+            for (int j = 1; j < m->len; j++){
+                m->buf[j] = (uint8_t) (m->addr + j - 1);
+            }
+        } else {
+            seen_wbuf[i] = m->buf[0];
+        }
+    }
+    return (int) rdwr->nmsgs;
+}
+
+static int cb_ioctl_remote_io(int fd, unsigned long request, void *arg, int n){
+    errno = EREMOTEIO;
+    return -1;
+}
+
+static int cb_ioctl_short(int fd, unsigned long request, void *arg, int n){
+    return 1;
+}
+
+static int cb_open(const char *path, int flags, int n){
+    TEST_ASSERT_EQUAL_STRING("/dev/i2c-1", path);
+    TEST_ASSERT_EQUAL(O_RDWR, flags & O_ACCMODE);
+    return FAKE_FD;
+}
+
+static int cb_open_missing(const char *path, int flags, int n){
+    errno = ENOENT;
+    return -1;
+}
+
+void setUp(void) {
+    memset(&fake_mlx, 0, sizeof(fake_mlx));
+    memset(seen, 0, sizeof(seen));
+    seen_nmsgs = 0;
+    TEST_ASSERT_EQUAL(0, MLX90393_LinuxAttach(&fake_mlx, &fake_link, FAKE_FD, MLX90393_I2C_ADDR));
+}
+
+void tearDown(void) {
+}
+
+void test_MLX90393_LINUX_OpenUsesAdapterPath(void){
+    int fd = -1;
+    mlx_sys_open_Stub(cb_open);
+    TEST_ASSERT_EQUAL(0, MLX90393_LinuxOpen(1, &fd));
+    TEST_ASSERT_EQUAL(FAKE_FD, fd);
+    TEST_ASSERT_EQUAL(1, MLX90393_LinuxOpen(1, NULL));
+}
+
+void test_MLX90393_LINUX_OpenAndCloseReturnErrno(void){
+    int fd = -1;
+    mlx_sys_open_Stub(cb_open_missing);
+    TEST_ASSERT_EQUAL(-ENOENT, MLX90393_LinuxOpen(3, &fd));
+    TEST_ASSERT_EQUAL(-1, fd);
+
+    mlx_sys_close_ExpectAndReturn(FAKE_FD, 0);
+    TEST_ASSERT_EQUAL(0, MLX90393_LinuxClose(FAKE_FD));
+}
+
+void test_MLX90393_LINUX_AttachInstallsHooks(void){
+    TEST_ASSERT_EQUAL_PTR(&fake_link, fake_mlx.handle);
+    TEST_ASSERT_EQUAL_PTR(MLX90393_LinuxWrite, fake_mlx.write_function);
+    TEST_ASSERT_EQUAL_PTR(MLX90393_LinuxRead, fake_mlx.read_function);
+    TEST_ASSERT_EQUAL_PTR(MLX90393_LinuxTransfer, fake_mlx.transfer);
+    TEST_ASSERT_EQUAL(1, MLX90393_LinuxAttach(&fake_mlx, NULL, FAKE_FD, MLX90393_I2C_ADDR));
+    TEST_ASSERT_EQUAL(1, MLX90393_LinuxAttach(&fake_mlx, &fake_link, -1, MLX90393_I2C_ADDR));
+}
+
+void test_MLX90393_LINUX_CommandIsOneIoctl(void){
+    uint8_t status = 0xFF;
+    uint8_t data[6];
+    mlx_sys_ioctl_Stub(cb_ioctl);
+
+    TEST_ASSERT_EQUAL(0, MLX90393_RM(&fake_mlx, MLX90393_MAG_XYZ, &status, data));
+
+    TEST_ASSERT_EQUAL(2, seen_nmsgs);
+    TEST_ASSERT_EQUAL_HEX16(MLX90393_I2C_ADDR, seen[0].addr);
+    TEST_ASSERT_EQUAL(0, seen[0].flags);
+    TEST_ASSERT_EQUAL(1, seen[0].len);
+    TEST_ASSERT_EQUAL_HEX8(0x4E, seen_wbuf[0]);
+    TEST_ASSERT_EQUAL(I2C_M_RD, seen[1].flags);
+    TEST_ASSERT_EQUAL(7, seen[1].len);
+    TEST_ASSERT_EQUAL_HEX8(0x00, status);
+    TEST_ASSERT_EQUAL_HEX8(MLX90393_I2C_ADDR, data[0]);
+    TEST_ASSERT_EQUAL_HEX8(MLX90393_I2C_ADDR + 5, data[5]);
+}
+
+void test_MLX90393_LINUX_WriteAndReadHooksUseSingleMessages(void){
+    uint8_t cmd = 0x80;
+    uint8_t status;
+    mlx_sys_ioctl_Stub(cb_ioctl);
+
+    TEST_ASSERT_EQUAL(0, MLX90393_LinuxWrite(&fake_mlx, &cmd, 1));
+    TEST_ASSERT_EQUAL(1, seen_nmsgs);
+    TEST_ASSERT_EQUAL(0, seen[0].flags);
+
+    TEST_ASSERT_EQUAL(0, MLX90393_LinuxRead(&fake_mlx, &status, 1));
+    TEST_ASSERT_EQUAL(1, seen_nmsgs);
+    TEST_ASSERT_EQUAL(I2C_M_RD, seen[0].flags);
+}
+
+void test_MLX90393_LINUX_IoctlFailuresAreReported(void){
+    uint8_t status;
+    uint8_t data[6];
+    mlx_sys_ioctl_Stub(cb_ioctl_remote_io);
+    TEST_ASSERT_EQUAL(-EREMOTEIO, MLX90393_RM(&fake_mlx, MLX90393_MAG_XYZ, &status, data));
+
+    mlx_sys_ioctl_Stub(cb_ioctl_short);
+    TEST_ASSERT_EQUAL(-EIO, MLX90393_RM(&fake_mlx, MLX90393_MAG_XYZ, &status, data));
+}
+
+void test_MLX90393_LINUX_BatchRejectsInvalidTransactions(void){
+    uint8_t cmd = 0x80;
+    mlx_linux_xfer_t xfers[MLX90393_LINUX_MAX_MSGS + 1];
+    for (int i = 0; i < MLX90393_LINUX_MAX_MSGS + 1; i++){
+        xfers[i] = (mlx_linux_xfer_t) { .addr = MLX90393_I2C_ADDR, .wbuf = &cmd, .wlen = 1 };
+    }
+    TEST_ASSERT_EQUAL(1, MLX90393_LinuxBatch(FAKE_FD, xfers, 0));
+    TEST_ASSERT_EQUAL(1, MLX90393_LinuxBatch(FAKE_FD, xfers, MLX90393_LINUX_MAX_MSGS + 1));
+    xfers[0].wlen = 0;
+    TEST_ASSERT_EQUAL(1, MLX90393_LinuxBatch(FAKE_FD, xfers, 1));
+    TEST_ASSERT_EQUAL(1, MLX90393_LinuxTransfer(NULL, &cmd, 1, NULL, 0));
+}
+
+void test_MLX90393_LINUX_ReadMeasurementsBatchesAllDevicesInOneIoctl(void){
+    mlx_i2c_t devs[3];
+    mlx_linux_t links[3];
+    mlx_i2c_t *list[3];
+    uint8_t status[3];
+    uint8_t data[3 * 6];
+    memset(devs, 0, sizeof(devs));
+    for (int i = 0; i < 3; i++){
+        TEST_ASSERT_EQUAL(0, MLX90393_LinuxAttach(&devs[i], &links[i], FAKE_FD, 0x0C + i));
+        list[i] = &devs[i];
+    }
+    mlx_sys_ioctl_Stub(cb_ioctl);
+
+    TEST_ASSERT_EQUAL(0, MLX90393_LinuxReadMeasurements(list, 3, MLX90393_MAG_XYZ, status, data));
+
+    TEST_ASSERT_EQUAL(6, seen_nmsgs);
+    for (int i = 0; i < 3; i++){
+        TEST_ASSERT_EQUAL_HEX16(0x0C + i, seen[2 * i].addr);
+        TEST_ASSERT_EQUAL_HEX8(0x4E, seen_wbuf[2 * i]);
+        TEST_ASSERT_EQUAL(I2C_M_RD, seen[2 * i + 1].flags);
+        TEST_ASSERT_EQUAL_HEX8(0x00, status[i]);
+        TEST_ASSERT_EQUAL_HEX8(0x0C + i, data[6 * i]);
+        TEST_ASSERT_EQUAL_HEX8(0x0C + i + 5, data[6 * i + 5]);
+    }
+}
+
+void test_MLX90393_LINUX_ReadMeasurementsRequiresOneBus(void){
+    mlx_i2c_t devs[2];
+    mlx_linux_t links[2];
+    mlx_i2c_t *list[2] = {&devs[0], &devs[1]};
+    uint8_t status[2];
+    uint8_t data[2 * 8];
+    memset(devs, 0, sizeof(devs));
+    MLX90393_LinuxAttach(&devs[0], &links[0], FAKE_FD, 0x0C);
+    MLX90393_LinuxAttach(&devs[1], &links[1], FAKE_FD + 1, 0x0D);
+
+    TEST_ASSERT_EQUAL(1, MLX90393_LinuxReadMeasurements(list, 2, MLX90393_MAG_XYZT, status, data));
+    TEST_ASSERT_EQUAL(1, MLX90393_LinuxReadMeasurements(list, MLX90393_LINUX_MAX_BATCH + 1, MLX90393_MAG_XYZT, status, data));
+    TEST_ASSERT_EQUAL(1, MLX90393_LinuxReadMeasurements(list, 2, MLX90393_MAG_XYZT, NULL, data));
+}
@@ -0,0 +1,191 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "unity.h"
+#include "MLX90393.h"
+#include "MLX90393_cmds.h"
+#include "MLX90393_log.h"
+#include "MLX90393_sim.h"
+
+static char path[] = "/tmp/mlx90393_log_XXXXXX";
+static mlx_log_writer_t writer;
+static mlx_log_reader_t reader;
+static const mlx_cfg_t cfg_a = {
+    .gain = MLX90393_GAIN_1X, .resolution_x = MLX90393_RES_16, .resolution_y = MLX90393_RES_17,
+    .resolution_z = MLX90393_RES_18, .filter = MLX90393_FILTER_1, .oversampling = MLX90393_OSR_0
+};
+static const mlx_cfg_t cfg_b = {
+    .gain = MLX90393_GAIN_5X, .resolution_x = MLX90393_RES_19, .resolution_y = MLX90393_RES_19,
+    .resolution_z = MLX90393_RES_19, .filter = MLX90393_FILTER_3, .oversampling = MLX90393_OSR_2
+};
+
+static void frame_xyz(uint8_t *data, uint16_t x, uint16_t y, uint16_t z){
+    data[0] = x >> 8; data[1] = x & 0xFF;
+    data[2] = y >> 8; data[3] = y & 0xFF;
+    data[4] = z >> 8; data[5] = z & 0xFF;
+}
+
+static long file_size(void){
+    FILE *fp = fopen(path, "rb");
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fclose(fp);
+    return size;
+}
+
+void setUp(void) {
+    strcpy(path, "/tmp/mlx90393_log_XXXXXX");
+    close(mkstemp(path));
+    memset(&reader, 0, sizeof(reader));
+}
+
+void tearDown(void) {
+    if (reader.map != NULL){
+        MLX90393_LogUnmap(&reader);
+    }
+    unlink(path);
+}
+
+void test_MLX90393_LogFrame_NeedsConfig(void){
+    uint8_t data[6] = {0};
+    TEST_ASSERT_EQUAL(0, MLX90393_LogOpen(&writer, path));
+    TEST_ASSERT_EQUAL(MLX90393_MISMATCH, MLX90393_LogFrame(&writer, data, 0));
+    TEST_ASSERT_EQUAL(1, MLX90393_LogConfig(&writer, &cfg_a, 0, 0, 0));
+    TEST_ASSERT_EQUAL(0, MLX90393_LogClose(&writer));
+    TEST_ASSERT_EQUAL(1, MLX90393_LogClose(&writer));
+}
+
+void test_MLX90393_Log_StoresSixBytesPerXYZSample(void){
+    uint8_t data[6];
+    MLX90393_LogOpen(&writer, path);
+    MLX90393_LogConfig(&writer, &cfg_a, 0, MLX90393_MAG_XYZ, 1);
+    for (int i = 0; i < 1000; i++){
+        frame_xyz(data, (uint16_t) i, (uint16_t) -i, 0x8000);
+        TEST_ASSERT_EQUAL(0, MLX90393_LogFrame(&writer, data, 1000u * i));
+    }
+    TEST_ASSERT_EQUAL(0, MLX90393_LogClose(&writer));
+    //Header + CONFIG + 4 FRAMES records
+    TEST_ASSERT_EQUAL(8 + 13 + 4 * 19 + 1000 * 6, file_size());
+}
+
+void test_MLX90393_LogNext_DecodesLikeTheDriver(void){
+    uint8_t data[6];
+    mlx_sample_t sample, expected;
+    MLX90393_LogOpen(&writer, path);
+    MLX90393_LogConfig(&writer, &cfg_a, 0, MLX90393_MAG_XYZ, 7);
+    for (int i = 0; i < 300; i++){
+        frame_xyz(data, (uint16_t) (i * 10), (uint16_t) -i, (uint16_t) (0x8000 + i));
+        MLX90393_LogFrame(&writer, data, 500 + 1000u * i);
+    }
+    MLX90393_LogConfig(&writer, &cfg_b, 0, MLX90393_MAG_XYZ, 8);
+    frame_xyz(data, 0x4100, 0x3F00, 0x4000);
+    MLX90393_LogFrame(&writer, data, 999999);
+    MLX90393_LogClose(&writer);
+
+    TEST_ASSERT_EQUAL(0, MLX90393_LogMap(&reader, path));
+    for (int i = 0; i < 300; i++){
+        TEST_ASSERT_EQUAL(0, MLX90393_LogNext(&reader, &sample));
+        frame_xyz(data, (uint16_t) (i * 10), (uint16_t) -i, (uint16_t) (0x8000 + i));
+        MLX90393_convert(&cfg_a, 0, MLX90393_MAG_XYZ, data, &expected);
+        TEST_ASSERT_EQUAL_FLOAT_ARRAY(expected.xyz, sample.xyz, 3);
+        TEST_ASSERT_EQUAL(i, sample.seq);
+        TEST_ASSERT_EQUAL(7, sample.cfg_gen);
+        TEST_ASSERT_EQUAL(500 + 1000u * i, sample.t_done_us);
+    }
+    TEST_ASSERT_EQUAL(0, MLX90393_LogNext(&reader, &sample));
+    TEST_ASSERT_EQUAL(8, sample.cfg_gen);
+    TEST_ASSERT_EQUAL(MLX90393_GAIN_5X, reader.cfg.gain);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 256 * MLX90393_GetSensitivity(&cfg_b, 0), sample.xyz[0]);
+    TEST_ASSERT_EQUAL(MLX90393_AGAIN, MLX90393_LogNext(&reader, &sample));
+}
+
+void test_MLX90393_LogNextBlock_FeedsConvertBatch(void){
+    uint8_t data[8] = {0x12, 0x34};
+    const uint8_t *frames;
+    size_t n;
+    float x[MLX90393_LOG_BLOCK], t[MLX90393_LOG_BLOCK];
+    MLX90393_LogOpen(&writer, path);
+    MLX90393_LogConfig(&writer, &cfg_a, 0, 0x03, 0); //X and T
+    for (int i = 0; i < 10; i++){
+        data[2] = 0;
+        data[3] = (uint8_t) i;
+        MLX90393_LogFrame(&writer, data, i);
+    }
+    MLX90393_LogClose(&writer);
+
+    MLX90393_LogMap(&reader, path);
+    TEST_ASSERT_EQUAL(0, MLX90393_LogNextBlock(&reader, &frames, &n));
+    TEST_ASSERT_EQUAL(10, n);
+    TEST_ASSERT_EQUAL(0, MLX90393_convertBatch(&reader.cfg, reader.tcmp_en, reader.zyxt, frames, n, x, NULL, NULL, t));
+    TEST_ASSERT_EQUAL_FLOAT(9 * MLX90393_GetSensitivity(&cfg_a, 0), x[9]);
+    TEST_ASSERT_EQUAL(MLX90393_AGAIN, MLX90393_LogNextBlock(&reader, &frames, &n));
+}
+
+void test_MLX90393_LogMap_RejectsForeignAndIgnoresCutRecord(void){
+    FILE *fp = fopen(path, "wb");
+    fputs("not a log file", fp);
+    fclose(fp);
+    TEST_ASSERT_EQUAL(MLX90393_MISMATCH, MLX90393_LogMap(&reader, path));
+
+    uint8_t data[6] = {0};
+    mlx_sample_t sample;
+    MLX90393_LogOpen(&writer, path);
+    MLX90393_LogConfig(&writer, &cfg_a, 0, MLX90393_MAG_XYZ, 0);
+    MLX90393_LogFrame(&writer, data, 0);
+    MLX90393_LogFlush(&writer);
+    MLX90393_LogFrame(&writer, data, 1);
+    MLX90393_LogClose(&writer);
+    TEST_ASSERT_EQUAL(0, truncate(path, file_size() - 1)); //Crash while writing the second record
+
+    TEST_ASSERT_EQUAL(0, MLX90393_LogMap(&reader, path));
+    TEST_ASSERT_EQUAL(0, MLX90393_LogNext(&reader, &sample));
+    TEST_ASSERT_EQUAL(MLX90393_AGAIN, MLX90393_LogNext(&reader, &sample));
+}
+
+void test_MLX90393_LogReplay_RerunsRecordedSimulation(void){
+    mlx_i2c_t dev, replay_dev;
+    mlx_sim_t sim;
+    mlx_log_replay_t replay;
+    mlx_cfg_t settings = cfg_a, replay_settings = {0};
+    mlx_sample_t live[20], again;
+    uint8_t status, data[6];
+
+    //Record: SM / RM on the simulator, raw frames into the log
+    memset(&dev, 0, sizeof(dev));
+    MLX90393_SimInit(&sim);
+    MLX90393_SimAttach(&dev, &sim);
+    sim.noise_uT = 2.0f;
+    sim.field[1] = 35.0f;
+    dev.settings = &settings;
+    MLX90393_ApplySettings(&dev, &settings);
+    MLX90393_LogOpen(&writer, path);
+    MLX90393_LogConfig(&writer, dev.settings, MLX90393_TcmpEnabled(&dev), MLX90393_MAG_XYZ, dev.cfg_gen);
+    for (int i = 0; i < 20; i++){
+        if (i == 10){
+            settings = cfg_b;
+            MLX90393_ApplySettings(&dev, &settings);
+            MLX90393_LogConfig(&writer, dev.settings, MLX90393_TcmpEnabled(&dev), MLX90393_MAG_XYZ, dev.cfg_gen);
+        }
+        MLX90393_SM(&dev, MLX90393_MAG_XYZ, &status);
+        MLX90393_WaitAndRead(&dev, MLX90393_MAG_XYZ, &status, data);
+        MLX90393_LogFrame(&writer, data, MLX90393_SimClock());
+        MLX90393_convert(dev.settings, 0, MLX90393_MAG_XYZ, data, &live[i]);
+        live[i].cfg_gen = dev.cfg_gen;
+    }
+    MLX90393_LogClose(&writer);
+
+    //Replay through the unmodified driver
+    MLX90393_LogMap(&reader, path);
+    memset(&replay_dev, 0, sizeof(replay_dev));
+    replay_dev.settings = &replay_settings;
+    TEST_ASSERT_EQUAL(0, MLX90393_LogReplayAttach(&replay_dev, &replay, &reader));
+    for (int i = 0; i < 20; i++){
+        TEST_ASSERT_EQUAL(0, MLX90393_readMeasurement(&replay_dev, MLX90393_MAG_XYZ, &again));
+        TEST_ASSERT_EQUAL_FLOAT_ARRAY(live[i].xyz, again.xyz, 3);
+        TEST_ASSERT_EQUAL(live[i].cfg_gen, again.cfg_gen);
+    }
+    TEST_ASSERT_EQUAL(MLX90393_GAIN_5X, replay_settings.gain);
+    TEST_ASSERT_EQUAL(0, MLX90393_GetSettings(&replay_dev)); //Register reads follow the log
+    TEST_ASSERT_EQUAL(MLX90393_RES_19, replay_settings.resolution_y);
+    TEST_ASSERT_EQUAL(MLX90393_AGAIN, MLX90393_readMeasurement(&replay_dev, MLX90393_MAG_XYZ, &again));
+}
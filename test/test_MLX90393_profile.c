@@ -0,0 +1,122 @@
+#include <string.h>
+#include <stdlib.h>
+#include "unity.h"
+#include "MLX90393.h"
+#include "MLX90393_profile.h"
+#include "mock_test_MLX90393.h"
+
+MLX90393_PROFILE(hires, MLX90393_GAIN_2X, MLX90393_RES_16, MLX90393_RES_18, MLX90393_RES_19, MLX90393_FILTER_3, MLX90393_OSR_2)
+
+static mlx_i2c_t fake_mlx;
+
+static int32_t cb_read_ok(mlx_i2c_t *dev, uint8_t *data, size_t len, int n){
+    memset(data, 0, len);
+    return 0;
+}
+
+//RM reports ERROR (data not ready) on the first attempt only
+static int32_t cb_read_not_ready_once(mlx_i2c_t *dev, uint8_t *data, size_t len, int n){
+    memset(data, 0, len);
+    if (n == 1){ //Call 0 is the SM status byte
+        data[0] = 0x10;
+    }
+    return 0;
+}
+
+void setUp(void) {
+    memset(&fake_mlx, 0, sizeof(fake_mlx));
+    fake_mlx.write_function = write_function;
+    fake_mlx.read_function = read_function;
+    fake_mlx.mdelay = delay_function;
+}
+
+void tearDown(void) {
+}
+
+void test_MLX90393_PROFILE_ConvertMatchesRuntimeConversion(void){
+    uint8_t frames[3][6] = {
+        {0x00, 0x64, 0x80, 0x64, 0x40, 0x64},
+        {0xFF, 0x9C, 0x7F, 0x9C, 0x3F, 0x9C},
+        {0x7F, 0xFF, 0xFF, 0xFF, 0xBF, 0xFF}
+    };
+    float expected[3];
+    float actual[3];
+    for (int i = 0; i < 3; i++){
+        MLX90393_convertXYZ(&hires_cfg, frames[i], expected);
+        hires_convertXYZ(frames[i], actual);
+        TEST_ASSERT_EQUAL_FLOAT(expected[0], actual[0]);
+        TEST_ASSERT_EQUAL_FLOAT(expected[1], actual[1]);
+        TEST_ASSERT_EQUAL_FLOAT(expected[2], actual[2]);
+    }
+}
+
+void test_MLX90393_PROFILE_TconvMatchesRuntimeLookup(void){
+    mlx_cfg_t cfg = hires_cfg;
+    fake_mlx.settings = &cfg;
+    TEST_ASSERT_EQUAL_UINT32(MLX90393_GetTconv_us(&fake_mlx), hires_tconv_us());
+}
+
+void test_MLX90393_PROFILE_ReadXYZWaitsConstantTconv(void){
+    float xyz[3];
+    mlx_cfg_t cfg = hires_cfg;
+    fake_mlx.settings = &cfg;
+    write_function_IgnoreAndReturn(0);
+    read_function_Stub(cb_read_ok);
+    delay_function_Expect(9); //MLX90393_Tconv_LookUp[3][2] + 1
+
+    TEST_ASSERT_EQUAL(0, hires_readXYZ(&fake_mlx, xyz));
+
+    fake_mlx.udelay = udelay_function;
+    udelay_function_Expect(8370);
+    TEST_ASSERT_EQUAL(0, hires_readXYZ(&fake_mlx, xyz));
+}
+
+void test_MLX90393_PROFILE_ReadXYZRepollsWhileNotReady(void){
+    float xyz[3];
+    mlx_cfg_t cfg = hires_cfg;
+    fake_mlx.settings = &cfg;
+    fake_mlx.udelay = udelay_function;
+    fake_mlx.ready_retries = 1;
+    write_function_IgnoreAndReturn(0);
+    read_function_Stub(cb_read_not_ready_once);
+    udelay_function_Expect(8370);
+    udelay_function_Expect(MLX90393_READY_POLL_US);
+
+    TEST_ASSERT_EQUAL(0, hires_readXYZ(&fake_mlx, xyz));
+}
+
+//RM returns the TCMP zero field (0x8000) on X and Y, and 100 counts above it on Z
+static int32_t cb_read_tcmp(mlx_i2c_t *dev, uint8_t *data, size_t len, int n){
+    memset(data, 0, len);
+    if (len == 7){
+        data[1] = 0x80;
+        data[3] = 0x80;
+        data[5] = 0x40;
+        data[6] = 0x64;
+    }
+    return 0;
+}
+
+void test_MLX90393_PROFILE_ReadXYZDecodesTcmpOffsets(void){
+    float xyz[3];
+    mlx_cfg_t cfg = hires_cfg;
+    fake_mlx.settings = &cfg;
+    fake_mlx.regs[MLX90393_REG_CONF2] = 1 << 10; //TCMP_EN
+    fake_mlx.regs_valid = 1 << MLX90393_REG_CONF2;
+    write_function_IgnoreAndReturn(0);
+    read_function_Stub(cb_read_tcmp);
+    delay_function_Ignore();
+
+    TEST_ASSERT_EQUAL(0, hires_readXYZ(&fake_mlx, xyz));
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, xyz[0]); //RES_16 is unsigned around 0x8000 with TCMP_EN
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, xyz[1]);
+    TEST_ASSERT_EQUAL_FLOAT(100 * MLX90393_GetSensitivity(&cfg, 2), xyz[2]); //RES_19 keeps 0x4000
+}
+
+void test_MLX90393_PROFILE_ReadXYZReturnsBusFailure(void){
+    float xyz[3];
+    mlx_cfg_t cfg = hires_cfg;
+    fake_mlx.settings = &cfg;
+    write_function_IgnoreAndReturn(1);
+    TEST_ASSERT_EQUAL(1, hires_readXYZ(&fake_mlx, xyz));
+}
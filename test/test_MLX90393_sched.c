@@ -0,0 +1,214 @@
+#include <string.h>
+#include <stdlib.h>
+#include "unity.h"
+#include "MLX90393.h"
+#include "MLX90393_sched.h"
+#include "mock_test_MLX90393.h"
+
+#define N_DEV 3
+
+static mlx_i2c_t fake_mlx[N_DEV];
+static mlx_cfg_t fake_settings;
+static mlx_sched_t sched;
+
+//Virtual time and bus log
+static uint64_t now_us;
+static uint8_t cmd_log[64];
+static size_t cmd_count;
+static uint32_t delays;
+static size_t sample_idx[16];
+static size_t sample_count;
+static int fail_dev; //Device whose writes fail (-1 = none)
+static uint8_t rm_error; //RM responses report ERROR (data never ready)
+
+static uint64_t cb_clock(int n){
+    return now_us;
+}
+
+static void cb_udelay(uint32_t us, int n){
+    now_us += us;
+    delays++;
+}
+
+static int32_t cb_write(mlx_i2c_t *dev, uint8_t *buf, size_t len, int n){
+    if(fail_dev >= 0 && dev == &fake_mlx[fail_dev]){
+        return -1;
+    }
+    cmd_log[cmd_count++] = buf[0];
+    now_us += 100; //Bus time of a short transaction
+    return 0;
+}
+
+static int32_t cb_read(mlx_i2c_t *dev, uint8_t *data, size_t len, int n){
+    memset(data, 0, len);
+    if(rm_error && cmd_log[cmd_count - 1] == 0x4E){
+        data[0] = 0x10;
+    }
+    return 0;
+}
+
+static void on_sample(void *ctx, size_t idx, const float *xyz){
+    sample_idx[sample_count++] = idx;
+}
+
+void setUp(void) {
+    mlx_cfg_t settings = {
+        .gain = MLX90393_GAIN_1X,
+        .resolution_x = MLX90393_RES_16,
+        .resolution_y = MLX90393_RES_16,
+        .resolution_z = MLX90393_RES_16,
+        .filter = MLX90393_FILTER_3,
+        .oversampling = MLX90393_OSR_2
+    };
+    fake_settings = settings;
+    now_us = 0;
+    cmd_count = 0;
+    delays = 0;
+    sample_count = 0;
+    fail_dev = -1;
+    rm_error = 0;
+
+    MLX90393_SchedInit(&sched, clock_function, udelay_function, on_sample, NULL);
+    for(int i = 0; i < N_DEV; i++){
+        memset(&fake_mlx[i], 0, sizeof(mlx_i2c_t));
+        fake_mlx[i].settings = &fake_settings;
+        fake_mlx[i].write_function = write_function;
+        fake_mlx[i].read_function = read_function;
+        fake_mlx[i].mdelay = delay_function;
+    }
+    clock_function_Stub(cb_clock);
+    udelay_function_Stub(cb_udelay);
+    write_function_Stub(cb_write);
+    read_function_Stub(cb_read);
+}
+
+void tearDown(void) {
+}
+
+void test_MLX90393_SchedInit_Returns1WithoutHooks(void){
+    mlx_sched_t s;
+    TEST_ASSERT_EQUAL(1, MLX90393_SchedInit(NULL, clock_function, udelay_function, NULL, NULL));
+    TEST_ASSERT_EQUAL(1, MLX90393_SchedInit(&s, NULL, udelay_function, NULL, NULL));
+    TEST_ASSERT_EQUAL(1, MLX90393_SchedInit(&s, clock_function, NULL, NULL, NULL));
+}
+
+void test_MLX90393_SchedAdd_GivesClockToDevicesWithoutOne(void){
+    TEST_ASSERT_EQUAL(0, MLX90393_SchedAdd(&sched, &fake_mlx[0], 0));
+    TEST_ASSERT_EQUAL_PTR(clock_function, fake_mlx[0].clock_us);
+}
+
+void test_MLX90393_SchedAdd_ReturnsAgainWhenFull(void){
+    for(int i = 0; i < MLX90393_SCHED_MAX_DEVICES; i++){
+        TEST_ASSERT_EQUAL(0, MLX90393_SchedAdd(&sched, &fake_mlx[0], 0));
+    }
+    TEST_ASSERT_EQUAL(MLX90393_AGAIN, MLX90393_SchedAdd(&sched, &fake_mlx[0], 0));
+}
+
+void test_MLX90393_SchedRound_StartsAllBeforeReadingAny(void){
+    uint32_t collected;
+    for(int i = 0; i < N_DEV; i++){
+        MLX90393_SchedAdd(&sched, &fake_mlx[i], 0);
+    }
+
+    TEST_ASSERT_EQUAL(0, MLX90393_SchedRound(&sched, &collected));
+    TEST_ASSERT_EQUAL(N_DEV, collected);
+
+    uint8_t expected[2 * N_DEV] = {0x3E, 0x3E, 0x3E, 0x4E, 0x4E, 0x4E};
+    TEST_ASSERT_EQUAL(2 * N_DEV, cmd_count);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, cmd_log, 2 * N_DEV);
+    TEST_ASSERT_EQUAL(1, delays); //A single Tconv wait for the whole bus
+}
+
+void test_MLX90393_SchedRound_RotatesStartOrderForFairness(void){
+    for(int i = 0; i < N_DEV; i++){
+        MLX90393_SchedAdd(&sched, &fake_mlx[i], 0);
+    }
+
+    MLX90393_SchedRound(&sched, NULL);
+    MLX90393_SchedRound(&sched, NULL);
+    TEST_ASSERT_EQUAL(2 * N_DEV, sample_count);
+    TEST_ASSERT_EQUAL(0, sample_idx[0]);
+    TEST_ASSERT_EQUAL(1, sample_idx[N_DEV]);
+}
+
+void test_MLX90393_SchedRun_HonoursPerDeviceRateTargets(void){
+    MLX90393_SchedAdd(&sched, &fake_mlx[0], 20000);
+    MLX90393_SchedAdd(&sched, &fake_mlx[1], 40000);
+
+    TEST_ASSERT_EQUAL(0, MLX90393_SchedRun(&sched, 8));
+    TEST_ASSERT_EQUAL(8, sched.slots[0].samples);
+    TEST_ASSERT_EQUAL(4, sched.slots[1].samples);
+}
+
+void test_MLX90393_SchedRound_CountsErrorsAndKeepsGoing(void){
+    MLX90393_SchedAdd(&sched, &fake_mlx[0], 0);
+    MLX90393_SchedAdd(&sched, &fake_mlx[1], 0);
+    fake_mlx[1].settings = NULL; //StartXYZ rejects it
+
+    TEST_ASSERT_EQUAL(0, MLX90393_SchedRound(&sched, NULL));
+    TEST_ASSERT_EQUAL(1, sched.slots[0].samples);
+    TEST_ASSERT_EQUAL(1, sched.slots[1].errors);
+}
+
+void test_MLX90393_SchedRound_DropsDevicesThatNeverGetReady(void){
+    uint32_t collected;
+    MLX90393_SchedAdd(&sched, &fake_mlx[0], 0);
+    MLX90393_SchedAdd(&sched, &fake_mlx[1], 0);
+    rm_error = 1;
+
+    TEST_ASSERT_EQUAL(MLX90393_AGAIN, MLX90393_SchedRound(&sched, &collected));
+    TEST_ASSERT_EQUAL(0, collected);
+    TEST_ASSERT_EQUAL(1, sched.slots[0].errors);
+    TEST_ASSERT_EQUAL(1, sched.slots[1].errors);
+    TEST_ASSERT_EQUAL(0, fake_mlx[0].pending);
+    TEST_ASSERT_EQUAL(0, fake_mlx[1].pending);
+}
+
+void test_MLX90393_SchedSnapshot_TriggersAllThenReadsAll(void){
+    mlx_snapshot_t snap;
+    for(int i = 0; i < N_DEV; i++){
+        MLX90393_SchedAdd(&sched, &fake_mlx[i], 0);
+    }
+
+    TEST_ASSERT_EQUAL(0, MLX90393_SchedSnapshot(&sched, &snap));
+    uint8_t expected[2 * N_DEV] = {0x3E, 0x3E, 0x3E, 0x4E, 0x4E, 0x4E};
+    TEST_ASSERT_EQUAL(2 * N_DEV, cmd_count);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, cmd_log, 2 * N_DEV);
+    TEST_ASSERT_EQUAL(1, delays);
+    TEST_ASSERT_EQUAL_HEX32((1u << N_DEV) - 1, snap.valid);
+    TEST_ASSERT_EQUAL(100, snap.t_trigger_us);
+    TEST_ASSERT_EQUAL(200, snap.skew_us); //One write apart
+    for(int i = 0; i < N_DEV; i++){
+        TEST_ASSERT_EQUAL(100 + 100 * i, snap.samples[i].t_issue_us);
+        TEST_ASSERT_EQUAL(1, sched.slots[i].samples);
+    }
+    TEST_ASSERT_EQUAL(0, sample_count); //Not a regular round
+}
+
+void test_MLX90393_SchedSnapshot_WaitsForSlowestConfig(void){
+    mlx_snapshot_t snap;
+    mlx_cfg_t slow = fake_settings;
+    slow.oversampling = MLX90393_OSR_3;
+    fake_mlx[1].settings = &slow;
+    for(int i = 0; i < N_DEV; i++){
+        MLX90393_SchedAdd(&sched, &fake_mlx[i], 0);
+    }
+
+    TEST_ASSERT_EQUAL(0, MLX90393_SchedSnapshot(&sched, &snap));
+    TEST_ASSERT_EQUAL(1, delays);
+    TEST_ASSERT_TRUE(snap.samples[0].t_done_us >= fake_mlx[1].deadline_us);
+    TEST_ASSERT_TRUE(snap.samples[0].t_done_us < snap.samples[1].t_done_us);
+}
+
+void test_MLX90393_SchedSnapshot_ReportsMissingDevices(void){
+    mlx_snapshot_t snap;
+    for(int i = 0; i < N_DEV; i++){
+        MLX90393_SchedAdd(&sched, &fake_mlx[i], 0);
+    }
+    fail_dev = 1;
+
+    TEST_ASSERT_EQUAL(MLX90393_AGAIN, MLX90393_SchedSnapshot(&sched, &snap));
+    TEST_ASSERT_EQUAL_HEX32(0x5, snap.valid);
+    TEST_ASSERT_EQUAL(1, sched.slots[1].errors);
+    TEST_ASSERT_EQUAL(100, snap.skew_us);
+}
@@ -0,0 +1,229 @@
+#include <string.h>
+#include <math.h>
+#include <stdlib.h>
+#include "unity.h"
+#include "MLX90393.h"
+#include "MLX90393_cmds.h"
+#include "MLX90393_sim.h"
+
+static mlx_i2c_t fake_mlx;
+static mlx_sim_t sim;
+static mlx_cfg_t settings;
+
+static float step_field(void *ctx, int axis, uint64_t t_us){
+    return (axis == 2 && t_us >= *(uint64_t *) ctx) ? 500.0f : 0.0f;
+}
+
+void setUp(void) {
+    memset(&fake_mlx, 0, sizeof(fake_mlx));
+    MLX90393_SimInit(&sim);
+    MLX90393_SimAttach(&fake_mlx, &sim);
+    MLX90393_SimSetClock(0);
+    settings = (mlx_cfg_t) {
+        .gain = MLX90393_GAIN_1X,
+        .resolution_x = MLX90393_RES_16,
+        .resolution_y = MLX90393_RES_17,
+        .resolution_z = MLX90393_RES_18,
+        .filter = MLX90393_FILTER_2,
+        .oversampling = MLX90393_OSR_1
+    };
+}
+
+void tearDown(void) {
+}
+
+void test_MLX90393_SIM_ResetStatusIsReportedOnce(void){
+    uint8_t status;
+    uint8_t data[2];
+    TEST_ASSERT_EQUAL(0, MLX90393_RR(&fake_mlx, &status, MLX90393_REG_CONF1, data));
+    TEST_ASSERT_EQUAL_HEX8(MLX90393_STATUS_RS, status);
+    TEST_ASSERT_EQUAL_HEX16(0x007C, fake_mlx.regs[MLX90393_REG_CONF1]);
+    TEST_ASSERT_EQUAL(0, MLX90393_NOP(&fake_mlx, &status));
+    TEST_ASSERT_EQUAL_HEX8(0x00, status);
+}
+
+void test_MLX90393_SIM_SettingsRoundTrip(void){
+    mlx_i2c_t other;
+    memset(&other, 0, sizeof(other));
+    MLX90393_SimAttach(&other, &sim);
+
+    TEST_ASSERT_EQUAL(0, MLX90393_ApplySettings(&fake_mlx, &settings));
+    TEST_ASSERT_EQUAL(0, MLX90393_GetSettings(&other));
+    TEST_ASSERT_EQUAL_MEMORY(&settings, other.settings, sizeof(mlx_cfg_t));
+    TEST_ASSERT_EQUAL_HEX16(0x000C, sim.regs[MLX90393_REG_CONF1] & 0x000F); //HALLCONF untouched
+    free(fake_mlx.settings);
+    free(other.settings);
+}
+
+void test_MLX90393_SIM_ReadXYZReturnsFieldAfterTconv(void){
+    float xyz[3];
+    sim.field[0] = 100.0f;
+    sim.field[1] = -50.0f;
+    sim.field[2] = 30.0f;
+    fake_mlx.settings = &settings;
+    TEST_ASSERT_EQUAL(0, MLX90393_ApplySettings(&fake_mlx, &settings));
+    MLX90393_SimSetClock(0);
+
+    TEST_ASSERT_EQUAL(0, MLX90393_readXYZ(&fake_mlx, xyz));
+
+    TEST_ASSERT_FLOAT_WITHIN(0.161f, 100.0f, xyz[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.322f, -50.0f, xyz[1]);
+    TEST_ASSERT_FLOAT_WITHIN(1.174f, 30.0f, xyz[2]);
+    TEST_ASSERT_EQUAL_UINT64(MLX90393_GetTconv_us(&fake_mlx), MLX90393_SimClock());
+}
+
+void test_MLX90393_SIM_ReadBeforeTconvReportsError(void){
+    uint8_t status;
+    uint8_t data[6];
+    fake_mlx.settings = &settings;
+    TEST_ASSERT_EQUAL(0, MLX90393_ApplySettings(&fake_mlx, &settings));
+
+    MLX90393_SM(&fake_mlx, MLX90393_MAG_XYZ, &status);
+    TEST_ASSERT_EQUAL_HEX8(MLX90393_STATUS_SM, status);
+    MLX90393_SM(&fake_mlx, MLX90393_MAG_XYZ, &status);
+    TEST_ASSERT_EQUAL_HEX8(MLX90393_STATUS_SM | MLX90393_STATUS_ERROR, status);
+
+    MLX90393_SimUdelay(MLX90393_GetTconv_us(&fake_mlx) - 1);
+    MLX90393_RM(&fake_mlx, MLX90393_MAG_XYZ, &status, data);
+    TEST_ASSERT_BITS_HIGH(MLX90393_STATUS_ERROR, status);
+
+    MLX90393_SimUdelay(1);
+    MLX90393_RM(&fake_mlx, MLX90393_MAG_XYZ, &status, data);
+    TEST_ASSERT_EQUAL_HEX8(0x02, status); //Back to idle, D = 2 (6 bytes)
+}
+
+void test_MLX90393_SIM_BurstModeConvertsEveryPeriod(void){
+    uint8_t status;
+    uint8_t data[2];
+    fake_mlx.settings = &settings;
+    MLX90393_ApplySettings(&fake_mlx, &settings);
+    MLX90393_WR(&fake_mlx, &status, MLX90393_REG_CONF2, 0x0001); //BURST_DATA_RATE = 20 ms
+
+    MLX90393_SB(&fake_mlx, MLX90393_MAG_Z, &status);
+    TEST_ASSERT_EQUAL_HEX8(MLX90393_STATUS_BURST, status);
+    TEST_ASSERT_EQUAL(1, sim.period_us == 20000);
+
+    MLX90393_SimUdelay(MLX90393_GetTconv_us(&fake_mlx));
+    TEST_ASSERT_EQUAL(1, MLX90393_SimDataReady(&fake_mlx));
+    MLX90393_RM(&fake_mlx, MLX90393_MAG_Z, &status, data);
+    TEST_ASSERT_EQUAL_HEX8(MLX90393_STATUS_BURST, status);
+    MLX90393_RM(&fake_mlx, MLX90393_MAG_Z, &status, data);
+    TEST_ASSERT_BITS_HIGH(MLX90393_STATUS_ERROR, status);
+
+    MLX90393_RR(&fake_mlx, &status, MLX90393_REG_CONF1, data); //Memory commands are rejected in burst mode
+    TEST_ASSERT_EQUAL_HEX8(MLX90393_STATUS_BURST | MLX90393_STATUS_ERROR, status);
+
+    MLX90393_SimUdelay(20000);
+    MLX90393_RM(&fake_mlx, MLX90393_MAG_Z, &status, data);
+    TEST_ASSERT_EQUAL_HEX8(MLX90393_STATUS_BURST, status);
+
+    MLX90393_EX(&fake_mlx, &status);
+    TEST_ASSERT_EQUAL_HEX8(0x00, status);
+}
+
+void test_MLX90393_SIM_MemoryRecallStoreAndReset(void){
+    uint8_t status;
+    MLX90393_WR(&fake_mlx, &status, MLX90393_REG_SENS_TC, 0x1234);
+    MLX90393_HS(&fake_mlx, &status);
+    MLX90393_WR(&fake_mlx, &status, MLX90393_REG_SENS_TC, 0x5678);
+    MLX90393_HR(&fake_mlx, &status);
+    TEST_ASSERT_EQUAL_HEX16(0x1234, sim.regs[MLX90393_REG_SENS_TC]);
+
+    MLX90393_WR(&fake_mlx, &status, MLX90393_REG_SENS_TC, 0x5678);
+    MLX90393_RT(&fake_mlx, &status);
+    TEST_ASSERT_EQUAL_HEX8(MLX90393_STATUS_RS, status);
+    TEST_ASSERT_EQUAL_HEX16(0x1234, sim.regs[MLX90393_REG_SENS_TC]);
+
+    MLX90393_WR(&fake_mlx, &status, 0x3F, 0x0000);
+    TEST_ASSERT_EQUAL_HEX8(MLX90393_STATUS_RS | MLX90393_STATUS_ERROR, status);
+}
+
+void test_MLX90393_SIM_NoiseHasConfiguredDeviation(void){
+    float xyz[3];
+    double sum = 0, sum2 = 0;
+    const int n = 2000;
+    settings.gain = MLX90393_GAIN_1X;
+    settings.resolution_x = MLX90393_RES_16;
+    fake_mlx.settings = &settings;
+    MLX90393_ApplySettings(&fake_mlx, &settings);
+    sim.field[0] = 20.0f;
+    sim.noise_uT = 2.0f;
+    for (int i = 0; i < n; i++){
+        MLX90393_readXYZ(&fake_mlx, xyz);
+        sum += xyz[0];
+        sum2 += xyz[0] * xyz[0];
+    }
+    double mean = sum / n;
+    double sd = sqrt(sum2 / n - mean * mean);
+    TEST_ASSERT_FLOAT_WITHIN(0.2f, 20.0f, (float) mean);
+    TEST_ASSERT_FLOAT_WITHIN(0.2f, 2.0f, (float) sd);
+}
+
+void test_MLX90393_SIM_SineWaveformFollowsVirtualTime(void){
+    uint8_t status;
+    uint8_t data[2];
+    fake_mlx.settings = &settings;
+    settings.resolution_x = MLX90393_RES_16;
+    MLX90393_ApplySettings(&fake_mlx, &settings);
+    sim.sine_amp[0] = 100.0f;
+    sim.sine_hz = 10.0f;
+    MLX90393_SimSetClock(25000 - MLX90393_GetTconvZyxt_us(&fake_mlx, 0x02)); //Conversion ends at a quarter period
+
+    MLX90393_SM(&fake_mlx, 0x02, &status); //X only
+    MLX90393_WaitAndRead(&fake_mlx, 0x02, &status, data);
+    int16_t raw = (int16_t) (data[0] << 8 | data[1]);
+    TEST_ASSERT_INT_WITHIN(1, 621, raw); //100 uT / 0.161 uT/LSB
+}
+
+void test_MLX90393_SIM_InjectedFaults(void){
+    float xyz[3];
+    uint8_t status;
+    fake_mlx.settings = &settings;
+    MLX90393_ApplySettings(&fake_mlx, &settings);
+
+    sim.nack_next = 1;
+    TEST_ASSERT_EQUAL(1, MLX90393_readXYZ(&fake_mlx, xyz));
+    TEST_ASSERT_EQUAL(0, MLX90393_readXYZ(&fake_mlx, xyz));
+
+    sim.sed_next = 1;
+    MLX90393_NOP(&fake_mlx, &status);
+    TEST_ASSERT_EQUAL_HEX8(MLX90393_STATUS_SED, status);
+    MLX90393_NOP(&fake_mlx, &status);
+    TEST_ASSERT_EQUAL_HEX8(0x00, status);
+}
+
+void test_MLX90393_SIM_WakeOnChangeRaisesDataReady(void){
+    uint8_t status;
+    uint8_t data[2];
+    uint64_t step_us = 50000;
+    fake_mlx.settings = &settings;
+    MLX90393_ApplySettings(&fake_mlx, &settings);
+    MLX90393_WR(&fake_mlx, &status, MLX90393_REG_CONF2, 0x0001);
+    MLX90393_WR(&fake_mlx, &status, MLX90393_REG_WOZ_THRESHOLD, 100);
+    sim.waveform = step_field;
+    sim.ctx = &step_us;
+
+    MLX90393_SWOC(&fake_mlx, MLX90393_MAG_Z, &status);
+    TEST_ASSERT_EQUAL_HEX8(MLX90393_STATUS_WOC, status);
+    MLX90393_SimSetClock(40000);
+    TEST_ASSERT_EQUAL(0, MLX90393_SimDataReady(&fake_mlx));
+    MLX90393_SimSetClock(80000); //Conversions every 20 ms, at least one after the step
+    TEST_ASSERT_EQUAL(1, MLX90393_SimDataReady(&fake_mlx));
+    MLX90393_RM(&fake_mlx, MLX90393_MAG_Z, &status, data);
+    TEST_ASSERT_EQUAL_HEX8(MLX90393_STATUS_WOC, status);
+}
+
+void test_MLX90393_SIM_BusTimeAndCounters(void){
+    uint8_t status;
+    sim.byte_us = 23;
+    MLX90393_NOP(&fake_mlx, &status);
+    TEST_ASSERT_EQUAL_UINT64(2 * 2 * 23, MLX90393_SimClock());
+    TEST_ASSERT_EQUAL(2, sim.transactions);
+
+    fake_mlx.transfer = MLX90393_SimTransfer;
+    MLX90393_NOP(&fake_mlx, &status);
+    TEST_ASSERT_EQUAL_UINT64(4 * 23 + 3 * 23, MLX90393_SimClock());
+    TEST_ASSERT_EQUAL(3, sim.transactions);
+    TEST_ASSERT_EQUAL(2, sim.bytes_written);
+    TEST_ASSERT_EQUAL(2, sim.bytes_read);
+}
@@ -0,0 +1,73 @@
+#include <string.h>
+#include "unity.h"
+#include "MLX90393.h"
+#include "mock_test_MLX90393.h"
+
+//Built with MLX90393_STATIC_ALLOC (see project.yml): the strict mlx_malloc / mlx_free mocks fail
+//any test in which the library reaches for the allocator
+
+static mlx_i2c_t fake_mlx;
+
+static int32_t cb_read_zero(mlx_i2c_t *dev, uint8_t *data, size_t len, int n){
+    memset(data, 0, len);
+    return 0;
+}
+
+void setUp(void) {
+    memset(&fake_mlx, 0, sizeof(fake_mlx));
+    fake_mlx.write_function = write_function;
+    fake_mlx.read_function = read_function;
+    fake_mlx.mdelay = delay_function;
+}
+
+void tearDown(void) {
+}
+
+void test_MLX90393_STATIC_GetSettingsUsesEmbeddedStorage(void){
+    write_function_IgnoreAndReturn(0);
+    read_function_Stub(cb_read_zero);
+
+    TEST_ASSERT_EQUAL(0, MLX90393_GetSettings(&fake_mlx));
+    TEST_ASSERT_EQUAL_PTR(&fake_mlx.settings_storage, fake_mlx.settings);
+}
+
+void test_MLX90393_STATIC_ApplySettingsUsesEmbeddedStorage(void){
+    mlx_cfg_t cfg = {
+        .gain = MLX90393_GAIN_2X,
+        .resolution_x = MLX90393_RES_17,
+        .resolution_y = MLX90393_RES_17,
+        .resolution_z = MLX90393_RES_16,
+        .filter = MLX90393_FILTER_3,
+        .oversampling = MLX90393_OSR_2
+    };
+    write_function_IgnoreAndReturn(0);
+    read_function_Stub(cb_read_zero);
+
+    TEST_ASSERT_EQUAL(0, MLX90393_ApplySettings(&fake_mlx, &cfg));
+    TEST_ASSERT_EQUAL_PTR(&fake_mlx.settings_storage, fake_mlx.settings);
+    TEST_ASSERT_EQUAL(MLX90393_GAIN_2X, fake_mlx.settings->gain);
+}
+
+void test_MLX90393_STATIC_AllocHandsOutPoolUntilExhausted(void){
+    mlx_i2c_t *devs[MLX90393_STATIC_POOL_SIZE];
+    for (int i = 0; i < MLX90393_STATIC_POOL_SIZE; i++){
+        devs[i] = MLX90393_Alloc();
+        TEST_ASSERT_NOT_NULL(devs[i]);
+        TEST_ASSERT_NULL(devs[i]->settings);
+    }
+    TEST_ASSERT_NULL(MLX90393_Alloc());
+
+    MLX90393_Free(devs[1]);
+    TEST_ASSERT_EQUAL_PTR(devs[1], MLX90393_Alloc());
+
+    for (int i = 0; i < MLX90393_STATIC_POOL_SIZE; i++){
+        MLX90393_Free(devs[i]);
+    }
+}
+
+void test_MLX90393_STATIC_FreeLeavesCallerOwnedDeviceAlone(void){
+    fake_mlx.settings = &fake_mlx.settings_storage;
+    MLX90393_Free(&fake_mlx);
+    MLX90393_Free(NULL);
+    TEST_ASSERT_EQUAL_PTR(&fake_mlx.settings_storage, fake_mlx.settings);
+}
@@ -0,0 +1,128 @@
+#include <string.h>
+#include "unity.h"
+#include "MLX90393.h"
+#include "MLX90393_cmds.h"
+#include "MLX90393_sim.h"
+
+//Built with MLX90393_STATS (see project.yml), against the simulator
+
+static mlx_i2c_t fake_mlx;
+static mlx_sim_t sim;
+static mlx_cfg_t settings;
+static uint8_t traced[16];
+static size_t traced_resp_len[16];
+static int32_t traced_ret[16];
+static int trace_count;
+
+static void cb_trace(void *ctx, mlx_i2c_t *dev, const uint8_t *cmd, size_t cmd_len,
+                     const uint8_t *resp, size_t resp_len, int32_t ret){
+    TEST_ASSERT_EQUAL_PTR(&trace_count, ctx);
+    TEST_ASSERT_EQUAL_PTR(&fake_mlx, dev);
+    traced[trace_count] = cmd[0];
+    traced_resp_len[trace_count] = resp_len;
+    traced_ret[trace_count] = ret;
+    trace_count++;
+}
+
+void setUp(void) {
+    memset(&fake_mlx, 0, sizeof(fake_mlx));
+    MLX90393_SimInit(&sim);
+    MLX90393_SimAttach(&fake_mlx, &sim);
+    MLX90393_SimSetClock(0);
+    settings = (mlx_cfg_t) {
+        .gain = MLX90393_GAIN_1X,
+        .resolution_x = MLX90393_RES_16,
+        .resolution_y = MLX90393_RES_16,
+        .resolution_z = MLX90393_RES_16,
+        .filter = MLX90393_FILTER_2,
+        .oversampling = MLX90393_OSR_1
+    };
+    fake_mlx.settings = &settings;
+    MLX90393_ApplySettings(&fake_mlx, &settings);
+    MLX90393_ResetStats(&fake_mlx);
+    trace_count = 0;
+}
+
+void tearDown(void) {
+}
+
+void test_MLX90393_STATS_ReadXYZCountsCommandsBytesAndWait(void){
+    float xyz[3];
+    sim.byte_us = 23;
+
+    TEST_ASSERT_EQUAL(0, MLX90393_readXYZ(&fake_mlx, xyz));
+
+    TEST_ASSERT_EQUAL(1, fake_mlx.stats.commands[0x3]);
+    TEST_ASSERT_EQUAL(1, fake_mlx.stats.commands[0x4]);
+    TEST_ASSERT_EQUAL(2, fake_mlx.stats.bytes_out);
+    TEST_ASSERT_EQUAL(1 + 7, fake_mlx.stats.bytes_in);
+    TEST_ASSERT_EQUAL(MLX90393_GetTconv_us(&fake_mlx), fake_mlx.stats.wait_us);
+    TEST_ASSERT_EQUAL(1, fake_mlx.stats.samples);
+    //From the end of SM: Tconv + RM command (2 bytes) and response (8 bytes)
+    uint32_t latency = MLX90393_GetTconv_us(&fake_mlx) + 10 * 23;
+    TEST_ASSERT_EQUAL(latency, fake_mlx.stats.latency_min_us);
+    TEST_ASSERT_EQUAL(latency, fake_mlx.stats.latency_max_us);
+    TEST_ASSERT_EQUAL(latency, fake_mlx.stats.latency_sum_us);
+}
+
+void test_MLX90393_STATS_LatencyMinMaxAverage(void){
+    float xyz[3];
+    MLX90393_readXYZ(&fake_mlx, xyz);
+    TEST_ASSERT_EQUAL(0, MLX90393_StartXYZ(&fake_mlx, NULL));
+    MLX90393_SimUdelay(MLX90393_GetTconv_us(&fake_mlx) + 1000);
+    TEST_ASSERT_EQUAL(0, MLX90393_CompleteXYZ(&fake_mlx, xyz));
+
+    uint32_t tconv = MLX90393_GetTconv_us(&fake_mlx);
+    TEST_ASSERT_EQUAL(2, fake_mlx.stats.samples);
+    TEST_ASSERT_EQUAL(tconv, fake_mlx.stats.latency_min_us);
+    TEST_ASSERT_EQUAL(tconv + 1000, fake_mlx.stats.latency_max_us);
+    TEST_ASSERT_EQUAL(2 * tconv + 1000, fake_mlx.stats.latency_sum_us);
+}
+
+void test_MLX90393_STATS_StatusBitsAndBusErrors(void){
+    uint8_t status;
+    uint8_t data[6];
+    MLX90393_SM(&fake_mlx, MLX90393_MAG_XYZ, &status);
+    MLX90393_RM(&fake_mlx, MLX90393_MAG_XYZ, &status, data); //Before Tconv
+    sim.sed_next = 1;
+    MLX90393_NOP(&fake_mlx, &status);
+    MLX90393_RT(&fake_mlx, &status);
+    sim.nack_next = 1;
+    MLX90393_NOP(&fake_mlx, &status);
+
+    TEST_ASSERT_EQUAL(1, fake_mlx.stats.status_error);
+    TEST_ASSERT_EQUAL(1, fake_mlx.stats.status_sed);
+    TEST_ASSERT_EQUAL(1, fake_mlx.stats.status_rs);
+    TEST_ASSERT_EQUAL(1, fake_mlx.stats.bus_errors);
+    TEST_ASSERT_EQUAL(0, fake_mlx.stats.samples);
+    TEST_ASSERT_EQUAL(2, fake_mlx.stats.commands[0x0]);
+}
+
+void test_MLX90393_STATS_TraceSeesEveryCommand(void){
+    uint8_t status;
+    MLX90393_SetTrace(&fake_mlx, cb_trace, &trace_count);
+    MLX90393_NOP(&fake_mlx, &status);
+    MLX90393_WR(&fake_mlx, &status, MLX90393_REG_SENS_TC, 0x1234);
+    sim.nack_next = 1;
+    MLX90393_EX(&fake_mlx, &status);
+
+    TEST_ASSERT_EQUAL(3, trace_count);
+    TEST_ASSERT_EQUAL_HEX8(0x00, traced[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x60, traced[1]);
+    TEST_ASSERT_EQUAL(1, traced_resp_len[1]);
+    TEST_ASSERT_EQUAL_HEX8(0x80, traced[2]);
+    TEST_ASSERT_EQUAL(0, traced_resp_len[2]);
+    TEST_ASSERT_EQUAL(1, traced_ret[2]);
+
+    MLX90393_SetTrace(&fake_mlx, NULL, NULL);
+    MLX90393_NOP(&fake_mlx, &status);
+    TEST_ASSERT_EQUAL(3, trace_count);
+}
+
+void test_MLX90393_STATS_ResetClearsCounters(void){
+    uint8_t status;
+    MLX90393_NOP(&fake_mlx, &status);
+    MLX90393_ResetStats(&fake_mlx);
+    TEST_ASSERT_EQUAL(0, fake_mlx.stats.commands[0x0]);
+    TEST_ASSERT_EQUAL(0, fake_mlx.stats.bytes_out);
+}
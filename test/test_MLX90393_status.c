@@ -0,0 +1,142 @@
+#include <string.h>
+#include "unity.h"
+#include "MLX90393.h"
+#include "MLX90393_cmds.h"
+#include "MLX90393_sim.h"
+#include "MLX90393_stream.h"
+
+static mlx_i2c_t fake_mlx;
+static mlx_sim_t sim;
+static mlx_cfg_t settings;
+
+void setUp(void) {
+    uint8_t status;
+    memset(&fake_mlx, 0, sizeof(fake_mlx));
+    MLX90393_SimInit(&sim);
+    MLX90393_SimAttach(&fake_mlx, &sim);
+    MLX90393_SimSetClock(0);
+    settings = (mlx_cfg_t) {
+        .gain = MLX90393_GAIN_2X,
+        .resolution_x = MLX90393_RES_17,
+        .resolution_y = MLX90393_RES_17,
+        .resolution_z = MLX90393_RES_17,
+        .filter = MLX90393_FILTER_2,
+        .oversampling = MLX90393_OSR_1
+    };
+    fake_mlx.settings = &settings;
+    MLX90393_NOP(&fake_mlx, &status); //Consume the power-on RS
+    MLX90393_ApplySettings(&fake_mlx, &settings);
+}
+
+void tearDown(void) {
+}
+
+void test_MLX90393_DecodeStatus_SplitsFields(void){
+    mlx_status_t decoded;
+    TEST_ASSERT_EQUAL(1, MLX90393_DecodeStatus(0x00, NULL));
+
+    TEST_ASSERT_EQUAL(0, MLX90393_DecodeStatus(MLX90393_STATUS_BURST | MLX90393_STATUS_SED | 0x02, &decoded));
+    TEST_ASSERT_EQUAL_HEX8(MLX90393_STATUS_BURST, decoded.mode);
+    TEST_ASSERT_EQUAL(0, decoded.error);
+    TEST_ASSERT_EQUAL(1, decoded.sed);
+    TEST_ASSERT_EQUAL(0, decoded.rs);
+    TEST_ASSERT_EQUAL(6, decoded.data_bytes);
+
+    MLX90393_DecodeStatus(MLX90393_STATUS_SM | MLX90393_STATUS_ERROR | MLX90393_STATUS_RS, &decoded);
+    TEST_ASSERT_EQUAL_HEX8(MLX90393_STATUS_SM, decoded.mode);
+    TEST_ASSERT_EQUAL(1, decoded.error);
+    TEST_ASSERT_EQUAL(1, decoded.rs);
+    TEST_ASSERT_EQUAL(2, decoded.data_bytes);
+}
+
+void test_MLX90393_Recovery_DisabledReportsResetOnly(void){
+    uint8_t status;
+    MLX90393_SimGlitch(&sim);
+    MLX90393_NOP(&fake_mlx, &status);
+    TEST_ASSERT_BITS_HIGH(MLX90393_STATUS_RS, status);
+    TEST_ASSERT_EQUAL_HEX16(0x007C, sim.regs[MLX90393_REG_CONF1]); //Still the non-volatile contents
+}
+
+void test_MLX90393_Recovery_ReappliesSettingsAfterReset(void){
+    float xyz[3];
+    uint16_t conf1 = sim.regs[MLX90393_REG_CONF1];
+    uint16_t conf3 = sim.regs[MLX90393_REG_CONF3];
+    fake_mlx.recovery = MLX90393_RECOVER_RESET;
+    sim.field[2] = 40.0f;
+
+    MLX90393_SimGlitch(&sim);
+    TEST_ASSERT_EQUAL(0, MLX90393_readXYZ(&fake_mlx, xyz));
+
+    TEST_ASSERT_EQUAL_HEX16(conf1, sim.regs[MLX90393_REG_CONF1]);
+    TEST_ASSERT_EQUAL_HEX16(conf3, sim.regs[MLX90393_REG_CONF3]);
+    TEST_ASSERT_FLOAT_WITHIN(0.6f, 40.0f, xyz[2]);
+}
+
+void test_MLX90393_Recovery_RestartsBurstStreaming(void){
+    uint8_t status;
+    mlx_sample_t buffer[4];
+    mlx_sample_t sample;
+    mlx_ring_t ring;
+    mlx_stream_t stream;
+    fake_mlx.recovery = MLX90393_RECOVER_RESET;
+    MLX90393_RingInit(&ring, buffer, 4);
+    MLX90393_StreamInit(&stream, &fake_mlx, &ring);
+    TEST_ASSERT_EQUAL(0, MLX90393_StreamStart(&stream));
+    MLX90393_SimUdelay(MLX90393_GetTconv_us(&fake_mlx));
+    TEST_ASSERT_EQUAL(0, MLX90393_StreamPoll(&stream));
+
+    MLX90393_SimGlitch(&sim);
+    MLX90393_SimUdelay(MLX90393_GetTconv_us(&fake_mlx));
+    TEST_ASSERT_EQUAL(MLX90393_AGAIN, MLX90393_StreamPoll(&stream)); //Recovered, conversion restarted
+    TEST_ASSERT_EQUAL_HEX8(MLX90393_STATUS_BURST, sim.mode);
+
+    MLX90393_SimUdelay(MLX90393_GetTconv_us(&fake_mlx));
+    TEST_ASSERT_EQUAL(0, MLX90393_StreamPoll(&stream));
+    TEST_ASSERT_EQUAL(2, MLX90393_RingCount(&ring));
+    MLX90393_RingPop(&ring, &sample);
+    TEST_ASSERT_EQUAL_HEX8(MLX90393_STATUS_BURST, sample.status & ~MLX90393_STATUS_D);
+
+    MLX90393_StreamFinish(&stream);
+    MLX90393_SimGlitch(&sim);
+    MLX90393_NOP(&fake_mlx, &status);
+    TEST_ASSERT_EQUAL_HEX8(0x00, sim.mode); //Not restarted once stopped
+}
+
+void test_MLX90393_Recovery_RetriesOnSingleErrorDetection(void){
+    uint8_t status;
+    uint8_t data[2];
+    fake_mlx.recovery = MLX90393_RECOVER_SED;
+    sim.sed_next = 1;
+    uint32_t before = sim.transactions;
+
+    TEST_ASSERT_EQUAL(0, MLX90393_RR(&fake_mlx, &status, MLX90393_REG_CONF3, data));
+    TEST_ASSERT_EQUAL_HEX8(0x00, status);
+    TEST_ASSERT_EQUAL(4, sim.transactions - before);
+
+    sim.sed_next = 2; //Retried once only
+    MLX90393_NOP(&fake_mlx, &status);
+    TEST_ASSERT_EQUAL_HEX8(MLX90393_STATUS_SED, status);
+}
+
+void test_MLX90393_ReadXYZ_ReportsRejectedMeasurement(void){
+    uint8_t status;
+    float xyz[3];
+    MLX90393_SB(&fake_mlx, MLX90393_MAG_XYZ, &status);
+    TEST_ASSERT_EQUAL(MLX90393_MISMATCH, MLX90393_readXYZ(&fake_mlx, xyz));
+}
+
+void test_MLX90393_ApplySettings_ReportsRejectedWrite(void){
+    uint8_t status;
+    MLX90393_SB(&fake_mlx, MLX90393_MAG_XYZ, &status); //Memory commands are rejected in burst mode
+    settings.gain = MLX90393_GAIN_1X;
+    TEST_ASSERT_EQUAL(MLX90393_MISMATCH, MLX90393_ApplySettings(&fake_mlx, &settings));
+    TEST_ASSERT_EQUAL(0, fake_mlx.regs_valid & (1 << MLX90393_REG_CONF1));
+}
+
+void test_MLX90393_GetSettings_ReportsRejectedRead(void){
+    uint8_t status;
+    MLX90393_SB(&fake_mlx, MLX90393_MAG_XYZ, &status);
+    MLX90393_InvalidateRegisters(&fake_mlx); //Force GetSettings onto the bus
+    TEST_ASSERT_EQUAL(MLX90393_MISMATCH, MLX90393_GetSettings(&fake_mlx));
+    TEST_ASSERT_EQUAL(0, fake_mlx.regs_valid);
+}
@@ -0,0 +1,228 @@
+#include <string.h>
+#include <stdlib.h>
+#include "unity.h"
+#include "MLX90393.h"
+#include "MLX90393_stream.h"
+#include "mock_test_MLX90393.h"
+
+static mlx_i2c_t fake_mlx;
+static mlx_cfg_t fake_settings;
+static mlx_ring_t ring;
+static mlx_sample_t ring_storage[4];
+static mlx_stream_t stream;
+
+static uint8_t last_cmd;
+
+static int32_t cb_write(mlx_i2c_t *dev, uint8_t *buf, size_t len, int n){
+    last_cmd = buf[0];
+    return 0;
+}
+
+static int32_t cb_read_xyz(mlx_i2c_t *dev, uint8_t *data, size_t len, int n){
+    //Status + X = 100, Y = -100, Z = 200 counts
+    uint8_t frame[7] = {0x80, 0x00, 0x64, 0xFF, 0x9C, 0x00, 0xC8};
+    memcpy(data, frame, len);
+    return 0;
+}
+
+void setUp(void) {
+    mlx_cfg_t settings = {
+        .gain = MLX90393_GAIN_1X,
+        .resolution_x = MLX90393_RES_16,
+        .resolution_y = MLX90393_RES_16,
+        .resolution_z = MLX90393_RES_16,
+        .filter = MLX90393_FILTER_3,
+        .oversampling = MLX90393_OSR_2
+    };
+    fake_settings = settings;
+    fake_mlx.handle = NULL;
+    fake_mlx.settings = &fake_settings;
+    fake_mlx.write_function = write_function;
+    fake_mlx.read_function = read_function;
+    fake_mlx.mdelay = delay_function;
+    MLX90393_RingInit(&ring, ring_storage, 4);
+    MLX90393_StreamInit(&stream, &fake_mlx, &ring);
+    last_cmd = 0;
+}
+
+void tearDown(void) {
+}
+
+void test_MLX90393_RingInit_Returns1WhenCapacityNotPowerOf2(void){
+    mlx_ring_t r;
+    TEST_ASSERT_EQUAL(1, MLX90393_RingInit(&r, ring_storage, 3));
+    TEST_ASSERT_EQUAL(1, MLX90393_RingInit(&r, ring_storage, 0));
+    TEST_ASSERT_EQUAL(1, MLX90393_RingInit(NULL, ring_storage, 4));
+    TEST_ASSERT_EQUAL(0, MLX90393_RingInit(&r, ring_storage, 4));
+}
+
+void test_MLX90393_Ring_IsFifoAndReportsFullAndEmpty(void){
+    mlx_sample_t s = {0};
+    for(int i = 0; i < 4; i++){
+        s.xyz[0] = (float) i;
+        TEST_ASSERT_EQUAL(0, MLX90393_RingPush(&ring, &s));
+    }
+    TEST_ASSERT_EQUAL(MLX90393_AGAIN, MLX90393_RingPush(&ring, &s));
+    TEST_ASSERT_EQUAL(4, MLX90393_RingCount(&ring));
+
+    for(int i = 0; i < 4; i++){
+        TEST_ASSERT_EQUAL(0, MLX90393_RingPop(&ring, &s));
+        TEST_ASSERT_EQUAL_FLOAT((float) i, s.xyz[0]);
+    }
+    TEST_ASSERT_EQUAL(MLX90393_AGAIN, MLX90393_RingPop(&ring, &s));
+}
+
+static int32_t cb_read_ok(mlx_i2c_t *dev, uint8_t *data, size_t len, int n){
+    memset(data, 0, len);
+    return 0;
+}
+
+static int32_t cb_read_error(mlx_i2c_t *dev, uint8_t *data, size_t len, int n){
+    memset(data, 0, len);
+    data[0] = 0x10; //ERROR
+    return 0;
+}
+
+void test_MLX90393_StreamStart_SendsSBWithXYZ(void){
+    write_function_Stub(cb_write);
+    read_function_Stub(cb_read_ok);
+    TEST_ASSERT_EQUAL(0, MLX90393_StreamStart(&stream));
+    TEST_ASSERT_EQUAL_HEX8(0x1E, last_cmd);
+    TEST_ASSERT_EQUAL(1, stream.running);
+}
+
+void test_MLX90393_StreamStart_ReturnsMismatchWhenSBRejected(void){
+    write_function_Stub(cb_write);
+    read_function_Stub(cb_read_error);
+    TEST_ASSERT_EQUAL(MLX90393_MISMATCH, MLX90393_StreamStart(&stream));
+    TEST_ASSERT_EQUAL(0, stream.running);
+}
+
+void test_MLX90393_StreamPoll_Returns1WhenNotStarted(void){
+    TEST_ASSERT_EQUAL(1, MLX90393_StreamPoll(&stream));
+}
+
+void test_MLX90393_StreamPoll_OnlyIssuesRMAndPushesDecodedSample(void){
+    mlx_sample_t s;
+    stream.running = 1;
+    write_function_Stub(cb_write);
+    read_function_Stub(cb_read_xyz);
+
+    TEST_ASSERT_EQUAL(0, MLX90393_StreamPoll(&stream));
+    TEST_ASSERT_EQUAL_HEX8(0x4E, last_cmd);
+    TEST_ASSERT_EQUAL(0, MLX90393_RingPop(&ring, &s));
+    TEST_ASSERT_EQUAL_HEX8(0x80, s.status);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 100 * 0.161, s.xyz[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, -100 * 0.161, s.xyz[1]);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 200 * 0.294, s.xyz[2]);
+    TEST_ASSERT_EQUAL_FLOAT(0, s.t); //No T channel
+}
+
+void test_MLX90393_StreamPoll_CountsDroppedSamplesWhenRingFull(void){
+    stream.running = 1;
+    write_function_IgnoreAndReturn(0);
+    read_function_Stub(cb_read_xyz);
+
+    for(int i = 0; i < 4; i++){
+        TEST_ASSERT_EQUAL(0, MLX90393_StreamPoll(&stream));
+    }
+    TEST_ASSERT_EQUAL(MLX90393_AGAIN, MLX90393_StreamPoll(&stream));
+    TEST_ASSERT_EQUAL(1, stream.dropped);
+}
+
+void test_MLX90393_StreamRun_WaitsRoundedUpTconvBetweenReads(void){
+    stream.running = 1;
+    write_function_IgnoreAndReturn(0);
+    read_function_Stub(cb_read_xyz);
+    delay_function_Expect(9); //MLX90393_Tconv_LookUp[3][2] = 8.37
+    delay_function_Expect(9);
+
+    TEST_ASSERT_EQUAL(0, MLX90393_StreamRun(&stream, 2));
+    TEST_ASSERT_EQUAL(2, MLX90393_RingCount(&ring));
+}
+
+void test_MLX90393_StreamRun_WaitsExactTconvOfStreamedChannelsWithUdelay(void){
+    stream.running = 1;
+    stream.zyxt = MLX90393_MAG_XYZT;
+    fake_mlx.udelay = udelay_function;
+    write_function_IgnoreAndReturn(0);
+    read_function_Stub(cb_read_xyz);
+    udelay_function_Expect(8370 + 67 + 192); //XYZ + TCONVT
+
+    TEST_ASSERT_EQUAL(0, MLX90393_StreamRun(&stream, 1));
+    fake_mlx.udelay = NULL;
+}
+
+void test_MLX90393_StreamRun_FollowsBurstDataRate(void){
+    stream.running = 1;
+    fake_mlx.udelay = udelay_function;
+    fake_mlx.regs[MLX90393_REG_CONF2] = 5; //BURST_DATA_RATE = 5 -> 100 ms
+    fake_mlx.regs_valid = 1 << MLX90393_REG_CONF2;
+    write_function_IgnoreAndReturn(0);
+    read_function_Stub(cb_read_xyz);
+    udelay_function_Expect(100000);
+
+    TEST_ASSERT_EQUAL(0, MLX90393_StreamRun(&stream, 1));
+    fake_mlx.udelay = NULL;
+    fake_mlx.regs_valid = 0;
+}
+
+static int32_t cb_read_stale_once(mlx_i2c_t *dev, uint8_t *data, size_t len, int n){
+    cb_read_xyz(dev, data, len, n);
+    if(n == 0){
+        data[0] = 0x10; //No new conversion yet
+    }
+    return 0;
+}
+
+void test_MLX90393_StreamRun_CountsOnlyPushedSamples(void){
+    stream.running = 1;
+    write_function_IgnoreAndReturn(0);
+    read_function_Stub(cb_read_stale_once);
+    delay_function_Ignore();
+
+    TEST_ASSERT_EQUAL(0, MLX90393_StreamRun(&stream, 2));
+    TEST_ASSERT_EQUAL(2, MLX90393_RingCount(&ring));
+}
+
+void test_MLX90393_StreamRun_GivesUpWithoutNewData(void){
+    stream.running = 1;
+    write_function_IgnoreAndReturn(0);
+    read_function_Stub(cb_read_error);
+    delay_function_Ignore();
+
+    TEST_ASSERT_EQUAL(MLX90393_TIMEOUT, MLX90393_StreamRun(&stream, 1));
+    TEST_ASSERT_EQUAL(0, MLX90393_RingCount(&ring));
+}
+
+void test_MLX90393_StreamStop_OnlyClearsRunning(void){
+    stream.running = 1;
+    TEST_ASSERT_EQUAL(0, MLX90393_StreamStop(&stream)); //No bus mock armed: any transfer fails the test
+    TEST_ASSERT_EQUAL(0, stream.running);
+}
+
+void test_MLX90393_StreamRun_SendsEXOnceStopped(void){
+    stream.running = 1;
+    MLX90393_StreamStop(&stream);
+    write_function_Stub(cb_write);
+    read_function_Stub(cb_read_ok);
+
+    TEST_ASSERT_EQUAL(0, MLX90393_StreamRun(&stream, 0));
+    TEST_ASSERT_EQUAL_HEX8(0x80, last_cmd);
+}
+
+void test_MLX90393_StreamFinish_SendsEXAndStops(void){
+    stream.running = 1;
+    write_function_Stub(cb_write);
+    read_function_Stub(cb_read_ok);
+    TEST_ASSERT_EQUAL(0, MLX90393_StreamFinish(&stream));
+    TEST_ASSERT_EQUAL_HEX8(0x80, last_cmd);
+    TEST_ASSERT_EQUAL(0, stream.running);
+}
+
+void test_MLX90393_StreamFinish_ReturnsMismatchWhenEXRejected(void){
+    stream.running = 1;
+    write_function_Stub(cb_write);
+    read_function_Stub(cb_read_error);
+    TEST_ASSERT_EQUAL(MLX90393_MISMATCH, MLX90393_StreamFinish(&stream));
+}
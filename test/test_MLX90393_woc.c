@@ -0,0 +1,170 @@
+#include <string.h>
+#include <stdlib.h>
+#include "unity.h"
+#include "MLX90393.h"
+#include "MLX90393_woc.h"
+#include "mock_test_MLX90393.h"
+
+static mlx_i2c_t fake_mlx;
+static mlx_cfg_t fake_settings;
+static mlx_woc_t woc;
+
+static uint8_t written[16][4];
+static int write_count;
+static int events;
+static mlx_sample_t last_sample;
+static uint8_t reject; //SWOC and RM report ERROR
+
+static int32_t cb_write_log(mlx_i2c_t *dev, uint8_t *buf, size_t len, int n){
+    memcpy(written[write_count++], buf, len > 4 ? 4 : len);
+    return 0;
+}
+
+//RR echoes the shadow, RM returns X = 100, Y = 0, Z = -100 counts
+static int32_t cb_read(mlx_i2c_t *dev, uint8_t *data, size_t len, int n){
+    memset(data, 0, len);
+    if (len == 3){
+        int reg = written[write_count - 1][1] >> 2;
+        data[1] = dev->regs[reg] >> 8;
+        data[2] = dev->regs[reg] & 0xFF;
+    }
+    if (len == 7){
+        data[0] = 0x40;
+        data[2] = 0x64;
+        data[5] = 0xFF;
+        data[6] = 0x9C;
+    }
+    if (reject && (len == 1 || len == 7)){
+        data[0] |= 0x10;
+    }
+    return 0;
+}
+
+static void on_change(void *ctx, const mlx_sample_t *sample){
+    events++;
+    last_sample = *sample;
+}
+
+void setUp(void) {
+    mlx_cfg_t settings = {
+        .gain = MLX90393_GAIN_1X,
+        .resolution_x = MLX90393_RES_16,
+        .resolution_y = MLX90393_RES_16,
+        .resolution_z = MLX90393_RES_16,
+        .filter = MLX90393_FILTER_3,
+        .oversampling = MLX90393_OSR_2
+    };
+    fake_settings = settings;
+    memset(&fake_mlx, 0, sizeof(fake_mlx));
+    fake_mlx.settings = &fake_settings;
+    fake_mlx.write_function = write_function;
+    fake_mlx.read_function = read_function;
+    fake_mlx.mdelay = delay_function;
+    //Shadow in sync with the settings above
+    fake_mlx.regs[MLX90393_REG_CONF1] = 0x007C;
+    fake_mlx.regs[MLX90393_REG_CONF3] = 0x000E;
+    fake_mlx.regs_valid = (1 << MLX90393_NUM_REGS) - 1;
+
+    write_count = 0;
+    events = 0;
+    reject = 0;
+    MLX90393_WOCInit(&woc, &fake_mlx, drdy_function, on_change, NULL);
+}
+
+void tearDown(void) {
+}
+
+void test_MLX90393_WOCInit_Returns1WithoutCallback(void){
+    TEST_ASSERT_EQUAL(1, MLX90393_WOCInit(&woc, &fake_mlx, drdy_function, NULL, NULL));
+    TEST_ASSERT_EQUAL(1, MLX90393_WOCInit(&woc, NULL, drdy_function, on_change, NULL));
+}
+
+void test_MLX90393_WOCArm_ProgramsThresholdsInLSBAndStartsSWOC(void){
+    write_function_Stub(cb_write_log);
+    read_function_Stub(cb_read);
+
+    TEST_ASSERT_EQUAL(0, MLX90393_WOCArm(&woc, 16.1f, 29.4f, 0, 1));
+    TEST_ASSERT_EQUAL_HEX16(0x1380, fake_mlx.regs[MLX90393_REG_CONF2]); //WOC_DIFF, BURST_SEL = XYZ
+    TEST_ASSERT_EQUAL_HEX16(100, fake_mlx.regs[MLX90393_REG_WOXY_THRESHOLD]);
+    TEST_ASSERT_EQUAL_HEX16(100, fake_mlx.regs[MLX90393_REG_WOZ_THRESHOLD]);
+    TEST_ASSERT_EQUAL_HEX8(0x2E, written[write_count - 1][0]);
+    TEST_ASSERT_EQUAL(1, woc.armed);
+}
+
+void test_MLX90393_WOCArm_ConvertsXYThresholdWithTheFinerAxis(void){
+    write_function_Stub(cb_write_log);
+    read_function_Stub(cb_read);
+    fake_settings.resolution_x = MLX90393_RES_17; //0.322 uT/LSB, Y stays at 0.161 uT/LSB
+
+    TEST_ASSERT_EQUAL(0, MLX90393_WOCArm(&woc, 16.1f, 29.4f, 0, 1));
+    TEST_ASSERT_EQUAL_HEX16(100, fake_mlx.regs[MLX90393_REG_WOXY_THRESHOLD]); //16.1 uT on Y, 32.2 uT on X
+}
+
+void test_MLX90393_WOCArm_ReturnsMismatchWhenSWOCRejected(void){
+    write_function_Stub(cb_write_log);
+    read_function_Stub(cb_read);
+    reject = 1;
+
+    TEST_ASSERT_EQUAL(MLX90393_MISMATCH, MLX90393_WOCArm(&woc, 16.1f, 29.4f, 0, 1));
+    TEST_ASSERT_EQUAL(0, woc.armed);
+}
+
+void test_MLX90393_WOCService_Returns1WhenNotArmed(void){
+    TEST_ASSERT_EQUAL(1, MLX90393_WOCService(&woc));
+}
+
+void test_MLX90393_WOCService_NoBusTrafficWithoutEvent(void){
+    woc.armed = 1;
+    drdy_function_ExpectAndReturn(&fake_mlx, 0);
+    TEST_ASSERT_EQUAL(MLX90393_AGAIN, MLX90393_WOCService(&woc));
+    TEST_ASSERT_EQUAL(0, events);
+}
+
+void test_MLX90393_WOCService_ReadsAndDeliversOnDataReady(void){
+    woc.armed = 1;
+    drdy_function_ExpectAndReturn(&fake_mlx, 1);
+    write_function_Stub(cb_write_log);
+    read_function_Stub(cb_read);
+
+    TEST_ASSERT_EQUAL(0, MLX90393_WOCService(&woc));
+    TEST_ASSERT_EQUAL(1, events);
+    TEST_ASSERT_EQUAL_HEX8(0x4E, written[0][0]);
+    TEST_ASSERT_EQUAL_HEX8(0x40, last_sample.status);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 16.1, last_sample.xyz[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, -29.4, last_sample.xyz[2]);
+}
+
+void test_MLX90393_WOCService_HandlesNotifiedInterruptOnce(void){
+    woc.armed = 1;
+    woc.drdy = NULL;
+    write_function_Stub(cb_write_log);
+    read_function_Stub(cb_read);
+
+    MLX90393_WOCNotify(&woc);
+    TEST_ASSERT_EQUAL(0, MLX90393_WOCService(&woc));
+    TEST_ASSERT_EQUAL(MLX90393_AGAIN, MLX90393_WOCService(&woc));
+    TEST_ASSERT_EQUAL(1, woc.events);
+}
+
+void test_MLX90393_WOCService_IgnoresNotifyWithoutNewData(void){
+    woc.armed = 1;
+    woc.drdy = NULL;
+    write_function_Stub(cb_write_log);
+    read_function_Stub(cb_read);
+    reject = 1;
+
+    MLX90393_WOCNotify(&woc);
+    TEST_ASSERT_EQUAL(MLX90393_AGAIN, MLX90393_WOCService(&woc));
+    TEST_ASSERT_EQUAL(0, woc.events);
+    TEST_ASSERT_EQUAL(0, events);
+}
+
+void test_MLX90393_WOCDisarm_SendsEX(void){
+    woc.armed = 1;
+    write_function_Stub(cb_write_log);
+    read_function_Stub(cb_read);
+
+    TEST_ASSERT_EQUAL(0, MLX90393_WOCDisarm(&woc));
+    TEST_ASSERT_EQUAL_HEX8(0x80, written[0][0]);
+    TEST_ASSERT_EQUAL(0, woc.armed);
+}